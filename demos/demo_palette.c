@@ -5,6 +5,15 @@
 
 #include "grid_engine/grid_engine.h"
 
+void palette_loop_func(ge_grid_t* grid, void* user_data_, uint32_t time_ms)
+{
+  (void) grid;
+  // Cast the user data back to the right type
+  ge_palette_t* palette = (ge_palette_t*) user_data_;
+  // Cycle the palette, the grid is never touched, so only the palette colors are rebuilt
+  ge_palette_cycle(palette, &GE_PALETTE_INFERNO, 0, 256, time_ms / 20);
+}
+
 int main(void)
 {
   const size_t width = 256;
@@ -21,8 +30,8 @@ int main(void)
   ez_loop_data_t ez_loop_data = {
       .grid = grid,
       .palette = &palette,
-      .user_data = NULL,
-      .loop_func = NULL,
+      .user_data = &palette,
+      .loop_func = palette_loop_func,
       .event_func = NULL,
   };
   // RUN THE LOOP!
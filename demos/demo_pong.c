@@ -8,6 +8,7 @@
 #include <time.h>
 
 #include "grid_engine/grid_engine.h"
+#include "grid_engine/text.h"
 
 /*
  * It's assumed that the ball never moves more than one pixel per update. (This effectively caps the
@@ -310,23 +311,27 @@ typedef struct user_data {
   size_t player2_score;
   bool reset_ball;
   uint32_t last_reset_time_ms;
+  // Scores only change now and then, so they're drawn from a cache
+  ge_text_cache_t* text_cache;
 } user_data_t;
 
 void fade_grid(ge_grid_t* grid)
 {
-  for (size_t jj = 0; jj < ge_grid_get_height(grid); ++jj) {
-    for (size_t ii = 0; ii < ge_grid_get_width(grid); ++ii) {
-      const ge_coord_t coord = {ii, jj};
-      const uint8_t value = ge_grid_get_coord(grid, coord);
-      if (value >= VALUE_ON) {
-        ge_grid_set_coord(grid, coord, VALUE_FADE);
+  // Build the fade as a table once, so the whole grid is faded with one lookup per pixel
+  static uint8_t fade_lut[256];
+  static bool is_fade_lut_built = false;
+  if (!is_fade_lut_built) {
+    for (size_t ii = 0; ii < 256; ++ii) {
+      if (ii >= VALUE_ON) {
+        fade_lut[ii] = VALUE_FADE;
       }
       else {
-        const uint8_t fade_value = (value > VALUE_FADE_DELTA ? value - VALUE_FADE_DELTA : 0);
-        ge_grid_set_coord(grid, coord, fade_value);
+        fade_lut[ii] = (ii > VALUE_FADE_DELTA ? ii - VALUE_FADE_DELTA : 0);
       }
     }
+    is_fade_lut_built = true;
   }
+  ge_grid_apply_lut(grid, ge_grid_get_rect(grid), fade_lut, NULL);
 }
 
 void draw_horizontal_bumper(ge_grid_t* grid, size_t y, size_t width)
@@ -385,21 +390,12 @@ void draw_ball(ge_grid_t* grid, ge_coord_t ball_coord)
   ge_grid_set_coord_wrapped(grid, ball_coord, VALUE_ON);
 }
 
-void draw_score(ge_grid_t* grid, ge_coord_t score_coord, size_t score)
+void draw_score(ge_grid_t* grid, ge_text_cache_t* text_cache, ge_coord_t score_coord, size_t score)
 {
   static char score_str[10];
   // Cap the score at 99 for display purposes, and just do a rollover
   snprintf(score_str, 10, "%u", (unsigned int) (score % 100));
-  ge_coord_vec_t* const str_coord_vec = ge_glyph_get_str_coords(score_str, score_coord);
-  if (str_coord_vec == NULL) {
-    GE_LOG_ERROR("Failed to render score: %s", score_str);
-    return;
-  }
-  for (const ge_coord_t* glyph_coord = ge_coord_vec_cbegin(str_coord_vec);
-       glyph_coord < ge_coord_vec_cend(str_coord_vec); ++glyph_coord) {
-    ge_grid_set_coord_wrapped(grid, *glyph_coord, VALUE_FADE);
-  }
-  ge_coord_vec_free(str_coord_vec);
+  ge_text_cache_draw(text_cache, grid, score_str, score_coord, VALUE_FADE);
 }
 
 heading_t heading_apply_hit(heading_t heading, uint8_t value)
@@ -440,8 +436,10 @@ void process_grid(ge_grid_t* grid, user_data_t* user_data)
   draw_ball_bumper(grid, (ge_coord_t){width * 5 / 8, height * 3 / 8}, 3);
   draw_ball_bumper(grid, (ge_coord_t){width * 5 / 8, height * 5 / 8}, 3);
   // Draw the score board
-  draw_score(grid, (ge_coord_t){width * 2 / 8 - 8, height / 2 - 4}, user_data->player1_score);
-  draw_score(grid, (ge_coord_t){width * 6 / 8 - 8, height / 2 - 4}, user_data->player2_score);
+  draw_score(grid, user_data->text_cache, (ge_coord_t){width * 2 / 8 - 8, height / 2 - 4},
+             user_data->player1_score);
+  draw_score(grid, user_data->text_cache, (ge_coord_t){width * 6 / 8 - 8, height / 2 - 4},
+             user_data->player2_score);
 }
 
 void process_one_paddle(ge_grid_t* grid, user_data_t* user_data, bool is_player1)
@@ -627,6 +625,7 @@ int main(void)
       .player2_score = 0,
       .reset_ball = true,
       .last_reset_time_ms = 0,
+      .text_cache = ge_text_cache_create(4),
   };
   // The EZ loop data
   ez_loop_data_t ez_loop_data = {
@@ -638,6 +637,7 @@ int main(void)
   };
   // RUN THE LOOP!
   const int result = ge_ez_loop(&ez_loop_data);
+  ge_text_cache_free(user_data.text_cache);
   ge_grid_free(grid);
   return result;
 }
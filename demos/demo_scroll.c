@@ -75,6 +75,17 @@ void scroll_event_func(ge_grid_t* render_grid, void* user_data_, uint32_t time_m
              || event->keydown_data.keycode == GE_KEYCODE_D) {
       user_data->scroll_dir = GE_DIR_EAST;
     }
+    else if (event->keydown_data.keycode == GE_KEYCODE_Z
+             || event->keydown_data.keycode == GE_KEYCODE_X) {
+      // Zoom out or in, and keep the scroll position in bounds
+      const double zoom = ge_sc_view_get_zoom(user_data->view);
+      const bool zoom_out = (event->keydown_data.keycode == GE_KEYCODE_Z);
+      ge_sc_view_set_zoom(user_data->view, zoom_out ? zoom / 2.0 : zoom * 2.0);
+      const double max_scroll_x = ge_sc_view_get_max_x_abs_scroll(user_data->view);
+      const double max_scroll_y = ge_sc_view_get_max_y_abs_scroll(user_data->view);
+      user_data->scroll_x = user_data->scroll_x < max_scroll_x ? user_data->scroll_x : max_scroll_x;
+      user_data->scroll_y = user_data->scroll_y < max_scroll_y ? user_data->scroll_y : max_scroll_y;
+    }
   }
   else if (event->type == GE_EVENT_KEYUP) {
     if (event->keydown_data.keycode == GE_KEYCODE_F
@@ -0,0 +1,129 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "grid_engine/grid_engine.h"
+#include "grid_engine/stencil.h"
+
+// Spread the heat to the neighbors, and cool down a little each step
+const ge_stencil_t HEAT_STENCIL = {
+    .width = 3,
+    .height = 3,
+    .weight_arr = {1, 2, 1, 2, 4, 2, 1, 2, 1},
+    .shift = 4,
+    .offset = -1,
+};
+
+typedef struct user_data {
+  ge_grid_t* temp_grid;
+  ge_pool_t* pool;
+} user_data_t;
+
+double get_time_ms(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void naive_heat(const ge_grid_t* grid, ge_grid_t* temp_grid)
+{
+  // The same as the heat stencil, written as the usual loop over neighbors
+  const size_t width = ge_grid_get_width(grid);
+  const size_t height = ge_grid_get_height(grid);
+  for (size_t jj = 0; jj < height; ++jj) {
+    for (size_t ii = 0; ii < width; ++ii) {
+      int32_t sum = 0;
+      for (ptrdiff_t dy = -1; dy <= 1; ++dy) {
+        for (ptrdiff_t dx = -1; dx <= 1; ++dx) {
+          const ge_coord_t coord = ge_coord_wrap((ge_coord_t){ii + dx, jj + dy}, width, height);
+          const int32_t weight = HEAT_STENCIL.weight_arr[3 * (dy + 1) + (dx + 1)];
+          sum += weight * ge_grid_get_coord(grid, coord);
+        }
+      }
+      const int32_t value = ((sum + 8) >> 4) + HEAT_STENCIL.offset;
+      ge_grid_set_coord(temp_grid, (ge_coord_t){ii, jj}, value < 0 ? 0 : value);
+    }
+  }
+}
+
+void benchmark_heat(ge_pool_t* pool)
+{
+  const size_t width = 1920;
+  const size_t height = 1080;
+  const size_t num_steps = 10;
+  ge_grid_t* grid = ge_grid_create(width, height);
+  ge_grid_t* temp_grid = ge_grid_create(width, height);
+  for (size_t jj = 0; jj < height; ++jj) {
+    for (size_t ii = 0; ii < width; ++ii) {
+      ge_grid_set_coord(grid, (ge_coord_t){ii, jj}, rand() % 256);
+    }
+  }
+  double start_time_ms = get_time_ms();
+  for (size_t ii = 0; ii < num_steps; ++ii) {
+    naive_heat(grid, temp_grid);
+  }
+  const double naive_time_ms = (get_time_ms() - start_time_ms) / num_steps;
+  start_time_ms = get_time_ms();
+  for (size_t ii = 0; ii < num_steps; ++ii) {
+    ge_stencil_apply(&HEAT_STENCIL, grid, GE_STENCIL_EDGE_WRAP, 0, NULL, temp_grid);
+  }
+  const double stencil_time_ms = (get_time_ms() - start_time_ms) / num_steps;
+  start_time_ms = get_time_ms();
+  for (size_t ii = 0; ii < num_steps; ++ii) {
+    ge_stencil_apply(&HEAT_STENCIL, grid, GE_STENCIL_EDGE_WRAP, 0, pool, temp_grid);
+  }
+  const double pool_time_ms = (get_time_ms() - start_time_ms) / num_steps;
+  GE_LOG_INFO("Heat step on %zux%zu: naive %.2f ms, stencil %.2f ms, stencil with pool %.2f ms",
+              width, height, naive_time_ms, stencil_time_ms, pool_time_ms);
+  ge_grid_free(grid);
+  ge_grid_free(temp_grid);
+}
+
+void stencil_loop_func(ge_grid_t* grid, void* user_data_, uint32_t time_ms)
+{
+  (void) time_ms;
+  // Cast the user data back to the right type
+  user_data_t* user_data = (user_data_t*) user_data_;
+  // Drop some heat in random places, then let it spread
+  const size_t width = ge_grid_get_width(grid);
+  const size_t height = ge_grid_get_height(grid);
+  for (size_t ii = 0; ii < 4; ++ii) {
+    ge_grid_set_coord(grid, (ge_coord_t){rand() % width, rand() % height}, 255);
+  }
+  ge_stencil_apply(&HEAT_STENCIL, grid, GE_STENCIL_EDGE_WRAP, 0, user_data->pool,
+                   user_data->temp_grid);
+  ge_grid_copy_pixel_arr(grid, user_data->temp_grid);
+}
+
+int main(void)
+{
+  const size_t width = 200;
+  const size_t height = 100;
+  ge_grid_t* grid = ge_grid_create(width, height);
+  ge_palette_t palette = GE_PALETTE_INFERNO;
+  // User data to track state, etc
+  user_data_t user_data = {
+      .temp_grid = ge_grid_create(width, height),
+      .pool = ge_pool_create(0),
+  };
+  benchmark_heat(user_data.pool);
+  // The EZ loop data
+  ez_loop_data_t ez_loop_data = {
+      .grid = grid,
+      .palette = &palette,
+      .user_data = &user_data,
+      .loop_func = stencil_loop_func,
+      .event_func = NULL,
+  };
+  // RUN THE LOOP!
+  const int result = ge_ez_loop(&ez_loop_data);
+  ge_grid_free(grid);
+  ge_grid_free(user_data.temp_grid);
+  ge_pool_free(user_data.pool);
+  return result;
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_ASTAR_H_
+#define GE_ASTAR_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "grid_engine/coord.h"
+#include "grid_engine/coord_vec.h"
+#include "grid_engine/grid.h"
+#include "grid_engine/mz_grid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A* search state, which can be reused for any number of path queries. Nothing is cleared between
+ * queries, so the cost of a query depends only on the part of the grid it actually searches.
+ *
+ * On a plain grid, non-zero pixels are walkable and zero pixels are walls. With diagonals, a
+ * diagonal step is only allowed if both of the adjacent straight steps are walkable, so paths never
+ * cut corners. On a maze grid, steps follow the connections.
+ */
+typedef struct ge_astar ge_astar_t;
+
+ge_astar_t* ge_astar_create();
+void ge_astar_free(ge_astar_t* astar);
+
+/**
+ * Find the shortest path on a plain grid, from the start coord to the end coord.
+ *
+ * @param astar The search state.
+ * @param grid The grid, where non-zero pixels are walkable.
+ * @param start_coord The start of the path.
+ * @param end_coord The end of the path.
+ * @param use_diagonals Allow diagonal steps, i.e., 8-connectivity instead of 4-connectivity.
+ * @param path Output for the path, including the start and end coords.
+ * @return True if a path was found, otherwise false, e.g., if memory could not be allocated.
+ */
+bool ge_astar_find_path(ge_astar_t* astar, const ge_grid_t* grid, ge_coord_t start_coord,
+                        ge_coord_t end_coord, bool use_diagonals, ge_coord_vec_t* path);
+
+/**
+ * Works just like `ge_astar_find_path` with diagonals, but uses jump point search, which is much
+ * faster on mostly open grids. The path is the same length, but may take a different route.
+ */
+bool ge_astar_find_path_jps(ge_astar_t* astar, const ge_grid_t* grid, ge_coord_t start_coord,
+                            ge_coord_t end_coord, ge_coord_vec_t* path);
+
+/**
+ * Works just like `ge_astar_find_path`, but on a maze grid.
+ */
+bool ge_astar_find_path_mz(ge_astar_t* astar, const ge_mz_grid_t* grid, ge_coord_t start_coord,
+                           ge_coord_t end_coord, ge_coord_vec_t* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_ASTAR_H_
@@ -0,0 +1,72 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_BFS_H_
+#define GE_BFS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "grid_engine/coord.h"
+#include "grid_engine/mz_grid.h"
+#include "grid_engine/pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Multi-source breadth-first search, for finding the distance from every cell to the nearest of a
+ * set of seed coords, along with which seed is nearest.
+ *
+ * Each level of the search either expands the frontier outwards (top-down), or checks every
+ * unvisited cell for a neighbor in the frontier (bottom-up), whichever is less work. Large levels
+ * are split into tasks for the worker pool, if there is one. The search state is kept between
+ * runs, so it's cheap to run every frame.
+ */
+typedef struct ge_bfs ge_bfs_t;
+
+/**
+ * Returns true if the coord can be passed through.
+ */
+typedef bool (*ge_bfs_pass_func_t)(ge_coord_t coord, void* user_data);
+
+/**
+ * Create the search state. The pool is optional, and is not owned by the search state.
+ */
+ge_bfs_t* ge_bfs_create(ge_pool_t* pool);
+void ge_bfs_free(ge_bfs_t* bfs);
+
+/**
+ * Find the distance from every cell to the nearest seed coord, moving in four directions through
+ * passable cells. Unreachable cells get a distance and label of `SIZE_MAX`, and impassable seeds
+ * are ignored.
+ *
+ * @param bfs The search state.
+ * @param width The width of the area to search.
+ * @param height The height of the area to search.
+ * @param pass_func The function to check if a coord is passable, called once for each coord.
+ * @param user_data User data passed to the function.
+ * @param seed_coords The coords to find distances from.
+ * @param num_seeds The number of seed coords.
+ * @param dist_arr Output distances, which must have room for `width * height` elements.
+ * @param label_arr Output index of the nearest seed, or `NULL`. Ties are broken arbitrarily.
+ * @return False if memory could not be allocated, otherwise true.
+ */
+bool ge_bfs_run(ge_bfs_t* bfs, size_t width, size_t height, ge_bfs_pass_func_t pass_func,
+                void* user_data, const ge_coord_t* seed_coords, size_t num_seeds, size_t* dist_arr,
+                size_t* label_arr);
+
+/**
+ * Works just like `ge_bfs_run`, but following the connections of a maze grid.
+ */
+bool ge_bfs_run_mz(ge_bfs_t* bfs, const ge_mz_grid_t* grid, const ge_coord_t* seed_coords,
+                   size_t num_seeds, size_t* dist_arr, size_t* label_arr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_BFS_H_
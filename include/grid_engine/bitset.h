@@ -8,6 +8,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,6 +16,14 @@ extern "C" {
 
 typedef struct ge_bitset ge_bitset_t;
 
+/**
+ * A single 64-bit value of the bitset, where bit N corresponds to `base_index + N`.
+ */
+typedef struct ge_bitset_value {
+  size_t base_index;
+  uint64_t value;
+} ge_bitset_value_t;
+
 extern const size_t GE_BITSET_SEARCH_INIT;
 
 ge_bitset_t* ge_bitset_create(size_t size);
@@ -25,6 +34,57 @@ size_t ge_bitset_search(const ge_bitset_t* bitset, size_t start_index);
 bool ge_bitset_has_none(const ge_bitset_t* bitset);
 bool ge_bitset_has_any(const ge_bitset_t* bitset);
 bool ge_bitset_has_all(const ge_bitset_t* bitset);
+size_t ge_bitset_get_size(const ge_bitset_t* bitset);
+size_t ge_bitset_count(const ge_bitset_t* bitset);
+
+/**
+ * Set or clear all bits from `begin_index` (inclusive) to `end_index` (exclusive).
+ */
+void ge_bitset_set_range(ge_bitset_t* bitset, size_t begin_index, size_t end_index, bool value);
+
+/**
+ * Get the number of set bits before `index`, which may be equal to the size of the set.
+ */
+size_t ge_bitset_rank(const ge_bitset_t* bitset, size_t index);
+
+/**
+ * Get the index of the set bit with the given rank (starting from zero), or
+ * `GE_BITSET_SEARCH_INIT` if there are not enough set bits.
+ */
+size_t ge_bitset_select(const ge_bitset_t* bitset, size_t rank);
+
+// In-place set operations, where both bitsets must be the same size
+void ge_bitset_copy(ge_bitset_t* bitset, const ge_bitset_t* other);
+void ge_bitset_and(ge_bitset_t* bitset, const ge_bitset_t* other);
+void ge_bitset_or(ge_bitset_t* bitset, const ge_bitset_t* other);
+void ge_bitset_xor(ge_bitset_t* bitset, const ge_bitset_t* other);
+void ge_bitset_andnot(ge_bitset_t* bitset, const ge_bitset_t* other);
+
+/**
+ * Used to iterate through the non-zero values of the set, 64 bits at a time. If the base index of
+ * `bitset_value` is `GE_BITSET_SEARCH_INIT`, this function will get the first non-zero value.
+ * Zeroed values are skipped using the summary levels of the set. Intended to be used with a while
+ * loop, similarly to this:
+ *
+ * ```
+ * ge_bitset_value_t bitset_value = {GE_BITSET_SEARCH_INIT, 0};
+ * while (ge_bitset_next_value(bitset, &bitset_value)) {
+ *   ...
+ * }
+ * ```
+ *
+ * @param bitset The bitset.
+ *
+ * @param bitset_value The previous value, which is updated to the next value.
+ *
+ * @return True if there was a next value, otherwise false.
+ */
+bool ge_bitset_next_value(const ge_bitset_t* bitset, ge_bitset_value_t* bitset_value);
+
+// Allow easier use of the function above using a macro
+#define GE_FOR_BITSET_VALUES(BITSET_VALUE, BITSET)                 \
+  for (ge_bitset_value_t BITSET_VALUE = {GE_BITSET_SEARCH_INIT, 0}; \
+       ge_bitset_next_value(BITSET, &BITSET_VALUE);)
 
 #ifdef __cplusplus
 }
@@ -6,6 +6,8 @@
 #ifndef GE_GLYPHS_H_
 #define GE_GLYPHS_H_
 
+#include <stdint.h>
+
 #include "grid_engine/coord.h"
 #include "grid_engine/coord_vec.h"
 
@@ -76,6 +78,12 @@ extern const ge_coord_t GE_GLYPH_7[20];
 extern const ge_coord_t GE_GLYPH_8[28];
 extern const ge_coord_t GE_GLYPH_9[24];
 
+/**
+ * Glyph bitmaps, indexed by character, with bit `8 * y + x` set for each lit pixel. Characters
+ * without a glyph are zero, so they draw as blanks.
+ */
+extern const uint64_t GE_GLYPH_BITMAP_ARR[128];
+
 /**
  * Get some glyph coords, if they exist.
  *
@@ -89,6 +97,11 @@ bool ge_glyph_get(char glyph, const ge_coord_t** glyph_coords, size_t* glyph_siz
  */
 ge_coord_vec_t* ge_glyph_get_str_coords(const char* str, ge_coord_t start_coord);
 
+/**
+ * Get the bitmap of a glyph, from `GE_GLYPH_BITMAP_ARR`, or zero if the glyph doesn't exist.
+ */
+uint64_t ge_glyph_get_bitmap(char glyph);
+
 #ifdef __cplusplus
 }
 #endif
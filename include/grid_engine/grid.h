@@ -11,6 +11,7 @@
 
 #include "grid_engine/coord.h"
 #include "grid_engine/nbrs.h"
+#include "grid_engine/pool.h"
 #include "grid_engine/rect.h"
 
 #ifdef __cplusplus
@@ -18,8 +19,12 @@ extern "C" {
 #endif
 
 typedef struct ge_grid ge_grid_t;
+typedef void (*ge_grid_free_func_t)(void* user_data);
 
 ge_grid_t* ge_grid_create(size_t width, size_t height);
+// Wrap existing pixels, like a mapped file, which are released by `free_func`, or `free` if `NULL`
+ge_grid_t* ge_grid_create_from_pixel_arr(size_t width, size_t height, uint8_t* pixel_arr,
+                                         ge_grid_free_func_t free_func, void* user_data);
 void ge_grid_free(ge_grid_t* grid);
 size_t ge_grid_get_width(const ge_grid_t* grid);
 size_t ge_grid_get_height(const ge_grid_t* grid);
@@ -28,6 +33,8 @@ const uint8_t* ge_grid_get_pixel_arr(const ge_grid_t* grid);
 uint8_t* ge_grid_get_pixel_arr_mut(ge_grid_t* grid);
 void ge_grid_copy_pixel_arr(ge_grid_t* grid, const ge_grid_t* other);
 void ge_grid_clear_pixel_arr(ge_grid_t* grid);
+// The generation changes whenever the grid is modified, or the mutable pixel array is taken
+uint64_t ge_grid_get_generation(const ge_grid_t* grid);
 bool ge_grid_has_coord(const ge_grid_t* grid, ge_coord_t coord);
 uint8_t ge_grid_get_coord(const ge_grid_t* grid, ge_coord_t coord);
 void ge_grid_set_coord(ge_grid_t* grid, ge_coord_t coord, uint8_t value);
@@ -42,6 +49,24 @@ void ge_grid_scale_blit(ge_grid_t* grid, const ge_grid_t* blit_grid, ge_coord_t
 void ge_grid_scale_blit_rect(ge_grid_t* grid, const ge_grid_t* blit_grid, ge_rect_t blit_rect,
                              ge_coord_t coord, size_t pixel_multiplier);
 
+/*
+ * Per-pixel value transforms, for effects like fading. Each transform changes every pixel in the
+ * rect, which must be within the grid. Big rects are split into bands of rows on the pool, if there
+ * is one. The loops are branchless, so compilers can vectorize them, except for the table lookups.
+ */
+
+// Replace each pixel value with `lut[value]`
+void ge_grid_apply_lut(ge_grid_t* grid, ge_rect_t rect, const uint8_t lut[256], ge_pool_t* pool);
+// Add to each pixel value, stopping at 255
+void ge_grid_add_sat(ge_grid_t* grid, ge_rect_t rect, uint8_t value, ge_pool_t* pool);
+// Subtract from each pixel value, stopping at 0
+void ge_grid_sub_sat(ge_grid_t* grid, ge_rect_t rect, uint8_t value, ge_pool_t* pool);
+// Multiply each pixel value by a non-negative factor, rounding, and stopping at 255
+void ge_grid_scale_sat(ge_grid_t* grid, ge_rect_t rect, double factor, ge_pool_t* pool);
+// Set pixel values below the threshold to the low value, and everything else to the high value
+void ge_grid_threshold(ge_grid_t* grid, ge_rect_t rect, uint8_t threshold, uint8_t low_value,
+                       uint8_t high_value, ge_pool_t* pool);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,7 +12,9 @@
 #include "grid_engine/glyphs.h"
 #include "grid_engine/img.h"
 #include "grid_engine/log.h"
+#include "grid_engine/pool.h"
 #include "grid_engine/sc_view.h"
+#include "grid_engine/sp_bitset.h"
 #include "grid_engine/utils.h"
 
 #endif  // GE_GRID_ENGINE_H_
@@ -0,0 +1,84 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_HISTORY_H_
+#define GE_HISTORY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "grid_engine/grid.h"
+#include "grid_engine/rect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A history of snapshots of a grid, for undo and rewind.
+ *
+ * The grid is split into square tiles. Snapshots share tiles which haven't changed, so each
+ * snapshot after the first only stores the tiles which are different from the snapshot before it,
+ * plus one pointer for each tile. Tiles are freed when no snapshot uses them anymore.
+ *
+ * Snapshots are numbered from zero, the oldest, to `ge_history_get_num_snapshots - 1`, the newest.
+ * When the history is full, taking a snapshot drops the oldest one.
+ *
+ * Changed tiles are found by comparing them with the newest snapshot. Marking the rects which
+ * changed limits the comparison to those tiles. If the grid changes without any rects being
+ * marked, every tile is compared. Like the mipmap, either mark every change, or none of them.
+ */
+typedef struct ge_history ge_history_t;
+
+/**
+ * Create a history for the grid, which is not owned, and must outlive the history. There are no
+ * snapshots until the first is taken.
+ *
+ * @param grid The grid, which snapshots are taken of, and restored to.
+ * @param tile_size The width and height of each tile, which must be greater than zero.
+ * @param max_num_snapshots The most snapshots kept, which must be greater than zero.
+ * @return The newly created history, or `NULL` if memory could not be allocated.
+ */
+ge_history_t* ge_history_create(ge_grid_t* grid, size_t tile_size, size_t max_num_snapshots);
+void ge_history_free(ge_history_t* history);
+size_t ge_history_get_num_snapshots(const ge_history_t* history);
+size_t ge_history_get_max_num_snapshots(const ge_history_t* history);
+
+/**
+ * Get the number of tiles stored by all the snapshots, counting shared tiles once. This is what
+ * the history costs in memory, apart from the tile pointers.
+ */
+size_t ge_history_get_num_stored_tiles(const ge_history_t* history);
+
+/**
+ * Mark a rect of the grid as changed, so its tiles are compared on the next snapshot.
+ */
+void ge_history_mark_dirty(ge_history_t* history, ge_rect_t rect);
+
+/**
+ * Take a snapshot of the grid, as the newest snapshot.
+ *
+ * @return False if memory could not be allocated, and the history is unchanged, otherwise true.
+ */
+bool ge_history_snapshot(ge_history_t* history);
+
+/**
+ * Restore the grid to a snapshot. The snapshot and the ones after it are kept, so the grid can be
+ * restored again, back and forth. If the grid hasn't changed since the last snapshot or restore,
+ * only the tiles which are different between the two snapshots are copied.
+ */
+void ge_history_restore(ge_history_t* history, size_t snapshot_index);
+
+/**
+ * Drop the newest snapshots, keeping only the given number of snapshots, like after undoing and
+ * then making a new change. Does nothing if there are fewer snapshots.
+ */
+void ge_history_truncate(ge_history_t* history, size_t num_snapshots);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_HISTORY_H_
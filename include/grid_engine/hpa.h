@@ -0,0 +1,84 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_HPA_H_
+#define GE_HPA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "grid_engine/coord.h"
+#include "grid_engine/coord_vec.h"
+#include "grid_engine/grid.h"
+#include "grid_engine/mz_grid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Hierarchical pathfinding (HPA*) over a plain grid or a maze grid.
+ *
+ * The grid is split into square clusters. Entrances between neighboring clusters become nodes of
+ * an abstract graph, along with the distances between nodes within each cluster. Path queries
+ * search the abstract graph, giving a list of waypoints, and each segment between waypoints can
+ * be refined into individual steps as needed.
+ *
+ * On a plain grid, non-zero pixels are walkable, and steps are in four directions. On a maze grid,
+ * steps follow the connections. The grid is not owned, and must outlive the HPA* state. Whenever
+ * the grid changes, `ge_hpa_update_coord` must be called, which only rebuilds affected clusters.
+ * Paths are close to optimal, but not always optimal.
+ */
+typedef struct ge_hpa ge_hpa_t;
+
+ge_hpa_t* ge_hpa_create(const ge_grid_t* grid, size_t cluster_size);
+ge_hpa_t* ge_hpa_create_mz(const ge_mz_grid_t* grid, size_t cluster_size);
+void ge_hpa_free(ge_hpa_t* hpa);
+size_t ge_hpa_get_cluster_size(const ge_hpa_t* hpa);
+
+/**
+ * Mark the clusters around a coord to be rebuilt, after the coord was changed in the grid.
+ */
+void ge_hpa_update_coord(ge_hpa_t* hpa, ge_coord_t coord);
+
+/**
+ * Rebuild all clusters marked by `ge_hpa_update_coord`. This happens automatically before each
+ * query, but can be done ahead of time to keep queries fast.
+ *
+ * @return False if memory could not be allocated, otherwise true.
+ */
+bool ge_hpa_rebuild(ge_hpa_t* hpa);
+
+/**
+ * Find a path through the abstract graph, from the start coord to the end coord.
+ *
+ * @param hpa The HPA* state.
+ * @param start_coord The start of the path.
+ * @param end_coord The end of the path.
+ * @param waypoints Output for the waypoints, including the start and end coords. Consecutive
+ * waypoints are either in the same cluster, or are neighbors across the edge of a cluster.
+ * @return True if a path was found, otherwise false, e.g., if memory could not be allocated.
+ */
+bool ge_hpa_find_path(ge_hpa_t* hpa, ge_coord_t start_coord, ge_coord_t end_coord,
+                      ge_coord_vec_t* waypoints);
+
+/**
+ * Refine the segment between waypoint `segment_index` and the next waypoint into single steps.
+ *
+ * @return True if the segment was refined, otherwise false, e.g., if the grid has changed.
+ */
+bool ge_hpa_refine_segment(ge_hpa_t* hpa, const ge_coord_vec_t* waypoints, size_t segment_index,
+                           ge_coord_vec_t* path);
+
+/**
+ * Refine all the waypoints into single steps, including the start and end coords.
+ */
+bool ge_hpa_refine_path(ge_hpa_t* hpa, const ge_coord_vec_t* waypoints, ge_coord_vec_t* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_HPA_H_
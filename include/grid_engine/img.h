@@ -6,14 +6,123 @@
 #ifndef GE_IMG_H_
 #define GE_IMG_H_
 
+#include <stdbool.h>
+
 #include "grid_engine/grid.h"
+#include "grid_engine/palette.h"
+#include "grid_engine/pool.h"
+#include "grid_engine/quant.h"
+#include "grid_engine/tl_grid.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * File formats for saving grids.
+ */
+typedef enum ge_img_format {
+  // An 8-bit indexed color PNG, which keeps the exact pixel values along with the palette
+  GE_IMG_FORMAT_PNG = 0,
+  // The raw grid format, see `raw.h`, which has no palette
+  GE_IMG_FORMAT_RAW,
+} ge_img_format_t;
+
+/**
+ * Saves grids on a background thread, so saving doesn't stall the caller.
+ *
+ * Each save takes a snapshot of the grid, so the grid can keep changing while it's being saved.
+ * The snapshot is reused between saves, so regular saves of the same grid don't allocate.
+ */
+typedef struct ge_img_saver ge_img_saver_t;
+
+/**
+ * Load an image as a grid, converting it to grayscale, and ignoring alpha.
+ *
+ * Images are converted a strip of rows at a time. Binary PGM and PPM files are also read a strip at
+ * a time, so only the grid and one strip are ever in memory. Other formats are decoded all at once
+ * by SDL_image first.
+ *
+ * @return The loaded grid, or `NULL` if the image couldn't be loaded.
+ */
 ge_grid_t* ge_img_load(const char* filename);
 
+/**
+ * Load an image, like `ge_img_load`, but convert big images to grayscale on a worker pool.
+ *
+ * @param filename The image file.
+ * @param pool The pool to convert rows on, or `NULL` to convert on the calling thread.
+ * @return The loaded grid, or `NULL` if the image couldn't be loaded.
+ */
+ge_grid_t* ge_img_load_with_pool(const char* filename, ge_pool_t* pool);
+
+/**
+ * Load an image into a new tiled grid, converting it to grayscale like `ge_img_load`. The image is
+ * converted one row of tiles at a time, so the whole grid is never in memory.
+ *
+ * @param filename The image file.
+ * @param tl_filename The backing file for the tiled grid, which is replaced if it exists.
+ * @param tile_size The width and height of each tile, which must be greater than zero.
+ * @param num_cached_tiles The number of tiles kept in memory, which must be greater than zero.
+ * @param pool The pool to convert rows on, or `NULL` to convert on the calling thread.
+ * @return The loaded tiled grid, or `NULL` if the image couldn't be loaded.
+ */
+ge_tl_grid_t* ge_img_load_tl(const char* filename, const char* tl_filename, size_t tile_size,
+                             size_t num_cached_tiles, ge_pool_t* pool);
+
+/**
+ * Load an image, keeping its color, by building a palette for the image and mapping each pixel to
+ * a palette entry. See `ge_quant_build_palette` and `ge_quant_map`.
+ *
+ * @param filename The image file.
+ * @param dither How to dither the pixels.
+ * @param pool The pool to quantize on, or `NULL` to quantize on the calling thread.
+ * @param palette The output palette, which the grid must be drawn with.
+ * @return The loaded grid, or `NULL` if the image couldn't be loaded.
+ */
+ge_grid_t* ge_img_load_color(const char* filename, ge_quant_dither_t dither, ge_pool_t* pool,
+                             ge_palette_t* palette);
+
+/**
+ * Save a grid as an image.
+ *
+ * @param grid The grid to save.
+ * @param filename The image file, which is replaced if it exists.
+ * @param format The format to save in.
+ * @param palette The palette for PNGs, or `NULL` for grayscale.
+ * @return False if the image couldn't be saved, otherwise true.
+ */
+bool ge_img_save(const ge_grid_t* grid, const char* filename, ge_img_format_t format,
+                 const ge_palette_t* palette);
+
+ge_img_saver_t* ge_img_saver_create(void);
+
+/**
+ * Free the saver, waiting for any save in progress to finish first.
+ */
+void ge_img_saver_free(ge_img_saver_t* saver);
+
+/**
+ * Start saving a grid in the background, just like `ge_img_save`. If the previous save is still in
+ * progress, this waits for it to finish first. Failed saves are logged.
+ *
+ * @return False if the save couldn't be started, otherwise true.
+ */
+bool ge_img_saver_save(ge_img_saver_t* saver, const ge_grid_t* grid, const char* filename,
+                       ge_img_format_t format, const ge_palette_t* palette);
+
+/**
+ * Check if a save is still in progress, without waiting.
+ */
+bool ge_img_saver_is_busy(ge_img_saver_t* saver);
+
+/**
+ * Wait for the save in progress, if there is one, to finish.
+ *
+ * @return False if the last save failed, otherwise true.
+ */
+bool ge_img_saver_wait(ge_img_saver_t* saver);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,69 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_MIPMAP_H_
+#define GE_MIPMAP_H_
+
+#include <stddef.h>
+
+#include "grid_engine/grid.h"
+#include "grid_engine/rect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * How each pixel of a smaller level is chosen from the 2x2 pixels below it. Max keeps sparse
+ * details visible, mean blends them, and mode keeps the most common value.
+ */
+typedef enum ge_mipmap_mode {
+  GE_MIPMAP_MODE_MAX = 0,
+  GE_MIPMAP_MODE_MEAN,
+  GE_MIPMAP_MODE_MODE,
+} ge_mipmap_mode_t;
+
+/**
+ * A pyramid of downsampled copies of a source grid, each half the size of the last, for drawing
+ * the source zoomed out. Level 0 is the source grid itself.
+ *
+ * Levels are built on the first update. After that, only the regions marked dirty are rebuilt. If
+ * the source grid changes without any regions being marked, the whole pyramid is rebuilt.
+ */
+typedef struct ge_mipmap ge_mipmap_t;
+
+/**
+ * Create a mipmap for the source grid, which is not owned, and must outlive the mipmap.
+ */
+ge_mipmap_t* ge_mipmap_create(const ge_grid_t* source_grid, ge_mipmap_mode_t mode);
+void ge_mipmap_free(ge_mipmap_t* mipmap);
+ge_mipmap_mode_t ge_mipmap_get_mode(const ge_mipmap_t* mipmap);
+size_t ge_mipmap_get_num_levels(const ge_mipmap_t* mipmap);
+
+/**
+ * Get a level of the pyramid, which is only valid after an update.
+ */
+const ge_grid_t* ge_mipmap_get_level(const ge_mipmap_t* mipmap, size_t level);
+
+/**
+ * Change how levels are downsampled. The whole pyramid is rebuilt on the next update.
+ */
+void ge_mipmap_set_mode(ge_mipmap_t* mipmap, ge_mipmap_mode_t mode);
+
+/**
+ * Mark a rect of the source grid as changed, so it will be rebuilt on the next update.
+ */
+void ge_mipmap_mark_dirty(ge_mipmap_t* mipmap, ge_rect_t rect);
+
+/**
+ * Bring the levels up to date with the source grid.
+ */
+void ge_mipmap_update(ge_mipmap_t* mipmap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_MIPMAP_H_
@@ -0,0 +1,53 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_MZ_GEN_H_
+#define GE_MZ_GEN_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid_engine/mz_grid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Maze generators. Each one removes all existing connections from the grid, then connects every
+ * cell into a perfect maze, i.e., there is exactly one path between any two cells. Path bits are
+ * left untouched. The same seed always generates the same maze.
+ *
+ * @return False if memory could not be allocated, in which case the maze is incomplete.
+ */
+bool ge_mz_gen_backtracker(ge_mz_grid_t* grid, uint64_t seed);
+bool ge_mz_gen_kruskal(ge_mz_grid_t* grid, uint64_t seed);
+bool ge_mz_gen_wilson(ge_mz_grid_t* grid, uint64_t seed);
+bool ge_mz_gen_eller(ge_mz_grid_t* grid, uint64_t seed);
+
+/**
+ * Streaming maze generation, using Eller's algorithm. Rows are generated one at a time from top
+ * to bottom, using memory proportional to the width only, so mazes can be arbitrarily tall.
+ */
+typedef struct ge_mz_eller ge_mz_eller_t;
+
+ge_mz_eller_t* ge_mz_eller_create(size_t width, uint64_t seed);
+void ge_mz_eller_free(ge_mz_eller_t* eller);
+size_t ge_mz_eller_get_width(const ge_mz_eller_t* eller);
+size_t ge_mz_eller_get_num_rows(const ge_mz_eller_t* eller);
+
+/**
+ * Generate the next row of the maze, writing the connection bits of each cell to `row_values`,
+ * which must have room for `width` elements. Connections to the north match the south connections
+ * of the previous row. The last row closes the maze, and the generator starts over after it.
+ */
+void ge_mz_eller_next_row(ge_mz_eller_t* eller, bool is_last_row, uint8_t* row_values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_MZ_GEN_H_
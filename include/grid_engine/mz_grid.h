@@ -83,6 +83,55 @@ ge_nbrs_t ge_mz_grid_get_nbrs_connected(const ge_mz_grid_t* grid, ge_coord_t coo
 ge_coord_vec_t* ge_mz_grid_get_edge_coords(const ge_mz_grid_t* grid);
 ge_coord_t ge_mz_grid_next_edge_coord(const ge_mz_grid_t* grid, ge_coord_t start_coord);
 
+/**
+ * Enable or disable deferred rendering. While deferred, setting coords only marks rows of the
+ * render grid as dirty, which is much faster when making lots of changes, e.g., during maze
+ * generation. Dirty rows are rendered by `ge_mz_grid_update_render_grid`, which is also called by
+ * `ge_mz_grid_get_render_grid` and when disabling deferred rendering.
+ */
+void ge_mz_grid_set_render_deferred(ge_mz_grid_t* grid, bool render_deferred);
+bool ge_mz_grid_is_render_deferred(const ge_mz_grid_t* grid);
+void ge_mz_grid_update_render_grid(ge_mz_grid_t* grid);
+
+/**
+ * The cost of moving from a cell to a connected neighboring cell, for weighted distances.
+ */
+typedef size_t (*ge_mz_weight_func_t)(ge_coord_t coord, ge_coord_t nbr_coord, void* user_data);
+
+/**
+ * Find the distance from the start coord to every cell of the maze, following the connections.
+ * Every connection has a distance of one. Unreachable cells get a distance of `SIZE_MAX`.
+ *
+ * @param grid The maze grid.
+ * @param start_coord The coord to find distances from.
+ * @param dist_arr The output distances, which must have room for `width * height` elements.
+ * @return False if memory could not be allocated, otherwise true.
+ */
+bool ge_mz_grid_get_distances(const ge_mz_grid_t* grid, ge_coord_t start_coord, size_t* dist_arr);
+
+/**
+ * Find the distance from the start coord to every cell of the maze, following the connections.
+ * Each connection has a distance given by the weight function. Unreachable cells get a distance of
+ * `SIZE_MAX`.
+ *
+ * @param grid The maze grid.
+ * @param start_coord The coord to find distances from.
+ * @param weight_func The function giving the distance of each connection.
+ * @param user_data User data passed to the weight function.
+ * @param dist_arr The output distances, which must have room for `width * height` elements.
+ * @return False if memory could not be allocated, otherwise true.
+ */
+bool ge_mz_grid_get_distances_weighted(const ge_mz_grid_t* grid, ge_coord_t start_coord,
+                                       ge_mz_weight_func_t weight_func, void* user_data,
+                                       size_t* dist_arr);
+
+/**
+ * Get a newly allocated vector of coords forming the shortest path from the start coord to the
+ * end coord, including both ends. The vector is empty if there is no path.
+ */
+ge_coord_vec_t* ge_mz_grid_get_path(const ge_mz_grid_t* grid, ge_coord_t start_coord,
+                                    ge_coord_t end_coord);
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,12 +15,12 @@ extern "C" {
 #endif
 
 /**
- * Color represented as the addition of red, blue, and green values.
+ * Color represented as the addition of red, green, and blue values.
  */
 typedef struct ge_color {
   uint8_t red;
-  uint8_t blue;
   uint8_t green;
+  uint8_t blue;
 } ge_color_t;
 
 /**
@@ -37,6 +37,31 @@ typedef struct ge_palette {
  */
 extern const ge_palette_t GE_PALETTE_INFERNO;
 
+/**
+ * Rotate a range of palette entries, for color cycling effects like flowing water or scrolling
+ * stripes. Only the palette changes, so the grid never needs to be touched.
+ *
+ * @param palette The output palette, which may be the same as the source palette.
+ * @param source_palette The palette to rotate. Entries outside of the range are copied as they are.
+ * @param begin_index The first entry in the range.
+ * @param end_index One past the last entry in the range, which must be at most 256.
+ * @param shift How many entries to rotate forwards by, which may be negative, or bigger than the
+ * range.
+ */
+void ge_palette_cycle(ge_palette_t* palette, const ge_palette_t* source_palette,
+                      size_t begin_index, size_t end_index, ptrdiff_t shift);
+
+/**
+ * Blend between two palettes, for fades and flashes.
+ *
+ * @param palette The output palette, which may be the same as either of the other palettes.
+ * @param palette_a The palette at a ratio of zero.
+ * @param palette_b The palette at a ratio of one.
+ * @param ratio How far to blend from the first palette to the second, from zero to one.
+ */
+void ge_palette_lerp(ge_palette_t* palette, const ge_palette_t* palette_a,
+                     const ge_palette_t* palette_b, double ratio);
+
 #ifdef __cplusplus
 }
 #endif
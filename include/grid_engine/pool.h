@@ -0,0 +1,45 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_POOL_H_
+#define GE_POOL_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A pool of worker threads, for splitting work into tasks which can run in parallel.
+ */
+typedef struct ge_pool ge_pool_t;
+
+typedef void (*ge_pool_func_t)(size_t task_index, void* user_data);
+
+/**
+ * Create a pool with the given number of worker threads. If the number of workers is zero, one
+ * worker is created for each CPU, minus one for the calling thread, which also runs tasks.
+ */
+ge_pool_t* ge_pool_create(size_t num_workers);
+void ge_pool_free(ge_pool_t* pool);
+size_t ge_pool_get_num_workers(const ge_pool_t* pool);
+
+/**
+ * Run the function once for each task index from zero to `num_tasks - 1`, and wait for all the
+ * tasks to finish. Tasks may run in any order. Only one thread should run tasks at a time.
+ *
+ * @param pool The pool to run tasks on, or `NULL` to run all tasks on the calling thread.
+ * @param func The function to run for each task.
+ * @param user_data User data passed to the function.
+ * @param num_tasks The number of tasks.
+ */
+void ge_pool_run(ge_pool_t* pool, ge_pool_func_t func, void* user_data, size_t num_tasks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_POOL_H_
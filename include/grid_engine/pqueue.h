@@ -0,0 +1,41 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_PQUEUE_H_
+#define GE_PQUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A min priority queue (binary heap) of values, which are usually indices into some other array.
+ * Entries with lower priorities are popped first.
+ */
+typedef struct ge_pqueue ge_pqueue_t;
+
+typedef struct ge_pqueue_entry {
+  size_t priority;
+  size_t value;
+} ge_pqueue_entry_t;
+
+ge_pqueue_t* ge_pqueue_create();
+void ge_pqueue_free(ge_pqueue_t* pqueue);
+size_t ge_pqueue_size(const ge_pqueue_t* pqueue);
+bool ge_pqueue_is_empty(const ge_pqueue_t* pqueue);
+void ge_pqueue_clear(ge_pqueue_t* pqueue);
+bool ge_pqueue_reserve(ge_pqueue_t* pqueue, size_t capacity);
+bool ge_pqueue_push(ge_pqueue_t* pqueue, size_t priority, size_t value);
+ge_pqueue_entry_t ge_pqueue_peek(const ge_pqueue_t* pqueue);
+ge_pqueue_entry_t ge_pqueue_pop(ge_pqueue_t* pqueue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_PQUEUE_H_
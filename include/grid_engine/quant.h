@@ -0,0 +1,69 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_QUANT_H_
+#define GE_QUANT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid_engine/grid.h"
+#include "grid_engine/palette.h"
+#include "grid_engine/pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Color quantization, for showing color images as a grid with a palette.
+ *
+ * Colors are counted in a histogram with 5 bits per channel, so memory use doesn't depend on the
+ * size of the image. The palette is built from the histogram with median cut, which splits the
+ * colors into boxes until there is one box for each palette entry.
+ *
+ * Pixels are RGBA, with each pixel stored as the bytes red, green, blue, and alpha, in that order.
+ * Alpha is ignored.
+ */
+typedef enum ge_quant_dither {
+  GE_QUANT_DITHER_NONE = 0,
+  // A 4x4 Bayer pattern, which hides banding in smooth gradients
+  GE_QUANT_DITHER_ORDERED,
+} ge_quant_dither_t;
+
+/**
+ * Build a palette for RGBA pixels. Palette entries which aren't needed are set to black.
+ *
+ * @param rgba_pixel_arr The RGBA pixels.
+ * @param pitch The number of bytes between the start of each row.
+ * @param width The width of the pixels.
+ * @param height The height of the pixels.
+ * @param pool The pool to count colors on, or `NULL` to count on the calling thread.
+ * @param palette The output palette.
+ * @return False if memory could not be allocated, otherwise true.
+ */
+bool ge_quant_build_palette(const uint8_t* rgba_pixel_arr, size_t pitch, size_t width,
+                            size_t height, ge_pool_t* pool, ge_palette_t* palette);
+
+/**
+ * Map RGBA pixels to the nearest palette entries.
+ *
+ * @param rgba_pixel_arr The RGBA pixels.
+ * @param pitch The number of bytes between the start of each row.
+ * @param palette The palette to map to.
+ * @param dither How to dither the pixels.
+ * @param pool The pool to map rows on, or `NULL` to map on the calling thread.
+ * @param grid The output grid, which also sets the width and height of the pixels.
+ * @return False if memory could not be allocated, otherwise true.
+ */
+bool ge_quant_map(const uint8_t* rgba_pixel_arr, size_t pitch, const ge_palette_t* palette,
+                  ge_quant_dither_t dither, ge_pool_t* pool, ge_grid_t* grid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_QUANT_H_
@@ -0,0 +1,69 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_RAW_H_
+#define GE_RAW_H_
+
+#include <stdbool.h>
+
+#include "grid_engine/grid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A simple native file format for grids, which can be memory mapped.
+ *
+ * The file starts with a 64 byte header: the magic bytes "GERAWGRD", then the format, width,
+ * height, and stride (bytes per row) as little endian 64-bit integers, then zero padding. The rows
+ * of pixels follow the header, one after another. The only format is `GE_RAW_FORMAT_U8`.
+ */
+typedef enum ge_raw_format {
+  GE_RAW_FORMAT_U8 = 1,
+} ge_raw_format_t;
+
+/**
+ * How a raw grid file is mapped into memory.
+ */
+typedef enum ge_raw_map_mode {
+  // The pixels must not be modified, or the program will crash
+  GE_RAW_MAP_MODE_READ_ONLY = 0,
+  // The pixels can be modified, but changes are private, and never written to the file
+  GE_RAW_MAP_MODE_COPY_ON_WRITE,
+} ge_raw_map_mode_t;
+
+/**
+ * Save a grid as a raw grid file.
+ *
+ * @return False if the file couldn't be written, otherwise true.
+ */
+bool ge_raw_save(const ge_grid_t* grid, const char* filename);
+
+/**
+ * Load a raw grid file, copying the pixels into a new grid.
+ *
+ * @return The loaded grid, or `NULL` if the file couldn't be read.
+ */
+ge_grid_t* ge_raw_load(const char* filename);
+
+/**
+ * Map a raw grid file into memory, as a grid which uses the mapped pixels directly. Opening is
+ * fast even for huge grids, since pixels are only read from the file as they are used. The file
+ * is unmapped when the grid is freed.
+ *
+ * Rows with padding can't be mapped as a grid, so those files are loaded instead.
+ *
+ * @param filename The raw grid file.
+ * @param mode How the file is mapped.
+ * @return The mapped grid, or `NULL` if the file couldn't be mapped.
+ */
+ge_grid_t* ge_raw_map(const char* filename, ge_raw_map_mode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_RAW_H_
@@ -10,6 +10,9 @@
 #include <stdint.h>
 
 #include "grid_engine/grid.h"
+#include "grid_engine/mipmap.h"
+#include "grid_engine/rect.h"
+#include "grid_engine/tl_grid.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,13 +32,29 @@ typedef struct ge_sc_view ge_sc_view_t;
 ge_sc_view_t* ge_sc_view_create(size_t width, size_t height, size_t pixel_multiplier,
                                 const ge_grid_t* source_grid);
 
+/**
+ * Create a new view of a tiled grid. Tiles are paged in as they come into view, and while
+ * scrolling, the tiles just ahead of the view are prefetched if they fit in the tile cache. When
+ * zoomed out, the tiled grid is sampled directly, without a mipmap.
+ *
+ * @param width The width of the view.
+ * @param height The height of the view.
+ * @param pixel_multiplier How much to scale the source grid.
+ * @param tl_source_grid The tiled grid which the view will display.
+ * @return The newly created view.
+ */
+ge_sc_view_t* ge_sc_view_create_tl(size_t width, size_t height, size_t pixel_multiplier,
+                                   ge_tl_grid_t* tl_source_grid);
+
 /**
  * Free the view.
  */
 void ge_sc_view_free(ge_sc_view_t* view);
 
 /**
- * Refresh the contents of the view's render grid.
+ * Refresh the contents of the view's render grid. Nothing is drawn if neither the scroll position
+ * nor the source grid has changed since the last refresh. After scrolling a short distance, the
+ * pixels still in view are moved, and only the newly exposed strips are drawn.
  */
 void ge_sc_view_refresh(ge_sc_view_t* view);
 
@@ -55,6 +74,36 @@ ge_grid_t* ge_sc_view_get_render_grid(ge_sc_view_t* view);
  */
 ge_grid_t* ge_sc_view_resize(ge_sc_view_t* view, size_t width, size_t height);
 
+/**
+ * Zoom the view, keeping the top-left corner in place. The zoom is the number of render pixels for
+ * each source pixel. Whole numbers are drawn by scaling up the source, like the pixel multiplier.
+ * Anything else is sampled, from a mipmap of the source when the zoom is below 1.0.
+ *
+ * @param view The scroll view.
+ * @param zoom The new zoom, which must be greater than zero.
+ */
+void ge_sc_view_set_zoom(ge_sc_view_t* view, double zoom);
+
+/**
+ * Get the zoom of the view, which starts as the pixel multiplier.
+ */
+double ge_sc_view_get_zoom(const ge_sc_view_t* view);
+
+/**
+ * Set how the mipmap is downsampled when zoomed out. The default is `GE_MIPMAP_MODE_MAX`, so
+ * sparse details don't disappear.
+ */
+void ge_sc_view_set_mipmap_mode(ge_sc_view_t* view, ge_mipmap_mode_t mode);
+
+/**
+ * Mark a rect of the source grid as changed, so only that part of the mipmap is rebuilt. If the
+ * source grid changes without marking anything, the whole mipmap is rebuilt.
+ *
+ * @param view The scroll view.
+ * @param rect The rect of the source grid which changed.
+ */
+void ge_sc_view_mark_dirty(ge_sc_view_t* view, ge_rect_t rect);
+
 /**
  * Get the maximum absolute X position available to scroll. This is basically
  * the width of the original grid minus the size of the scroll view. It may be a
@@ -76,7 +125,8 @@ double ge_sc_view_get_max_x_abs_scroll(const ge_sc_view_t* view);
 double ge_sc_view_get_max_y_abs_scroll(const ge_sc_view_t* view);
 
 /**
- * Scroll the view to an absolute X position.
+ * Scroll the view to an absolute X position. Fractional positions are kept, down to a whole render
+ * pixel, so the view scrolls smoothly when zoomed in.
  *
  * @param view The scroll view.
  * @param x The absolute X position for the corner of the view.
@@ -84,7 +134,8 @@ double ge_sc_view_get_max_y_abs_scroll(const ge_sc_view_t* view);
 void ge_sc_view_scroll_to_x_abs(ge_sc_view_t* view, double x);
 
 /**
- * Scroll the view to an absolute Y position.
+ * Scroll the view to an absolute Y position. Fractional positions are kept, down to a whole render
+ * pixel, so the view scrolls smoothly when zoomed in.
  *
  * @param view The scroll view.
  * @param y The absolute Y position for the corner of the view.
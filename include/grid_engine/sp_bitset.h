@@ -0,0 +1,81 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_SP_BITSET_H_
+#define GE_SP_BITSET_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "grid_engine/bitset.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A sparse (compressed) bitset, with the same semantics as `ge_bitset_t`.
+ *
+ * The index space is split into chunks of 65536 bits, and only chunks with set bits are stored.
+ * Each chunk is stored as a sorted array of indices, a plain bitmap, or a list of runs, whichever
+ * suits it best, so memory use is proportional to the number of set bits (or runs) rather than the
+ * size of the set. Searches use `GE_BITSET_SEARCH_INIT` just like the dense bitset.
+ */
+typedef struct ge_sp_bitset ge_sp_bitset_t;
+
+ge_sp_bitset_t* ge_sp_bitset_create(size_t size);
+void ge_sp_bitset_free(ge_sp_bitset_t* bitset);
+bool ge_sp_bitset_set(ge_sp_bitset_t* bitset, size_t index, bool value);
+bool ge_sp_bitset_get(const ge_sp_bitset_t* bitset, size_t index);
+size_t ge_sp_bitset_search(const ge_sp_bitset_t* bitset, size_t start_index);
+bool ge_sp_bitset_has_none(const ge_sp_bitset_t* bitset);
+bool ge_sp_bitset_has_any(const ge_sp_bitset_t* bitset);
+bool ge_sp_bitset_has_all(const ge_sp_bitset_t* bitset);
+size_t ge_sp_bitset_get_size(const ge_sp_bitset_t* bitset);
+size_t ge_sp_bitset_count(const ge_sp_bitset_t* bitset);
+
+/**
+ * Get the number of bytes used by the bitset, including all chunks.
+ */
+size_t ge_sp_bitset_get_mem_usage(const ge_sp_bitset_t* bitset);
+
+/**
+ * Set all bits which are set in `other`, which must be the same size.
+ *
+ * @return False if memory could not be allocated, in which case the bitset is partially updated.
+ */
+bool ge_sp_bitset_or(ge_sp_bitset_t* bitset, const ge_sp_bitset_t* other);
+
+/**
+ * Convert chunks to runs wherever that would use less memory. This is worth doing once a set is
+ * done being built, especially if it contains long stretches of set bits.
+ */
+void ge_sp_bitset_optimize(ge_sp_bitset_t* bitset);
+
+/**
+ * Works just like `ge_bitset_next_value`, iterating through the non-zero values of the set.
+ */
+bool ge_sp_bitset_next_value(const ge_sp_bitset_t* bitset, ge_bitset_value_t* bitset_value);
+
+// Allow easier use of the function above using a macro
+#define GE_FOR_SP_BITSET_VALUES(BITSET_VALUE, BITSET)              \
+  for (ge_bitset_value_t BITSET_VALUE = {GE_BITSET_SEARCH_INIT, 0}; \
+       ge_sp_bitset_next_value(BITSET, &BITSET_VALUE);)
+
+/**
+ * Create a new sparse bitset with the same contents as the dense bitset.
+ */
+ge_sp_bitset_t* ge_sp_bitset_from_bitset(const ge_bitset_t* dense_bitset);
+
+/**
+ * Create a new dense bitset with the same contents as the sparse bitset.
+ */
+ge_bitset_t* ge_sp_bitset_to_bitset(const ge_sp_bitset_t* bitset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_SP_BITSET_H_
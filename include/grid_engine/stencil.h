@@ -0,0 +1,99 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_STENCIL_H_
+#define GE_STENCIL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid_engine/grid.h"
+#include "grid_engine/pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Kernels are odd sizes, up to 7x7
+#define GE_STENCIL_MAX_SIZE 7
+
+/**
+ * Stencils compute each pixel of a destination grid from the weighted sum of the source pixels
+ * around it, for effects like blur, diffusion, and heat spread.
+ *
+ * Weights are fixed point. The sum is rounded and shifted right by `shift`, then the offset is
+ * added, and the result is saturated to 0 through 255. The sum of the absolute weights times 255
+ * must fit in 32 bits.
+ */
+typedef struct ge_stencil {
+  size_t width;
+  size_t height;
+  int32_t weight_arr[GE_STENCIL_MAX_SIZE * GE_STENCIL_MAX_SIZE];  // Row major, `width * height`
+  uint32_t shift;
+  int32_t offset;
+} ge_stencil_t;
+
+/**
+ * A separable stencil, which is the outer product of a row of weights and a column of weights.
+ * This needs `2 * size` multiplies per pixel instead of `size * size`. The shift applies to the
+ * product of both weights, and the sum of the absolute row weights times the sum of the absolute
+ * column weights times 255 must fit in 32 bits.
+ */
+typedef struct ge_stencil_sep {
+  size_t size;
+  int32_t x_weight_arr[GE_STENCIL_MAX_SIZE];
+  int32_t y_weight_arr[GE_STENCIL_MAX_SIZE];
+  uint32_t shift;
+  int32_t offset;
+} ge_stencil_sep_t;
+
+/**
+ * How source pixels past the edges of the grid are read.
+ */
+typedef enum ge_stencil_edge {
+  // Like `ge_coord_clamp`, the nearest pixel on the edge is read
+  GE_STENCIL_EDGE_CLAMP = 0,
+  // Like `ge_coord_wrap`, the pixel on the opposite side is read
+  GE_STENCIL_EDGE_WRAP,
+  // The edge value is read
+  GE_STENCIL_EDGE_CONSTANT,
+} ge_stencil_edge_t;
+
+/**
+ * Create a separable binomial stencil, which is a close approximation of a Gaussian blur. The
+ * weights are exact, so the blur never changes the brightness of a flat area.
+ *
+ * @param size The size of the stencil, which must be odd, and at most `GE_STENCIL_MAX_SIZE`.
+ */
+ge_stencil_sep_t ge_stencil_sep_binomial(size_t size);
+
+/**
+ * Apply a stencil to a whole grid. The source and destination grids must be the same size, and
+ * must not be the same grid. The grid is processed in tiles, which run on the pool, if there is
+ * one.
+ *
+ * @param stencil The stencil.
+ * @param source_grid The grid to read.
+ * @param edge How pixels past the edges of the source grid are read.
+ * @param edge_value The value of pixels past the edges, for `GE_STENCIL_EDGE_CONSTANT`.
+ * @param pool The pool to run tiles on, or `NULL` to run on the calling thread.
+ * @param dest_grid The grid to write.
+ */
+void ge_stencil_apply(const ge_stencil_t* stencil, const ge_grid_t* source_grid,
+                      ge_stencil_edge_t edge, uint8_t edge_value, ge_pool_t* pool,
+                      ge_grid_t* dest_grid);
+
+/**
+ * Apply a separable stencil to a whole grid, which is the same as `ge_stencil_apply`, but faster.
+ */
+void ge_stencil_sep_apply(const ge_stencil_sep_t* stencil, const ge_grid_t* source_grid,
+                          ge_stencil_edge_t edge, uint8_t edge_value, ge_pool_t* pool,
+                          ge_grid_t* dest_grid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_STENCIL_H_
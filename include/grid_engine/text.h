@@ -0,0 +1,67 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_TEXT_H_
+#define GE_TEXT_H_
+
+#include <stdint.h>
+
+#include "grid_engine/coord.h"
+#include "grid_engine/grid.h"
+#include "grid_engine/rect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A cache of drawn strings, for text which is drawn over and over, like a HUD.
+ *
+ * Each string is drawn once into a small mask, and after that drawing the string is just a blit of
+ * the mask. The cache holds a fixed number of strings, and the least recently drawn string is
+ * evicted when the cache is full. Long strings aren't cached, so memory use stays small.
+ */
+typedef struct ge_text_cache ge_text_cache_t;
+
+/**
+ * Draw a string of glyphs straight into a grid, using the glyph bitmaps. Each glyph is 8x8, and
+ * glyphs are spaced 9 pixels apart, just like `ge_glyph_get_str_coords`. A newline starts a new
+ * line 9 pixels down. Characters without a glyph are drawn as blanks. Pixels outside of the grid
+ * are clipped, so text can be partly or completely off the grid.
+ *
+ * @param grid The grid to draw into.
+ * @param str The string to draw.
+ * @param coord The top left corner of the first glyph.
+ * @param value The value to set lit pixels to. Unlit pixels are left alone.
+ */
+void ge_text_draw(ge_grid_t* grid, const char* str, ge_coord_t coord, uint8_t value);
+
+/**
+ * Get the rect covered by a string of glyphs drawn at a coord, from the top left of the first glyph
+ * to the bottom right of the last glyph on the longest line.
+ */
+ge_rect_t ge_text_get_rect(const char* str, ge_coord_t coord);
+
+/**
+ * Create a text cache.
+ *
+ * @param num_entries The number of strings kept in the cache, which must be greater than zero.
+ * @return The newly created text cache, or `NULL` if memory could not be allocated.
+ */
+ge_text_cache_t* ge_text_cache_create(size_t num_entries);
+void ge_text_cache_free(ge_text_cache_t* cache);
+size_t ge_text_cache_get_num_entries(const ge_text_cache_t* cache);
+
+/**
+ * Draw a string of glyphs, just like `ge_text_draw`, but using the cache.
+ */
+void ge_text_cache_draw(ge_text_cache_t* cache, ge_grid_t* grid, const char* str,
+                        ge_coord_t coord, uint8_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_TEXT_H_
@@ -0,0 +1,115 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_TL_GRID_H_
+#define GE_TL_GRID_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid_engine/coord.h"
+#include "grid_engine/grid.h"
+#include "grid_engine/rect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A tiled grid, for grids too big to fit in memory.
+ *
+ * The grid is split into square tiles, which are stored in a backing file. Tiles are loaded on
+ * demand into a cache with a fixed number of tiles, and the least recently used tile is evicted
+ * when the cache is full. Changed tiles are written back when they are evicted, or flushed.
+ *
+ * The file starts with a small header, followed by the tiles in row-major order, with each tile
+ * stored as rows of pixels. Tiles on the right and bottom edges are stored at the full tile size.
+ * Any part of the file which was never written reads as zero.
+ *
+ * Errors reading or writing tiles while paging are fatal, since they can't be reported from
+ * functions like `ge_tl_grid_get_coord`.
+ */
+typedef struct ge_tl_grid ge_tl_grid_t;
+
+/**
+ * Create a new tiled grid, replacing any existing file. Every pixel starts as zero.
+ *
+ * @param filename The backing file.
+ * @param width The width of the grid.
+ * @param height The height of the grid.
+ * @param tile_size The width and height of each tile, which must be greater than zero.
+ * @param num_cached_tiles The number of tiles kept in memory, which must be greater than zero.
+ * @return The newly created tiled grid, or `NULL` if the file couldn't be created.
+ */
+ge_tl_grid_t* ge_tl_grid_create(const char* filename, size_t width, size_t height,
+                                size_t tile_size, size_t num_cached_tiles);
+
+/**
+ * Open an existing tiled grid.
+ *
+ * @param filename The backing file, created by `ge_tl_grid_create`.
+ * @param num_cached_tiles The number of tiles kept in memory, which must be greater than zero.
+ * @return The opened tiled grid, or `NULL` if the file couldn't be opened or read.
+ */
+ge_tl_grid_t* ge_tl_grid_open(const char* filename, size_t num_cached_tiles);
+
+/**
+ * Free the tiled grid, writing back any changed tiles first.
+ */
+void ge_tl_grid_free(ge_tl_grid_t* tl_grid);
+
+/**
+ * Write back all changed tiles, keeping them in the cache.
+ *
+ * @return False if writing failed, otherwise true.
+ */
+bool ge_tl_grid_flush(ge_tl_grid_t* tl_grid);
+
+size_t ge_tl_grid_get_width(const ge_tl_grid_t* tl_grid);
+size_t ge_tl_grid_get_height(const ge_tl_grid_t* tl_grid);
+ge_rect_t ge_tl_grid_get_rect(const ge_tl_grid_t* tl_grid);
+size_t ge_tl_grid_get_tile_size(const ge_tl_grid_t* tl_grid);
+size_t ge_tl_grid_get_num_cached_tiles(const ge_tl_grid_t* tl_grid);
+// Increases every time the grid might have changed
+uint64_t ge_tl_grid_get_generation(const ge_tl_grid_t* tl_grid);
+bool ge_tl_grid_has_coord(const ge_tl_grid_t* tl_grid, ge_coord_t coord);
+uint8_t ge_tl_grid_get_coord(ge_tl_grid_t* tl_grid, ge_coord_t coord);
+void ge_tl_grid_set_coord(ge_tl_grid_t* tl_grid, ge_coord_t coord, uint8_t value);
+
+/**
+ * Copy a rect of the tiled grid into a grid. Pixels which fall outside of the grid are skipped.
+ *
+ * @param tl_grid The tiled grid.
+ * @param rect The rect of the tiled grid to copy, which must be within the tiled grid.
+ * @param grid The grid to copy into.
+ * @param coord Where the rect is copied to in the grid.
+ */
+void ge_tl_grid_copy_rect(ge_tl_grid_t* tl_grid, ge_rect_t rect, ge_grid_t* grid,
+                          ge_coord_t coord);
+
+/**
+ * Blit a rect of a grid onto the tiled grid. Pixels which fall outside of the tiled grid are
+ * skipped.
+ *
+ * @param tl_grid The tiled grid.
+ * @param blit_grid The grid to blit from.
+ * @param blit_rect The rect of the grid to blit, which must be within the grid.
+ * @param coord Where the rect is blitted to in the tiled grid.
+ */
+void ge_tl_grid_blit_rect(ge_tl_grid_t* tl_grid, const ge_grid_t* blit_grid, ge_rect_t blit_rect,
+                          ge_coord_t coord);
+
+/**
+ * Load the tiles under a rect into the cache, so they are ready before they are needed. Nothing is
+ * loaded if the rect needs more tiles than the cache holds, since they would evict each other.
+ */
+void ge_tl_grid_prefetch_rect(ge_tl_grid_t* tl_grid, ge_rect_t rect);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_TL_GRID_H_
@@ -0,0 +1,113 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#ifndef GE_TY_GRID_H_
+#define GE_TY_GRID_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid_engine/coord.h"
+#include "grid_engine/grid.h"
+#include "grid_engine/pool.h"
+#include "grid_engine/rect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Enough channels for RGBA, or a 2D vector field with a couple of extras
+#define GE_TY_GRID_MAX_NUM_CHANNELS 4
+
+/**
+ * A typed grid, for simulations which need wider values than a grid, like 16-bit counters or float
+ * fields. Each pixel has one or more channels of the same type, stored one after another, and
+ * pixels are stored in row-major order without padding.
+ *
+ * Typed grids can't be drawn directly. Convert them to a grid with `ge_ty_grid_normalize`,
+ * `ge_ty_grid_quantize`, or `ge_ty_grid_clamp`, which can then be drawn or viewed like any other
+ * grid, with a palette.
+ */
+typedef struct ge_ty_grid ge_ty_grid_t;
+
+typedef enum ge_ty_grid_type {
+  GE_TY_GRID_TYPE_U8 = 0,
+  GE_TY_GRID_TYPE_U16,
+  GE_TY_GRID_TYPE_F32,
+} ge_ty_grid_type_t;
+
+/**
+ * Create a new typed grid. Every value starts as zero.
+ *
+ * @param width The width of the grid.
+ * @param height The height of the grid.
+ * @param type The type of each value.
+ * @param num_channels The number of values in each pixel, from 1 to `GE_TY_GRID_MAX_NUM_CHANNELS`.
+ * @return The newly created typed grid, or `NULL` if memory could not be allocated.
+ */
+ge_ty_grid_t* ge_ty_grid_create(size_t width, size_t height, ge_ty_grid_type_t type,
+                                size_t num_channels);
+void ge_ty_grid_free(ge_ty_grid_t* grid);
+size_t ge_ty_grid_get_width(const ge_ty_grid_t* grid);
+size_t ge_ty_grid_get_height(const ge_ty_grid_t* grid);
+ge_rect_t ge_ty_grid_get_rect(const ge_ty_grid_t* grid);
+ge_ty_grid_type_t ge_ty_grid_get_type(const ge_ty_grid_t* grid);
+size_t ge_ty_grid_get_num_channels(const ge_ty_grid_t* grid);
+// The number of bytes in each pixel, for all channels
+size_t ge_ty_grid_get_pixel_size(const ge_ty_grid_t* grid);
+// Cast the pixels to `uint8_t`, `uint16_t`, or `float`, to match the type
+const void* ge_ty_grid_get_pixel_arr(const ge_ty_grid_t* grid);
+void* ge_ty_grid_get_pixel_arr_mut(ge_ty_grid_t* grid);
+void ge_ty_grid_clear_pixel_arr(ge_ty_grid_t* grid);
+// The generation changes whenever the grid is modified, or the mutable pixel array is taken
+uint64_t ge_ty_grid_get_generation(const ge_ty_grid_t* grid);
+bool ge_ty_grid_has_coord(const ge_ty_grid_t* grid, ge_coord_t coord);
+
+/*
+ * Get and set single values, which are converted to and from a double. Setting a value which is
+ * out of range for the type saturates, and integer values are rounded.
+ */
+
+double ge_ty_grid_get_coord(const ge_ty_grid_t* grid, ge_coord_t coord, size_t channel);
+void ge_ty_grid_set_coord(ge_ty_grid_t* grid, ge_coord_t coord, size_t channel, double value);
+
+/*
+ * Copying and blitting work like the grid functions, but the grids must have the same type and
+ * number of channels.
+ */
+
+ge_ty_grid_t* ge_ty_grid_copy_rect(const ge_ty_grid_t* grid, ge_rect_t rect);
+void ge_ty_grid_blit(ge_ty_grid_t* grid, const ge_ty_grid_t* blit_grid, ge_coord_t coord);
+
+/**
+ * Find the smallest and largest values of a channel, ignoring NaN. Both are zero if the grid is
+ * empty.
+ */
+void ge_ty_grid_get_range(const ge_ty_grid_t* grid, size_t channel, double* min_value,
+                          double* max_value);
+
+/*
+ * Convert a channel of a typed grid to a grid, which must be the same size. Rows are converted in
+ * bands on the pool, if there is one. NaN converts to zero.
+ */
+
+// Scale values from `min_value` to `max_value` across 0 to 255, clamping anything outside
+void ge_ty_grid_normalize(const ge_ty_grid_t* grid, size_t channel, double min_value,
+                          double max_value, ge_pool_t* pool, ge_grid_t* dest_grid);
+// Split values from `min_value` to `max_value` into `num_levels` even bands, from 0 up to
+// `num_levels - 1`, for palettes with only a few colors
+void ge_ty_grid_quantize(const ge_ty_grid_t* grid, size_t channel, double min_value,
+                         double max_value, size_t num_levels, ge_pool_t* pool,
+                         ge_grid_t* dest_grid);
+// Round values and clamp them to 0 to 255, without scaling
+void ge_ty_grid_clamp(const ge_ty_grid_t* grid, size_t channel, ge_pool_t* pool,
+                      ge_grid_t* dest_grid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // GE_TY_GRID_H_
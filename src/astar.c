@@ -0,0 +1,476 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/astar.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_engine/log.h"
+#include "grid_engine/pqueue.h"
+
+typedef struct ge_astar {
+  size_t width;
+  size_t height;
+  uint32_t generation;
+  uint32_t* seen_gen_arr;
+  uint32_t* closed_gen_arr;
+  size_t* cost_arr;
+  size_t* parent_arr;
+  ge_pqueue_t* pqueue;
+} ge_astar_t;
+
+typedef enum ge_astar_mode {
+  GE_ASTAR_MODE_GRID_4 = 0,
+  GE_ASTAR_MODE_GRID_8,
+  GE_ASTAR_MODE_JPS,
+  GE_ASTAR_MODE_MZ,
+} ge_astar_mode_t;
+
+typedef struct ge_astar_query {
+  ge_astar_mode_t mode;
+  size_t width;
+  size_t height;
+  const uint8_t* pixel_arr;
+  const ge_mz_grid_t* mz_grid;
+  size_t end_index;
+} ge_astar_query_t;
+
+// Costs are scaled so diagonal steps can be approximated with integers
+static const size_t GE_ASTAR_STRAIGHT_COST = 10;
+static const size_t GE_ASTAR_DIAGONAL_COST = 14;
+
+#define GE_ASTAR_MAX_NUM_SUCCS 8
+#define GE_ASTAR_TIE_BREAKER_BITS 16
+#define GE_ASTAR_TIE_BREAKER_MASK (((size_t) 1 << GE_ASTAR_TIE_BREAKER_BITS) - 1)
+
+static bool ge_astar_search(ge_astar_t* astar, const ge_astar_query_t* query, size_t start_index,
+                            ge_coord_vec_t* path);
+static bool ge_astar_prepare(ge_astar_t* astar, size_t width, size_t height);
+static size_t ge_astar_get_succs(const ge_astar_t* astar, const ge_astar_query_t* query,
+                                 size_t index, size_t* succ_indices);
+static size_t ge_astar_get_jps_succs(const ge_astar_t* astar, const ge_astar_query_t* query,
+                                     size_t index, size_t* succ_indices);
+static size_t ge_astar_jump(const ge_astar_query_t* query, ptrdiff_t x, ptrdiff_t y, ptrdiff_t dx,
+                            ptrdiff_t dy);
+static size_t ge_astar_jump_straight(const ge_astar_query_t* query, ptrdiff_t x, ptrdiff_t y,
+                                     ptrdiff_t dx, ptrdiff_t dy);
+static bool ge_astar_is_walkable(const ge_astar_query_t* query, ptrdiff_t x, ptrdiff_t y);
+static size_t ge_astar_get_cost(const ge_astar_query_t* query, size_t index, size_t other_index);
+static size_t ge_astar_get_priority(size_t cost, size_t heuristic);
+static void abort_on_coord_out_of_bounds(size_t width, size_t height, ge_coord_t coord);
+static ptrdiff_t pd_abs(ptrdiff_t v);
+static ptrdiff_t pd_sign(ptrdiff_t v);
+
+ge_astar_t* ge_astar_create()
+{
+  ge_astar_t* astar = calloc(1, sizeof(ge_astar_t));
+  if (astar == NULL) {
+    return NULL;
+  }
+  astar->pqueue = ge_pqueue_create();
+  if (astar->pqueue == NULL) {
+    free(astar);
+    return NULL;
+  }
+  return astar;
+}
+
+void ge_astar_free(ge_astar_t* astar)
+{
+  if (astar == NULL) {
+    return;
+  }
+  free(astar->seen_gen_arr);
+  free(astar->closed_gen_arr);
+  free(astar->cost_arr);
+  free(astar->parent_arr);
+  ge_pqueue_free(astar->pqueue);
+  free(astar);
+}
+
+bool ge_astar_find_path(ge_astar_t* astar, const ge_grid_t* grid, ge_coord_t start_coord,
+                        ge_coord_t end_coord, bool use_diagonals, ge_coord_vec_t* path)
+{
+  const size_t width = ge_grid_get_width(grid);
+  const size_t height = ge_grid_get_height(grid);
+  abort_on_coord_out_of_bounds(width, height, start_coord);
+  abort_on_coord_out_of_bounds(width, height, end_coord);
+  const ge_astar_query_t query = {
+      .mode = (use_diagonals ? GE_ASTAR_MODE_GRID_8 : GE_ASTAR_MODE_GRID_4),
+      .width = width,
+      .height = height,
+      .pixel_arr = ge_grid_get_pixel_arr(grid),
+      .mz_grid = NULL,
+      .end_index = width * end_coord.y + end_coord.x,
+  };
+  if (!ge_astar_is_walkable(&query, start_coord.x, start_coord.y)
+      || !ge_astar_is_walkable(&query, end_coord.x, end_coord.y)) {
+    return false;
+  }
+  if (!ge_astar_prepare(astar, width, height)) {
+    return false;
+  }
+  return ge_astar_search(astar, &query, width * start_coord.y + start_coord.x, path);
+}
+
+bool ge_astar_find_path_jps(ge_astar_t* astar, const ge_grid_t* grid, ge_coord_t start_coord,
+                            ge_coord_t end_coord, ge_coord_vec_t* path)
+{
+  const size_t width = ge_grid_get_width(grid);
+  const size_t height = ge_grid_get_height(grid);
+  abort_on_coord_out_of_bounds(width, height, start_coord);
+  abort_on_coord_out_of_bounds(width, height, end_coord);
+  const ge_astar_query_t query = {
+      .mode = GE_ASTAR_MODE_JPS,
+      .width = width,
+      .height = height,
+      .pixel_arr = ge_grid_get_pixel_arr(grid),
+      .mz_grid = NULL,
+      .end_index = width * end_coord.y + end_coord.x,
+  };
+  if (!ge_astar_is_walkable(&query, start_coord.x, start_coord.y)
+      || !ge_astar_is_walkable(&query, end_coord.x, end_coord.y)) {
+    return false;
+  }
+  if (!ge_astar_prepare(astar, width, height)) {
+    return false;
+  }
+  return ge_astar_search(astar, &query, width * start_coord.y + start_coord.x, path);
+}
+
+bool ge_astar_find_path_mz(ge_astar_t* astar, const ge_mz_grid_t* grid, ge_coord_t start_coord,
+                           ge_coord_t end_coord, ge_coord_vec_t* path)
+{
+  const size_t width = ge_mz_grid_get_width(grid);
+  const size_t height = ge_mz_grid_get_height(grid);
+  abort_on_coord_out_of_bounds(width, height, start_coord);
+  abort_on_coord_out_of_bounds(width, height, end_coord);
+  const ge_astar_query_t query = {
+      .mode = GE_ASTAR_MODE_MZ,
+      .width = width,
+      .height = height,
+      .pixel_arr = NULL,
+      .mz_grid = grid,
+      .end_index = width * end_coord.y + end_coord.x,
+  };
+  if (!ge_astar_prepare(astar, width, height)) {
+    return false;
+  }
+  return ge_astar_search(astar, &query, width * start_coord.y + start_coord.x, path);
+}
+
+static bool ge_astar_search(ge_astar_t* astar, const ge_astar_query_t* query, size_t start_index,
+                            ge_coord_vec_t* path)
+{
+  const uint32_t generation = astar->generation;
+  ge_pqueue_clear(astar->pqueue);
+  astar->seen_gen_arr[start_index] = generation;
+  astar->cost_arr[start_index] = 0;
+  astar->parent_arr[start_index] = start_index;
+  const size_t start_priority =
+      ge_astar_get_priority(0, ge_astar_get_cost(query, start_index, query->end_index));
+  if (!ge_pqueue_push(astar->pqueue, start_priority, start_index)) {
+    return false;
+  }
+  bool found_path = false;
+  while (!ge_pqueue_is_empty(astar->pqueue)) {
+    const size_t index = ge_pqueue_pop(astar->pqueue).value;
+    // Stale entries are skipped rather than removed from the queue
+    if (astar->closed_gen_arr[index] == generation) {
+      continue;
+    }
+    astar->closed_gen_arr[index] = generation;
+    if (index == query->end_index) {
+      found_path = true;
+      break;
+    }
+    size_t succ_indices[GE_ASTAR_MAX_NUM_SUCCS];
+    const size_t num_succs = (query->mode == GE_ASTAR_MODE_JPS
+                                  ? ge_astar_get_jps_succs(astar, query, index, succ_indices)
+                                  : ge_astar_get_succs(astar, query, index, succ_indices));
+    for (size_t ii = 0; ii < num_succs; ++ii) {
+      const size_t succ_index = succ_indices[ii];
+      if (astar->closed_gen_arr[succ_index] == generation) {
+        continue;
+      }
+      const size_t succ_cost = astar->cost_arr[index] + ge_astar_get_cost(query, index, succ_index);
+      const bool is_seen = (astar->seen_gen_arr[succ_index] == generation);
+      if (is_seen && succ_cost >= astar->cost_arr[succ_index]) {
+        continue;
+      }
+      astar->seen_gen_arr[succ_index] = generation;
+      astar->cost_arr[succ_index] = succ_cost;
+      astar->parent_arr[succ_index] = index;
+      const size_t priority =
+          ge_astar_get_priority(succ_cost, ge_astar_get_cost(query, succ_index, query->end_index));
+      if (!ge_pqueue_push(astar->pqueue, priority, succ_index)) {
+        return false;
+      }
+    }
+  }
+  if (!found_path) {
+    return false;
+  }
+  // Walk back from the end to find the length of the path, then again to fill it in. Jump points
+  // may be several steps apart, but always in a straight or diagonal line.
+  const size_t width = query->width;
+  size_t path_size = 1;
+  for (size_t index = query->end_index; index != start_index; index = astar->parent_arr[index]) {
+    const size_t parent_index = astar->parent_arr[index];
+    const size_t diff_x = pd_abs((ptrdiff_t) (index % width) - (ptrdiff_t) (parent_index % width));
+    const size_t diff_y = pd_abs((ptrdiff_t) (index / width) - (ptrdiff_t) (parent_index / width));
+    path_size += (diff_x > diff_y ? diff_x : diff_y);
+  }
+  if (!ge_coord_vec_resize(path, path_size)) {
+    return false;
+  }
+  size_t path_index = path_size;
+  ge_coord_t coord = {query->end_index % width, query->end_index / width};
+  ge_coord_vec_set(path, --path_index, coord);
+  for (size_t index = query->end_index; index != start_index; index = astar->parent_arr[index]) {
+    const size_t parent_index = astar->parent_arr[index];
+    const ge_coord_t parent_coord = {parent_index % width, parent_index / width};
+    const ge_coord_t step = {pd_sign(parent_coord.x - coord.x), pd_sign(parent_coord.y - coord.y)};
+    while (!ge_coord_equals(coord, parent_coord)) {
+      coord = ge_coord_add(coord, step);
+      ge_coord_vec_set(path, --path_index, coord);
+    }
+  }
+  return true;
+}
+
+static bool ge_astar_prepare(ge_astar_t* astar, size_t width, size_t height)
+{
+  // Grow the arrays if necessary, otherwise just start a new generation
+  const size_t size = width * height;
+  if (size > astar->width * astar->height || astar->seen_gen_arr == NULL) {
+    const size_t arr_size = (size != 0 ? size : 1);
+    uint32_t* const seen_gen_arr = calloc(arr_size, sizeof(uint32_t));
+    uint32_t* const closed_gen_arr = calloc(arr_size, sizeof(uint32_t));
+    size_t* const cost_arr = malloc(arr_size * sizeof(size_t));
+    size_t* const parent_arr = malloc(arr_size * sizeof(size_t));
+    if (seen_gen_arr == NULL || closed_gen_arr == NULL || cost_arr == NULL || parent_arr == NULL) {
+      free(seen_gen_arr);
+      free(closed_gen_arr);
+      free(cost_arr);
+      free(parent_arr);
+      return false;
+    }
+    free(astar->seen_gen_arr);
+    free(astar->closed_gen_arr);
+    free(astar->cost_arr);
+    free(astar->parent_arr);
+    astar->seen_gen_arr = seen_gen_arr;
+    astar->closed_gen_arr = closed_gen_arr;
+    astar->cost_arr = cost_arr;
+    astar->parent_arr = parent_arr;
+    astar->generation = 0;
+  }
+  else if (width != astar->width || height != astar->height || astar->generation == UINT32_MAX) {
+    // Old generations would be misinterpreted with different dimensions, or after wrapping around
+    memset(astar->seen_gen_arr, 0, size * sizeof(uint32_t));
+    memset(astar->closed_gen_arr, 0, size * sizeof(uint32_t));
+    astar->generation = 0;
+  }
+  astar->width = width;
+  astar->height = height;
+  ++astar->generation;
+  return true;
+}
+
+static size_t ge_astar_get_succs(const ge_astar_t* astar, const ge_astar_query_t* query,
+                                 size_t index, size_t* succ_indices)
+{
+  (void) astar;
+  const ptrdiff_t x = index % query->width;
+  const ptrdiff_t y = index / query->width;
+  size_t num_succs = 0;
+  if (query->mode == GE_ASTAR_MODE_MZ) {
+    const uint8_t value = ge_mz_grid_get_coord(query->mz_grid, (ge_coord_t){x, y});
+    GE_MZ_FOR_ALL_CONS (con) {
+      const ge_coord_t offset = ge_dir_get_offset(ge_mz_con_get_dir(con));
+      const ge_coord_t nbr_coord = {x + offset.x, y + offset.y};
+      if (ge_mz_value_has_con(value, con)
+          && ge_coord_within(nbr_coord, query->width, query->height)) {
+        succ_indices[num_succs++] = query->width * nbr_coord.y + nbr_coord.x;
+      }
+    }
+    return num_succs;
+  }
+  GE_FOR_ALL_DIRS (dir) {
+    const ge_coord_t offset = ge_dir_get_offset(dir);
+    const bool is_diagonal = (offset.x != 0 && offset.y != 0);
+    if (is_diagonal && query->mode == GE_ASTAR_MODE_GRID_4) {
+      continue;
+    }
+    if (!ge_astar_is_walkable(query, x + offset.x, y + offset.y)) {
+      continue;
+    }
+    // Don't cut corners
+    if (is_diagonal
+        && (!ge_astar_is_walkable(query, x + offset.x, y)
+            || !ge_astar_is_walkable(query, x, y + offset.y))) {
+      continue;
+    }
+    succ_indices[num_succs++] = query->width * (y + offset.y) + (x + offset.x);
+  }
+  return num_succs;
+}
+
+static size_t ge_astar_get_jps_succs(const ge_astar_t* astar, const ge_astar_query_t* query,
+                                     size_t index, size_t* succ_indices)
+{
+  // See also: Harabor and Grastien, "Online Graph Pruning for Pathfinding on Grid Maps" (2011)
+  const size_t width = query->width;
+  const ptrdiff_t x = index % width;
+  const ptrdiff_t y = index / width;
+  const size_t parent_index = astar->parent_arr[index];
+  // Prune the neighbors based on the direction of travel, except at the start of the search
+  ge_coord_t nbr_offsets[GE_NUM_DIRS];
+  size_t num_nbrs = 0;
+  if (parent_index == index) {
+    GE_FOR_ALL_DIRS (dir) {
+      nbr_offsets[num_nbrs++] = ge_dir_get_offset(dir);
+    }
+  }
+  else {
+    const ptrdiff_t dx = pd_sign(x - (ptrdiff_t) (parent_index % width));
+    const ptrdiff_t dy = pd_sign(y - (ptrdiff_t) (parent_index / width));
+    if (dx != 0 && dy != 0) {
+      nbr_offsets[num_nbrs++] = (ge_coord_t){0, dy};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){dx, 0};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){dx, dy};
+    }
+    else if (dx != 0) {
+      nbr_offsets[num_nbrs++] = (ge_coord_t){dx, 0};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){dx, 1};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){dx, -1};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){0, 1};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){0, -1};
+    }
+    else {
+      nbr_offsets[num_nbrs++] = (ge_coord_t){0, dy};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){1, dy};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){-1, dy};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){1, 0};
+      nbr_offsets[num_nbrs++] = (ge_coord_t){-1, 0};
+    }
+  }
+  // Jump from each neighbor, keeping the jump points that were found
+  size_t num_succs = 0;
+  for (size_t ii = 0; ii < num_nbrs; ++ii) {
+    const ge_coord_t offset = nbr_offsets[ii];
+    const bool is_diagonal = (offset.x != 0 && offset.y != 0);
+    if (is_diagonal
+        && (!ge_astar_is_walkable(query, x + offset.x, y)
+            || !ge_astar_is_walkable(query, x, y + offset.y))) {
+      continue;
+    }
+    const size_t jump_index = ge_astar_jump(query, x + offset.x, y + offset.y, offset.x, offset.y);
+    if (jump_index != SIZE_MAX) {
+      succ_indices[num_succs++] = jump_index;
+    }
+  }
+  return num_succs;
+}
+
+static size_t ge_astar_jump(const ge_astar_query_t* query, ptrdiff_t x, ptrdiff_t y, ptrdiff_t dx,
+                            ptrdiff_t dy)
+{
+  if (dx == 0 || dy == 0) {
+    return ge_astar_jump_straight(query, x, y, dx, dy);
+  }
+  // Moving diagonally, stop wherever a straight jump would find something
+  while (ge_astar_is_walkable(query, x, y)) {
+    const size_t index = query->width * y + x;
+    if (index == query->end_index || ge_astar_jump_straight(query, x + dx, y, dx, 0) != SIZE_MAX
+        || ge_astar_jump_straight(query, x, y + dy, 0, dy) != SIZE_MAX) {
+      return index;
+    }
+    if (!ge_astar_is_walkable(query, x + dx, y) || !ge_astar_is_walkable(query, x, y + dy)) {
+      break;
+    }
+    x += dx;
+    y += dy;
+  }
+  return SIZE_MAX;
+}
+
+static size_t ge_astar_jump_straight(const ge_astar_query_t* query, ptrdiff_t x, ptrdiff_t y,
+                                     ptrdiff_t dx, ptrdiff_t dy)
+{
+  // Moving straight, stop at the end, or wherever a wall ends beside us (a forced neighbor)
+  while (ge_astar_is_walkable(query, x, y)) {
+    const size_t index = query->width * y + x;
+    if (index == query->end_index) {
+      return index;
+    }
+    if (dx != 0) {
+      if ((ge_astar_is_walkable(query, x, y - 1) && !ge_astar_is_walkable(query, x - dx, y - 1))
+          || (ge_astar_is_walkable(query, x, y + 1)
+              && !ge_astar_is_walkable(query, x - dx, y + 1))) {
+        return index;
+      }
+    }
+    else {
+      if ((ge_astar_is_walkable(query, x - 1, y) && !ge_astar_is_walkable(query, x - 1, y - dy))
+          || (ge_astar_is_walkable(query, x + 1, y)
+              && !ge_astar_is_walkable(query, x + 1, y - dy))) {
+        return index;
+      }
+    }
+    x += dx;
+    y += dy;
+  }
+  return SIZE_MAX;
+}
+
+static bool ge_astar_is_walkable(const ge_astar_query_t* query, ptrdiff_t x, ptrdiff_t y)
+{
+  // Casting to unsigned also rejects negative values
+  return ((size_t) x < query->width && (size_t) y < query->height
+          && query->pixel_arr[query->width * y + x] != 0);
+}
+
+static size_t ge_astar_get_cost(const ge_astar_query_t* query, size_t index, size_t other_index)
+{
+  // This is the exact cost between neighbors and jump points, and the heuristic otherwise
+  const size_t width = query->width;
+  const size_t diff_x = pd_abs((ptrdiff_t) (index % width) - (ptrdiff_t) (other_index % width));
+  const size_t diff_y = pd_abs((ptrdiff_t) (index / width) - (ptrdiff_t) (other_index / width));
+  if (query->mode == GE_ASTAR_MODE_GRID_4 || query->mode == GE_ASTAR_MODE_MZ) {
+    return GE_ASTAR_STRAIGHT_COST * (diff_x + diff_y);
+  }
+  const size_t min_diff = (diff_x < diff_y ? diff_x : diff_y);
+  const size_t max_diff = (diff_x < diff_y ? diff_y : diff_x);
+  return GE_ASTAR_DIAGONAL_COST * min_diff + GE_ASTAR_STRAIGHT_COST * (max_diff - min_diff);
+}
+
+static size_t ge_astar_get_priority(size_t cost, size_t heuristic)
+{
+  // Break ties in favor of the lowest heuristic, which avoids expanding lots of equally good paths
+  const size_t tie_breaker = (heuristic < GE_ASTAR_TIE_BREAKER_MASK ? heuristic
+                                                                    : GE_ASTAR_TIE_BREAKER_MASK);
+  return ((cost + heuristic) << GE_ASTAR_TIE_BREAKER_BITS) | tie_breaker;
+}
+
+static void abort_on_coord_out_of_bounds(size_t width, size_t height, ge_coord_t coord)
+{
+  if (!ge_coord_within(coord, width, height)) {
+    GE_LOG_ERROR("Coord is out of bounds! (%li, %li)", coord.x, coord.y);
+    abort();
+  }
+}
+
+static ptrdiff_t pd_abs(ptrdiff_t v)
+{
+  return (v > 0 ? v : -v);
+}
+
+static ptrdiff_t pd_sign(ptrdiff_t v)
+{
+  return (v > 0) - (v < 0);
+}
@@ -0,0 +1,353 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/bfs.h"
+
+#include <stdlib.h>
+
+#include "grid_engine/bitset.h"
+#include "grid_engine/log.h"
+
+#define GE_BFS_MAX_NUM_TASKS 64
+
+// A newly visited cell, and the seed it was reached from
+typedef struct ge_bfs_visit {
+  size_t index;
+  size_t label;
+} ge_bfs_visit_t;
+
+typedef struct ge_bfs_task {
+  size_t capacity;
+  size_t size;
+  ge_bfs_visit_t* visit_buffer;
+  bool has_failed;
+} ge_bfs_task_t;
+
+typedef struct ge_bfs {
+  ge_pool_t* pool;
+  size_t size;
+  ge_bitset_t* frontier_bitset;
+  ge_bitset_t* next_bitset;
+  ge_bitset_t* remaining_bitset;
+  ge_bfs_task_t task_arr[GE_BFS_MAX_NUM_TASKS];
+} ge_bfs_t;
+
+// Everything the tasks need to process one level of the search
+typedef struct ge_bfs_level {
+  ge_bfs_t* bfs;
+  size_t width;
+  size_t height;
+  const ge_mz_grid_t* mz_grid;
+  size_t* dist_arr;
+  size_t* label_arr;
+  size_t dist;
+  bool is_bottom_up;
+  bool is_parallel;
+  size_t chunk_size;
+} ge_bfs_level_t;
+
+// Go bottom-up when the frontier is at least this fraction of the remaining cells
+static const size_t GE_BFS_BOTTOM_UP_FACTOR = 4;
+// Don't bother splitting levels into tasks unless there are at least this many cells to check
+static const size_t GE_BFS_MIN_PARALLEL_WORK = 16384;
+static const size_t GE_BFS_TASK_DEFAULT_CAPACITY = 64;
+
+static bool ge_bfs_search(ge_bfs_t* bfs, ge_bfs_level_t* level, const ge_coord_t* seed_coords,
+                          size_t num_seeds);
+static bool ge_bfs_prepare(ge_bfs_t* bfs, size_t size);
+static void ge_bfs_run_task(size_t task_index, void* user_data);
+static void ge_bfs_visit(ge_bfs_t* bfs, const ge_bfs_level_t* level, size_t index, size_t label);
+static size_t ge_bfs_get_nbrs(const ge_bfs_level_t* level, size_t index, size_t* nbr_indices);
+static void ge_bfs_task_push(ge_bfs_task_t* task, size_t index, size_t label);
+
+ge_bfs_t* ge_bfs_create(ge_pool_t* pool)
+{
+  ge_bfs_t* bfs = calloc(1, sizeof(ge_bfs_t));
+  if (bfs == NULL) {
+    return NULL;
+  }
+  bfs->pool = pool;
+  return bfs;
+}
+
+void ge_bfs_free(ge_bfs_t* bfs)
+{
+  if (bfs == NULL) {
+    return;
+  }
+  ge_bitset_free(bfs->frontier_bitset);
+  ge_bitset_free(bfs->next_bitset);
+  ge_bitset_free(bfs->remaining_bitset);
+  for (size_t ii = 0; ii < GE_BFS_MAX_NUM_TASKS; ++ii) {
+    free(bfs->task_arr[ii].visit_buffer);
+  }
+  free(bfs);
+}
+
+bool ge_bfs_run(ge_bfs_t* bfs, size_t width, size_t height, ge_bfs_pass_func_t pass_func,
+                void* user_data, const ge_coord_t* seed_coords, size_t num_seeds, size_t* dist_arr,
+                size_t* label_arr)
+{
+  if (!ge_bfs_prepare(bfs, width * height)) {
+    return false;
+  }
+  for (size_t jj = 0; jj < height; ++jj) {
+    for (size_t ii = 0; ii < width; ++ii) {
+      if (pass_func((ge_coord_t){ii, jj}, user_data)) {
+        ge_bitset_set(bfs->remaining_bitset, width * jj + ii, true);
+      }
+    }
+  }
+  ge_bfs_level_t level = {
+      .bfs = bfs,
+      .width = width,
+      .height = height,
+      .mz_grid = NULL,
+      .dist_arr = dist_arr,
+      .label_arr = label_arr,
+      .dist = 0,
+      .is_bottom_up = false,
+      .is_parallel = false,
+      .chunk_size = 0,
+  };
+  return ge_bfs_search(bfs, &level, seed_coords, num_seeds);
+}
+
+bool ge_bfs_run_mz(ge_bfs_t* bfs, const ge_mz_grid_t* grid, const ge_coord_t* seed_coords,
+                   size_t num_seeds, size_t* dist_arr, size_t* label_arr)
+{
+  const size_t width = ge_mz_grid_get_width(grid);
+  const size_t height = ge_mz_grid_get_height(grid);
+  if (!ge_bfs_prepare(bfs, width * height)) {
+    return false;
+  }
+  ge_bitset_set_range(bfs->remaining_bitset, 0, width * height, true);
+  ge_bfs_level_t level = {
+      .bfs = bfs,
+      .width = width,
+      .height = height,
+      .mz_grid = grid,
+      .dist_arr = dist_arr,
+      .label_arr = label_arr,
+      .dist = 0,
+      .is_bottom_up = false,
+      .is_parallel = false,
+      .chunk_size = 0,
+  };
+  return ge_bfs_search(bfs, &level, seed_coords, num_seeds);
+}
+
+static bool ge_bfs_search(ge_bfs_t* bfs, ge_bfs_level_t* level, const ge_coord_t* seed_coords,
+                          size_t num_seeds)
+{
+  const size_t size = bfs->size;
+  size_t* const dist_arr = level->dist_arr;
+  size_t* const label_arr = level->label_arr;
+  for (size_t ii = 0; ii < size; ++ii) {
+    dist_arr[ii] = SIZE_MAX;
+  }
+  if (label_arr != NULL) {
+    for (size_t ii = 0; ii < size; ++ii) {
+      label_arr[ii] = SIZE_MAX;
+    }
+  }
+  for (size_t ii = 0; ii < num_seeds; ++ii) {
+    const ge_coord_t seed_coord = seed_coords[ii];
+    if (!ge_coord_within(seed_coord, level->width, level->height)) {
+      GE_LOG_ERROR("Seed coord is out of bounds! (%li, %li)", seed_coord.x, seed_coord.y);
+      abort();
+    }
+    // Skip impassable seeds, and duplicates
+    const size_t index = level->width * seed_coord.y + seed_coord.x;
+    if (!ge_bitset_get(bfs->remaining_bitset, index)) {
+      continue;
+    }
+    ge_bitset_set(bfs->remaining_bitset, index, false);
+    ge_bitset_set(bfs->frontier_bitset, index, true);
+    dist_arr[index] = 0;
+    if (label_arr != NULL) {
+      label_arr[index] = ii;
+    }
+  }
+  const size_t max_num_tasks =
+      (bfs->pool != NULL ? 4 * (ge_pool_get_num_workers(bfs->pool) + 1) : 1);
+  const size_t num_tasks_limit =
+      (max_num_tasks < GE_BFS_MAX_NUM_TASKS ? max_num_tasks : GE_BFS_MAX_NUM_TASKS);
+  while (ge_bitset_has_any(bfs->frontier_bitset) && ge_bitset_has_any(bfs->remaining_bitset)) {
+    // Pick a direction for this level, and split it into tasks if it's big enough
+    const size_t num_frontier = ge_bitset_count(bfs->frontier_bitset);
+    const size_t num_remaining = ge_bitset_count(bfs->remaining_bitset);
+    level->is_bottom_up = (GE_BFS_BOTTOM_UP_FACTOR * num_frontier >= num_remaining);
+    const size_t work = (level->is_bottom_up ? num_remaining : num_frontier);
+    const size_t num_tasks = (work >= GE_BFS_MIN_PARALLEL_WORK ? num_tasks_limit : 1);
+    const size_t chunk_size = (size + num_tasks - 1) / num_tasks;
+    level->chunk_size = (chunk_size + 63) / 64 * 64;
+    level->is_parallel = (num_tasks > 1);
+    ++level->dist;
+    ge_pool_run(bfs->pool, ge_bfs_run_task, level, num_tasks);
+    // Parallel tasks only record the cells they find, which are visited afterwards, in order, so
+    // the result doesn't depend on timing. Otherwise, cells are visited directly.
+    for (size_t ii = 0; level->is_parallel && ii < num_tasks; ++ii) {
+      const ge_bfs_task_t* const task = &bfs->task_arr[ii];
+      if (task->has_failed) {
+        return false;
+      }
+      for (size_t jj = 0; jj < task->size; ++jj) {
+        ge_bfs_visit(bfs, level, task->visit_buffer[jj].index, task->visit_buffer[jj].label);
+      }
+    }
+    // Clear what's left of the old frontier one bit at a time, since it's usually much smaller than
+    // the grid
+    size_t index = GE_BITSET_SEARCH_INIT;
+    while ((index = ge_bitset_search(bfs->frontier_bitset, index)) != GE_BITSET_SEARCH_INIT) {
+      ge_bitset_set(bfs->frontier_bitset, index, false);
+    }
+    ge_bitset_t* const frontier_bitset = bfs->frontier_bitset;
+    bfs->frontier_bitset = bfs->next_bitset;
+    bfs->next_bitset = frontier_bitset;
+  }
+  return true;
+}
+
+static bool ge_bfs_prepare(ge_bfs_t* bfs, size_t size)
+{
+  // Reuse the bitsets if the size hasn't changed, otherwise create new ones
+  if (bfs->remaining_bitset != NULL && bfs->size == size) {
+    ge_bitset_set_range(bfs->frontier_bitset, 0, size, false);
+    ge_bitset_set_range(bfs->next_bitset, 0, size, false);
+    ge_bitset_set_range(bfs->remaining_bitset, 0, size, false);
+    return true;
+  }
+  ge_bitset_t* const frontier_bitset = ge_bitset_create(size);
+  ge_bitset_t* const next_bitset = ge_bitset_create(size);
+  ge_bitset_t* const remaining_bitset = ge_bitset_create(size);
+  if (frontier_bitset == NULL || next_bitset == NULL || remaining_bitset == NULL) {
+    ge_bitset_free(frontier_bitset);
+    ge_bitset_free(next_bitset);
+    ge_bitset_free(remaining_bitset);
+    return false;
+  }
+  ge_bitset_free(bfs->frontier_bitset);
+  ge_bitset_free(bfs->next_bitset);
+  ge_bitset_free(bfs->remaining_bitset);
+  bfs->size = size;
+  bfs->frontier_bitset = frontier_bitset;
+  bfs->next_bitset = next_bitset;
+  bfs->remaining_bitset = remaining_bitset;
+  return true;
+}
+
+static void ge_bfs_run_task(size_t task_index, void* user_data)
+{
+  // Parallel tasks only read the bitsets, and only write to their own list of visited cells
+  const ge_bfs_level_t* const level = user_data;
+  ge_bfs_t* const bfs = level->bfs;
+  ge_bfs_task_t* const task = &level->bfs->task_arr[task_index];
+  task->size = 0;
+  task->has_failed = false;
+  const size_t begin_index = task_index * level->chunk_size;
+  if (begin_index >= bfs->size) {
+    return;
+  }
+  const size_t end_index = begin_index + level->chunk_size;
+  const ge_bitset_t* const scan_bitset =
+      (level->is_bottom_up ? bfs->remaining_bitset : bfs->frontier_bitset);
+  size_t index = (begin_index != 0 ? begin_index - 1 : GE_BITSET_SEARCH_INIT);
+  while ((index = ge_bitset_search(scan_bitset, index)) != GE_BITSET_SEARCH_INIT
+         && index < end_index) {
+    size_t nbr_indices[GE_MZ_NUM_CONS];
+    const size_t num_nbrs = ge_bfs_get_nbrs(level, index, nbr_indices);
+    for (size_t ii = 0; ii < num_nbrs; ++ii) {
+      const size_t nbr_index = nbr_indices[ii];
+      if (level->is_bottom_up) {
+        // Look for any neighbor in the frontier
+        if (ge_bitset_get(bfs->frontier_bitset, nbr_index)) {
+          const size_t label = (level->label_arr != NULL ? level->label_arr[nbr_index] : SIZE_MAX);
+          if (level->is_parallel) {
+            ge_bfs_task_push(task, index, label);
+          }
+          else {
+            ge_bfs_visit(bfs, level, index, label);
+          }
+          break;
+        }
+      }
+      else {
+        // Look for every neighbor not yet visited
+        if (ge_bitset_get(bfs->remaining_bitset, nbr_index)) {
+          const size_t label = (level->label_arr != NULL ? level->label_arr[index] : SIZE_MAX);
+          if (level->is_parallel) {
+            ge_bfs_task_push(task, nbr_index, label);
+          }
+          else {
+            ge_bfs_visit(bfs, level, nbr_index, label);
+          }
+        }
+      }
+    }
+    // Going top-down on a single task, the frontier can be cleared along the way
+    if (!level->is_bottom_up && !level->is_parallel) {
+      ge_bitset_set(bfs->frontier_bitset, index, false);
+    }
+  }
+}
+
+static void ge_bfs_visit(ge_bfs_t* bfs, const ge_bfs_level_t* level, size_t index, size_t label)
+{
+  if (!ge_bitset_get(bfs->remaining_bitset, index)) {
+    return;
+  }
+  ge_bitset_set(bfs->remaining_bitset, index, false);
+  ge_bitset_set(bfs->next_bitset, index, true);
+  level->dist_arr[index] = level->dist;
+  if (level->label_arr != NULL) {
+    level->label_arr[index] = label;
+  }
+}
+
+static size_t ge_bfs_get_nbrs(const ge_bfs_level_t* level, size_t index, size_t* nbr_indices)
+{
+  // Maze connections are symmetric, so this works in both directions
+  const size_t width = level->width;
+  const size_t x = index % width;
+  const size_t y = index / width;
+  const uint8_t value = (level->mz_grid != NULL
+                             ? ge_mz_grid_get_coord(level->mz_grid, (ge_coord_t){x, y})
+                             : ge_mz_value_set_con(0, GE_MZ_CON_ALL));
+  size_t num_nbrs = 0;
+  if (ge_mz_value_has_con(value, GE_MZ_CON_NORTH) && y > 0) {
+    nbr_indices[num_nbrs++] = index - width;
+  }
+  if (ge_mz_value_has_con(value, GE_MZ_CON_EAST) && x + 1 < width) {
+    nbr_indices[num_nbrs++] = index + 1;
+  }
+  if (ge_mz_value_has_con(value, GE_MZ_CON_SOUTH) && y + 1 < level->height) {
+    nbr_indices[num_nbrs++] = index + width;
+  }
+  if (ge_mz_value_has_con(value, GE_MZ_CON_WEST) && x > 0) {
+    nbr_indices[num_nbrs++] = index - 1;
+  }
+  return num_nbrs;
+}
+
+static void ge_bfs_task_push(ge_bfs_task_t* task, size_t index, size_t label)
+{
+  if (task->has_failed) {
+    return;
+  }
+  if (task->size == task->capacity) {
+    const size_t capacity =
+        (task->capacity != 0 ? 2 * task->capacity : GE_BFS_TASK_DEFAULT_CAPACITY);
+    ge_bfs_visit_t* const visit_buffer =
+        realloc(task->visit_buffer, capacity * sizeof(ge_bfs_visit_t));
+    if (visit_buffer == NULL) {
+      task->has_failed = true;
+      return;
+    }
+    task->capacity = capacity;
+    task->visit_buffer = visit_buffer;
+  }
+  task->visit_buffer[task->size++] = (ge_bfs_visit_t){index, label};
+}
@@ -6,19 +6,48 @@
 #include "grid_engine/bitset.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "grid_engine/log.h"
 
+// Enough levels to summarize any size, since 64^11 is more than 2^64
+#define GE_BITSET_MAX_LEVELS 11
+
+/*
+ * The bitset is hierarchical. Level zero holds the actual bits. Each level above that holds one bit
+ * per value of the level below, which is set if and only if that value is non-zero. Levels are
+ * added until a level fits in a single value. Searching only has to descend through the non-zero
+ * values, so it takes a handful of bit scans per level, regardless of how sparse the set is.
+ */
 typedef struct ge_bitset {
   size_t size;
-  size_t num_values;
-  uint64_t* values;
+  size_t num_set;
+  size_t num_levels;
+  size_t level_num_bits[GE_BITSET_MAX_LEVELS];
+  size_t level_num_values[GE_BITSET_MAX_LEVELS];
+  uint64_t* levels[GE_BITSET_MAX_LEVELS];
 } ge_bitset_t;
 
 const size_t GE_BITSET_SEARCH_INIT = SIZE_MAX;
 
+typedef enum ge_bitset_op {
+  GE_BITSET_OP_AND,
+  GE_BITSET_OP_OR,
+  GE_BITSET_OP_XOR,
+  GE_BITSET_OP_ANDNOT,
+} ge_bitset_op_t;
+
+static size_t ge_bitset_search_level(const ge_bitset_t* bitset, size_t level, size_t bit_pos);
+static void ge_bitset_apply_op(ge_bitset_t* bitset, const ge_bitset_t* other, ge_bitset_op_t op);
+static void ge_bitset_rebuild_summary(ge_bitset_t* bitset, size_t begin_value, size_t end_value);
+static size_t ge_bitset_count_values(const ge_bitset_t* bitset, size_t begin_value,
+                                     size_t end_value);
 static void abort_on_out_of_bounds(const ge_bitset_t* bitset, size_t index);
+static void abort_on_bad_range(const ge_bitset_t* bitset, size_t begin_index, size_t end_index);
+static void abort_on_size_mismatch(const ge_bitset_t* bitset, const ge_bitset_t* other);
+static size_t get_num_values(size_t num_bits);
 static size_t get_first_bit_index(uint64_t value);
+static size_t get_num_bits(uint64_t value);
 
 ge_bitset_t* ge_bitset_create(size_t size)
 {
@@ -27,12 +56,27 @@ ge_bitset_t* ge_bitset_create(size_t size)
     return NULL;
   }
   bitset->size = size;
-  bitset->num_values = size / 64 + (size % 64 != 0 ? 1 : 0);
-  bitset->values = calloc(bitset->num_values, sizeof(uint64_t));
-  if (bitset->values == NULL) {
+  bitset->num_set = 0;
+  // Figure out the shape of each level, and allocate them all together
+  size_t total_num_values = 0;
+  size_t num_bits = size;
+  do {
+    bitset->level_num_bits[bitset->num_levels] = num_bits;
+    bitset->level_num_values[bitset->num_levels] = get_num_values(num_bits);
+    total_num_values += bitset->level_num_values[bitset->num_levels];
+    num_bits = bitset->level_num_values[bitset->num_levels];
+    ++bitset->num_levels;
+  } while (num_bits > 1);
+  uint64_t* const values = calloc(total_num_values, sizeof(uint64_t));
+  if (values == NULL) {
     free(bitset);
     return NULL;
   }
+  size_t value_offset = 0;
+  for (size_t level = 0; level < bitset->num_levels; ++level) {
+    bitset->levels[level] = values + value_offset;
+    value_offset += bitset->level_num_values[level];
+  }
   return bitset;
 }
 
@@ -41,20 +85,28 @@ void ge_bitset_free(ge_bitset_t* bitset)
   if (bitset == NULL) {
     return;
   }
-  free(bitset->values);
+  // All levels share the allocation of level zero
+  free(bitset->levels[0]);
   free(bitset);
 }
 
 void ge_bitset_set(ge_bitset_t* bitset, size_t index, bool value)
 {
   abort_on_out_of_bounds(bitset, index);
-  const size_t value_index = index / 64;
-  const size_t bit_index = index % 64;
-  if (value) {
-    bitset->values[value_index] |= (UINT64_C(1) << bit_index);
-  }
-  else {
-    bitset->values[value_index] &= ~(UINT64_C(1) << bit_index);
+  size_t bit_pos = index;
+  for (size_t level = 0; level < bitset->num_levels; ++level) {
+    uint64_t* const level_value = &bitset->levels[level][bit_pos / 64];
+    const uint64_t bit_mask = UINT64_C(1) << (bit_pos % 64);
+    const uint64_t prv_value = *level_value;
+    *level_value = (value ? prv_value | bit_mask : prv_value & ~bit_mask);
+    if (level == 0 && prv_value != *level_value) {
+      bitset->num_set = (value ? bitset->num_set + 1 : bitset->num_set - 1);
+    }
+    // The level above only changes when this value becomes zero or non-zero
+    if ((prv_value == 0) == (*level_value == 0)) {
+      break;
+    }
+    bit_pos /= 64;
   }
 }
 
@@ -63,45 +115,21 @@ bool ge_bitset_get(const ge_bitset_t* bitset, size_t index)
   abort_on_out_of_bounds(bitset, index);
   const size_t value_index = index / 64;
   const size_t bit_index = index % 64;
-  return ((bitset->values[value_index] & (UINT64_C(1) << bit_index)) != 0);
+  return ((bitset->levels[0][value_index] & (UINT64_C(1) << bit_index)) != 0);
 }
 
 size_t ge_bitset_search(const ge_bitset_t* bitset, size_t start_index)
 {
-  // Complexity will be O(N), with N being the size of the set. Fancy bit
-  // checking is really only helping the coefficient. So this data structure is
-  // not so great for searching.
   if (start_index != GE_BITSET_SEARCH_INIT) {
     abort_on_out_of_bounds(bitset, start_index);
   }
   start_index = (start_index != GE_BITSET_SEARCH_INIT ? start_index + 1 : 0);
-  size_t value_index = start_index / 64;
-  const size_t start_bit_index = start_index % 64;
-  // Mask the starting int for the start index
-  const uint64_t start_value =
-      bitset->values[value_index] & (0xFFFFFFFFFFFFFFFF << start_bit_index);
-  // Check the starting int separately because of the masking
-  if (start_value != 0) {
-    return 64 * value_index + get_first_bit_index(start_value);
-  }
-  // Loop skipping zeroed values, apply bit pattern to non-zeroed values
-  for (++value_index; value_index < bitset->num_values; ++value_index) {
-    const uint64_t cur_value = bitset->values[value_index];
-    if (cur_value != 0) {
-      return 64 * value_index + get_first_bit_index(cur_value);
-    }
-  }
-  return GE_BITSET_SEARCH_INIT;
+  return ge_bitset_search_level(bitset, 0, start_index);
 }
 
 bool ge_bitset_has_none(const ge_bitset_t* bitset)
 {
-  for (size_t value_index = 0; value_index < bitset->num_values; ++value_index) {
-    if (bitset->values[value_index] != 0) {
-      return false;
-    }
-  }
-  return true;
+  return (bitset->num_set == 0);
 }
 
 bool ge_bitset_has_any(const ge_bitset_t* bitset)
@@ -111,21 +139,250 @@ bool ge_bitset_has_any(const ge_bitset_t* bitset)
 
 bool ge_bitset_has_all(const ge_bitset_t* bitset)
 {
-  // Check all but the last value
-  const size_t last_value_index = (bitset->num_values > 1 ? bitset->num_values - 1 : 0);
-  for (size_t value_index = 0; value_index < last_value_index - 1; ++value_index) {
-    if (bitset->values[value_index] != 0xFFFFFFFFFFFFFFFF) {
-      return false;
+  return (bitset->num_set == bitset->size);
+}
+
+size_t ge_bitset_get_size(const ge_bitset_t* bitset)
+{
+  return bitset->size;
+}
+
+size_t ge_bitset_count(const ge_bitset_t* bitset)
+{
+  return bitset->num_set;
+}
+
+void ge_bitset_set_range(ge_bitset_t* bitset, size_t begin_index, size_t end_index, bool value)
+{
+  abort_on_bad_range(bitset, begin_index, end_index);
+  if (begin_index == end_index) {
+    return;
+  }
+  const size_t begin_value = begin_index / 64;
+  const size_t end_value = (end_index - 1) / 64 + 1;
+  const size_t prv_num_set = ge_bitset_count_values(bitset, begin_value, end_value);
+  // Mask the partial values on either end, and fill everything in between
+  uint64_t* const values = bitset->levels[0];
+  const uint64_t begin_mask = 0xFFFFFFFFFFFFFFFF << (begin_index % 64);
+  const uint64_t end_mask = 0xFFFFFFFFFFFFFFFF >> (63 - (end_index - 1) % 64);
+  if (begin_value + 1 == end_value) {
+    const uint64_t mask = begin_mask & end_mask;
+    values[begin_value] = (value ? values[begin_value] | mask : values[begin_value] & ~mask);
+  }
+  else {
+    values[begin_value] =
+        (value ? values[begin_value] | begin_mask : values[begin_value] & ~begin_mask);
+    memset(values + begin_value + 1, (value ? 0xFF : 0x00),
+           (end_value - begin_value - 2) * sizeof(uint64_t));
+    values[end_value - 1] =
+        (value ? values[end_value - 1] | end_mask : values[end_value - 1] & ~end_mask);
+  }
+  const size_t cur_num_set = ge_bitset_count_values(bitset, begin_value, end_value);
+  bitset->num_set = bitset->num_set - prv_num_set + cur_num_set;
+  ge_bitset_rebuild_summary(bitset, begin_value, end_value);
+}
+
+size_t ge_bitset_rank(const ge_bitset_t* bitset, size_t index)
+{
+  // Count the set bits before the index, skipping zeroed values using the summary
+  if (index > bitset->size) {
+    GE_LOG_ERROR("Index is out of bounds! (%zu / %zu)", index, bitset->size);
+    abort();
+  }
+  size_t rank = 0;
+  GE_FOR_BITSET_VALUES (bitset_value, bitset) {
+    if (bitset_value.base_index >= index) {
+      break;
+    }
+    if (index - bitset_value.base_index < 64) {
+      const uint64_t mask = ~(0xFFFFFFFFFFFFFFFF << (index - bitset_value.base_index));
+      rank += get_num_bits(bitset_value.value & mask);
+      break;
+    }
+    rank += get_num_bits(bitset_value.value);
+  }
+  return rank;
+}
+
+size_t ge_bitset_select(const ge_bitset_t* bitset, size_t rank)
+{
+  // Find the value containing the bit, then clear lower bits until we reach it
+  if (rank >= bitset->num_set) {
+    return GE_BITSET_SEARCH_INIT;
+  }
+  GE_FOR_BITSET_VALUES (bitset_value, bitset) {
+    const size_t num_bits = get_num_bits(bitset_value.value);
+    if (rank < num_bits) {
+      uint64_t value = bitset_value.value;
+      for (; rank > 0; --rank) {
+        value &= value - 1;
+      }
+      return bitset_value.base_index + get_first_bit_index(value);
     }
+    rank -= num_bits;
   }
-  // Check the last value with a mask
-  const size_t last_bit_index = bitset->size % 64;
-  if (bitset->values[last_value_index] != (0xFFFFFFFFFFFFFFFF >> (64 - last_bit_index))) {
+  return GE_BITSET_SEARCH_INIT;
+}
+
+void ge_bitset_copy(ge_bitset_t* bitset, const ge_bitset_t* other)
+{
+  abort_on_size_mismatch(bitset, other);
+  if (bitset == other) {
+    return;
+  }
+  // Every level has the same shape, so copy the summary too
+  size_t total_num_values = 0;
+  for (size_t level = 0; level < bitset->num_levels; ++level) {
+    total_num_values += bitset->level_num_values[level];
+  }
+  memcpy(bitset->levels[0], other->levels[0], total_num_values * sizeof(uint64_t));
+  bitset->num_set = other->num_set;
+}
+
+void ge_bitset_and(ge_bitset_t* bitset, const ge_bitset_t* other)
+{
+  ge_bitset_apply_op(bitset, other, GE_BITSET_OP_AND);
+}
+
+void ge_bitset_or(ge_bitset_t* bitset, const ge_bitset_t* other)
+{
+  ge_bitset_apply_op(bitset, other, GE_BITSET_OP_OR);
+}
+
+void ge_bitset_xor(ge_bitset_t* bitset, const ge_bitset_t* other)
+{
+  ge_bitset_apply_op(bitset, other, GE_BITSET_OP_XOR);
+}
+
+void ge_bitset_andnot(ge_bitset_t* bitset, const ge_bitset_t* other)
+{
+  ge_bitset_apply_op(bitset, other, GE_BITSET_OP_ANDNOT);
+}
+
+bool ge_bitset_next_value(const ge_bitset_t* bitset, ge_bitset_value_t* bitset_value)
+{
+  // The bits of level one are exactly the non-zero values of level zero
+  const size_t start_value_index =
+      (bitset_value->base_index != GE_BITSET_SEARCH_INIT ? bitset_value->base_index / 64 + 1 : 0);
+  size_t value_index = GE_BITSET_SEARCH_INIT;
+  if (bitset->num_levels > 1) {
+    value_index = ge_bitset_search_level(bitset, 1, start_value_index);
+  }
+  else if (start_value_index == 0 && bitset->level_num_values[0] != 0
+           && bitset->levels[0][0] != 0) {
+    value_index = 0;
+  }
+  if (value_index == GE_BITSET_SEARCH_INIT) {
+    bitset_value->base_index = GE_BITSET_SEARCH_INIT;
+    bitset_value->value = 0;
     return false;
   }
+  bitset_value->base_index = 64 * value_index;
+  bitset_value->value = bitset->levels[0][value_index];
   return true;
 }
 
+static size_t ge_bitset_search_level(const ge_bitset_t* bitset, size_t level, size_t bit_pos)
+{
+  // Complexity will be O(log64(N)), with N being the size of the set. We climb the levels until
+  // some value has a set bit after the current position, then descend again using the first set
+  // bit of each value, which must be non-zero because of the summary bits.
+  const size_t start_level = level;
+  if (bit_pos >= bitset->level_num_bits[level]) {
+    return GE_BITSET_SEARCH_INIT;
+  }
+  while (true) {
+    const size_t value_index = bit_pos / 64;
+    const uint64_t masked_value =
+        bitset->levels[level][value_index] & (0xFFFFFFFFFFFFFFFF << (bit_pos % 64));
+    if (masked_value != 0) {
+      bit_pos = 64 * value_index + get_first_bit_index(masked_value);
+      break;
+    }
+    // Continue with the next value, which is the next bit of the level above
+    ++level;
+    bit_pos = value_index + 1;
+    if (level == bitset->num_levels || bit_pos >= bitset->level_num_bits[level]) {
+      return GE_BITSET_SEARCH_INIT;
+    }
+  }
+  while (level > start_level) {
+    --level;
+    bit_pos = 64 * bit_pos + get_first_bit_index(bitset->levels[level][bit_pos]);
+  }
+  return bit_pos;
+}
+
+static void ge_bitset_apply_op(ge_bitset_t* bitset, const ge_bitset_t* other, ge_bitset_op_t op)
+{
+  abort_on_size_mismatch(bitset, other);
+  // Keep the loops simple so the compiler can vectorize them
+  const size_t num_values = bitset->level_num_values[0];
+  uint64_t* const values = bitset->levels[0];
+  const uint64_t* const other_values = other->levels[0];
+  switch (op) {
+  case GE_BITSET_OP_AND:
+    for (size_t ii = 0; ii < num_values; ++ii) {
+      values[ii] &= other_values[ii];
+    }
+    break;
+  case GE_BITSET_OP_OR:
+    for (size_t ii = 0; ii < num_values; ++ii) {
+      values[ii] |= other_values[ii];
+    }
+    break;
+  case GE_BITSET_OP_XOR:
+    for (size_t ii = 0; ii < num_values; ++ii) {
+      values[ii] ^= other_values[ii];
+    }
+    break;
+  case GE_BITSET_OP_ANDNOT:
+    for (size_t ii = 0; ii < num_values; ++ii) {
+      values[ii] &= ~other_values[ii];
+    }
+    break;
+  }
+  bitset->num_set = ge_bitset_count_values(bitset, 0, num_values);
+  ge_bitset_rebuild_summary(bitset, 0, num_values);
+}
+
+static void ge_bitset_rebuild_summary(ge_bitset_t* bitset, size_t begin_value, size_t end_value)
+{
+  // Rebuild each level above from the changed range of values in the level below
+  if (begin_value >= end_value) {
+    return;
+  }
+  for (size_t level = 1; level < bitset->num_levels; ++level) {
+    const uint64_t* const lower_values = bitset->levels[level - 1];
+    const size_t num_lower_values = bitset->level_num_values[level - 1];
+    const size_t summary_begin_value = begin_value / 64;
+    const size_t summary_end_value = (end_value - 1) / 64 + 1;
+    for (size_t ii = summary_begin_value; ii < summary_end_value; ++ii) {
+      const size_t lower_begin = 64 * ii;
+      const size_t lower_end = (lower_begin + 64 < num_lower_values ? lower_begin + 64
+                                                                    : num_lower_values);
+      uint64_t summary_value = 0;
+      for (size_t jj = lower_begin; jj < lower_end; ++jj) {
+        summary_value |= (uint64_t) (lower_values[jj] != 0) << (jj - lower_begin);
+      }
+      bitset->levels[level][ii] = summary_value;
+    }
+    begin_value = summary_begin_value;
+    end_value = summary_end_value;
+  }
+}
+
+static size_t ge_bitset_count_values(const ge_bitset_t* bitset, size_t begin_value,
+                                     size_t end_value)
+{
+  const uint64_t* const values = bitset->levels[0];
+  size_t num_set = 0;
+  for (size_t ii = begin_value; ii < end_value; ++ii) {
+    num_set += get_num_bits(values[ii]);
+  }
+  return num_set;
+}
+
 static void abort_on_out_of_bounds(const ge_bitset_t* bitset, size_t index)
 {
   if (index >= bitset->size) {
@@ -134,8 +391,33 @@ static void abort_on_out_of_bounds(const ge_bitset_t* bitset, size_t index)
   }
 }
 
+static void abort_on_bad_range(const ge_bitset_t* bitset, size_t begin_index, size_t end_index)
+{
+  if (begin_index > end_index || end_index > bitset->size) {
+    GE_LOG_ERROR("Range is out of bounds! ([%zu, %zu) / %zu)", begin_index, end_index,
+                 bitset->size);
+    abort();
+  }
+}
+
+static void abort_on_size_mismatch(const ge_bitset_t* bitset, const ge_bitset_t* other)
+{
+  if (bitset->size != other->size) {
+    GE_LOG_ERROR("Bitsets are not the same size! (%zu / %zu)", bitset->size, other->size);
+    abort();
+  }
+}
+
+static size_t get_num_values(size_t num_bits)
+{
+  return num_bits / 64 + (num_bits % 64 != 0 ? 1 : 0);
+}
+
 static size_t get_first_bit_index(uint64_t value)
 {
+#if defined(__GNUC__)
+  return __builtin_ctzll(value);
+#else
   size_t first_bit_index = 0;
   first_bit_index += ((value & 0x00000000FFFFFFFF) != 0 ? 0 : 32);
   value &= ((value & 0x00000000FFFFFFFF) != 0 ? 0x00000000FFFFFFFF : 0xFFFFFFFFFFFFFFFF);
@@ -149,4 +431,18 @@ static size_t get_first_bit_index(uint64_t value)
   value &= ((value & 0x3333333333333333) != 0 ? 0x3333333333333333 : 0xFFFFFFFFFFFFFFFF);
   first_bit_index += ((value & 0x5555555555555555) != 0 ? 0 : 1);
   return first_bit_index;
+#endif
+}
+
+static size_t get_num_bits(uint64_t value)
+{
+#if defined(__GNUC__)
+  return __builtin_popcountll(value);
+#else
+  // See also: https://en.wikipedia.org/wiki/Hamming_weight
+  value = value - ((value >> 1) & 0x5555555555555555);
+  value = (value & 0x3333333333333333) + ((value >> 2) & 0x3333333333333333);
+  value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0F;
+  return (value * 0x0101010101010101) >> 56;
+#endif
 }
@@ -7,12 +7,14 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <string.h>
 
 #include "grid_engine/log.h"
 
 static void abort_on_null(const void* ptr);
 static ge_color_t pixel_grayscale(uint8_t pixel_value);
-static uint32_t pixel_rbga(ge_color_t pixel_color);
+static uint32_t pixel_rgba(ge_color_t pixel_color);
+static bool update_color_lut(void);
 static void destroy_engine_sdl();
 
 typedef struct ge_engine {
@@ -25,6 +27,14 @@ typedef struct ge_engine {
   SDL_Renderer* sdl_renderer;
   SDL_Texture* sdl_texture;
   bool should_quit;
+  // Texture colors for each pixel value, which are only rebuilt when the palette changes
+  bool has_color_lut;
+  bool is_color_lut_grayscale;
+  ge_palette_t color_lut_palette;
+  uint32_t color_lut_arr[256];
+  // The texture is only updated when the grid or the colors change
+  bool is_texture_current;
+  uint64_t texture_grid_generation;
 } ge_engine_t;
 
 #define GE_ENGINE_DEFAULTS_K                                                            \
@@ -77,6 +87,7 @@ ge_error_t ge_set_grid(const ge_grid_t* grid)
     return GE_ERROR_NOT_INITED;
   }
   ge_engine.grid = grid;
+  ge_engine.is_texture_current = false;
   return GE_OK;
 }
 
@@ -170,6 +181,7 @@ ge_error_t ge_create_window()
   }
   SDL_RenderPresent(ge_engine.sdl_renderer);
   ge_engine.has_window = true;
+  ge_engine.is_texture_current = false;
   return GE_OK;
 }
 
@@ -195,26 +207,31 @@ ge_error_t ge_redraw_window()
   else if (!ge_engine.has_window) {
     return GE_ERROR_NO_WINDOW;
   }
-  const size_t width = ge_grid_get_width(ge_engine.grid);
-  const size_t height = ge_grid_get_height(ge_engine.grid);
-  const uint8_t* const pixel_arr = ge_grid_get_pixel_arr(ge_engine.grid);
-  void* tex_pixel_arr_raw = NULL;
-  int tex_pitch_b = 0;
-  if (SDL_LockTexture(ge_engine.sdl_texture, NULL, &tex_pixel_arr_raw, &tex_pitch_b) != 0) {
-    return GE_ERROR_DRAWING;
-  }
-  uint8_t* const tex_pixel_arr = tex_pixel_arr_raw;
-  for (size_t jj = 0; jj < height; jj++) {
-    uint32_t* const tex_pixel_row = (uint32_t*) &tex_pixel_arr[tex_pitch_b * jj];
-    for (size_t ii = 0; ii < width; ii++) {
-      uint32_t* const tex_pixel = &tex_pixel_row[ii];
-      const uint8_t pixel_value = pixel_arr[jj * width + ii];
-      const ge_color_t pixel_color = (ge_engine.palette ? ge_engine.palette->colormap[pixel_value]
-                                                        : pixel_grayscale(pixel_value));
-      *tex_pixel = pixel_rbga(pixel_color);
+  // Animating the palette only rebuilds 256 colors, and the grid isn't read again unless it changed
+  const bool is_color_lut_changed = update_color_lut();
+  const uint64_t grid_generation = ge_grid_get_generation(ge_engine.grid);
+  if (!ge_engine.is_texture_current || is_color_lut_changed
+      || grid_generation != ge_engine.texture_grid_generation) {
+    const size_t width = ge_grid_get_width(ge_engine.grid);
+    const size_t height = ge_grid_get_height(ge_engine.grid);
+    const uint8_t* const pixel_arr = ge_grid_get_pixel_arr(ge_engine.grid);
+    void* tex_pixel_arr_raw = NULL;
+    int tex_pitch_b = 0;
+    if (SDL_LockTexture(ge_engine.sdl_texture, NULL, &tex_pixel_arr_raw, &tex_pitch_b) != 0) {
+      return GE_ERROR_DRAWING;
+    }
+    uint8_t* const tex_pixel_arr = tex_pixel_arr_raw;
+    for (size_t jj = 0; jj < height; jj++) {
+      uint32_t* const tex_pixel_row = (uint32_t*) &tex_pixel_arr[tex_pitch_b * jj];
+      const uint8_t* const pixel_row = &pixel_arr[jj * width];
+      for (size_t ii = 0; ii < width; ii++) {
+        tex_pixel_row[ii] = ge_engine.color_lut_arr[pixel_row[ii]];
+      }
     }
+    SDL_UnlockTexture(ge_engine.sdl_texture);
+    ge_engine.is_texture_current = true;
+    ge_engine.texture_grid_generation = grid_generation;
   }
-  SDL_UnlockTexture(ge_engine.sdl_texture);
   if (SDL_RenderClear(ge_engine.sdl_renderer) != 0) {
     return GE_ERROR_DRAWING;
   }
@@ -273,31 +290,37 @@ static ge_color_t pixel_grayscale(uint8_t pixel_value)
   return (ge_color_t){pixel_value, pixel_value, pixel_value};
 }
 
-#if SDL_BYTEORDER == SDL_LIL_ENDIAN
-#define RGBA_R_SHIFT 24
-#define RGBA_B_SHIFT 16
-#define RGBA_G_SHIFT 8
-#define RGBA_A_SHIFT 0
-#else
-#define RGBA_R_SHIFT 0
-#define RGBA_B_SHIFT 8
-#define RGBA_G_SHIFT 16
-#define RGBA_A_SHIFT 24
-#endif
-
-static uint32_t pixel_rbga(ge_color_t pixel_color)
+static uint32_t pixel_rgba(ge_color_t pixel_color)
 {
-  // Assumes texture format is SDL_PIXELFORMAT_RGBA8888
-  return ((((uint32_t) pixel_color.red) << RGBA_R_SHIFT)      //
-          | (((uint32_t) pixel_color.green) << RGBA_G_SHIFT)  //
-          | (((uint32_t) pixel_color.blue) << RGBA_B_SHIFT)   //
-          | (((uint32_t) 255) << RGBA_A_SHIFT));
+  // Assumes texture format is SDL_PIXELFORMAT_RGBA8888, which is packed, so it's the same on every
+  // platform
+  return ((((uint32_t) pixel_color.red) << 24)      //
+          | (((uint32_t) pixel_color.green) << 16)  //
+          | (((uint32_t) pixel_color.blue) << 8)    //
+          | ((uint32_t) 255));
 }
 
-#undef RGBA_R_SHIFT
-#undef RGBA_G_SHIFT
-#undef RGBA_B_SHIFT
-#undef RGBA_A_SHIFT
+static bool update_color_lut(void)
+{
+  // Palettes are compared by value, so changing the palette in place is noticed
+  const ge_palette_t* const palette = ge_engine.palette;
+  const bool is_grayscale = (palette == NULL);
+  if (ge_engine.has_color_lut && is_grayscale == ge_engine.is_color_lut_grayscale
+      && (is_grayscale
+          || memcmp(palette, &ge_engine.color_lut_palette, sizeof(ge_palette_t)) == 0)) {
+    return false;
+  }
+  for (size_t ii = 0; ii < 256; ++ii) {
+    const ge_color_t pixel_color = (palette != NULL ? palette->colormap[ii] : pixel_grayscale(ii));
+    ge_engine.color_lut_arr[ii] = pixel_rgba(pixel_color);
+  }
+  if (palette != NULL) {
+    ge_engine.color_lut_palette = *palette;
+  }
+  ge_engine.has_color_lut = true;
+  ge_engine.is_color_lut_grayscale = is_grayscale;
+  return true;
+}
 
 static void destroy_engine_sdl()
 {
@@ -350,6 +350,72 @@ const ge_coord_t GE_GLYPH_9[24] = {
     {3, 5}, {3, 6}, {4, 0}, {4, 1}, {4, 2}, {4, 3}, {4, 4}, {4, 5}, {5, 1}, {5, 2}, {5, 3}, {5, 4},
 };
 
+// The same glyphs as above, packed into bitmaps
+const uint64_t GE_GLYPH_BITMAP_ARR[128] = {
+    ['0'] = 0x003e676f7b73633e,
+    ['1'] = 0x003f0c0c0c0c0e0c,
+    ['2'] = 0x003f33061c30331e,
+    ['3'] = 0x001e33301c30331e,
+    ['4'] = 0x0078307f33363c38,
+    ['5'] = 0x001e3330301f033f,
+    ['6'] = 0x001e33331f03061c,
+    ['7'] = 0x000c0c0c1830333f,
+    ['8'] = 0x001e33331e33331e,
+    ['9'] = 0x000e18303e33331e,
+    ['A'] = 0x0033333f33331e0c,
+    ['B'] = 0x003f66663e66663f,
+    ['C'] = 0x003c66030303663c,
+    ['D'] = 0x001f36666666361f,
+    ['E'] = 0x007f46161e16467f,
+    ['F'] = 0x000f06161e16467f,
+    ['G'] = 0x007c66730303663c,
+    ['H'] = 0x003333333f333333,
+    ['I'] = 0x001e0c0c0c0c0c1e,
+    ['J'] = 0x001e333330303078,
+    ['K'] = 0x006766361e366667,
+    ['L'] = 0x007f66460606060f,
+    ['M'] = 0x0063636b7f7f7763,
+    ['N'] = 0x006363737b6f6763,
+    ['O'] = 0x001c36636363361c,
+    ['P'] = 0x000f06063e66663f,
+    ['Q'] = 0x00381e3b3333331e,
+    ['R'] = 0x006766363e66663f,
+    ['S'] = 0x001e33380e07331e,
+    ['T'] = 0x001e0c0c0c0c2d3f,
+    ['U'] = 0x003f333333333333,
+    ['V'] = 0x000c1e3333333333,
+    ['W'] = 0x0063777f6b636363,
+    ['X'] = 0x0063361c1c366363,
+    ['Y'] = 0x001e0c0c1e333333,
+    ['Z'] = 0x007f664c1831637f,
+    ['a'] = 0x006e333e301e0000,
+    ['b'] = 0x003b66663e060607,
+    ['c'] = 0x001e3303331e0000,
+    ['d'] = 0x006e33333e303038,
+    ['e'] = 0x001e033f331e0000,
+    ['f'] = 0x000f06060f06361c,
+    ['g'] = 0x1f303e33336e0000,
+    ['h'] = 0x006766666e360607,
+    ['i'] = 0x001e0c0c0c0e000c,
+    ['j'] = 0x1e33333030300030,
+    ['k'] = 0x0067361e36660607,
+    ['l'] = 0x001e0c0c0c0c0c0e,
+    ['m'] = 0x00636b7f7f330000,
+    ['n'] = 0x00333333331f0000,
+    ['o'] = 0x001e3333331e0000,
+    ['p'] = 0x0f063e66663b0000,
+    ['q'] = 0x78303e33336e0000,
+    ['r'] = 0x000f06666e3b0000,
+    ['s'] = 0x001f301e033e0000,
+    ['t'] = 0x00182c0c0c3e0c08,
+    ['u'] = 0x006e333333330000,
+    ['v'] = 0x000c1e3333330000,
+    ['w'] = 0x00367f7f6b630000,
+    ['x'] = 0x0063361c36630000,
+    ['y'] = 0x1f303e3333330000,
+    ['z'] = 0x003f260c193f0000,
+};
+
 bool ge_glyph_get(char glyph, const ge_coord_t** glyph_coords, size_t* glyph_size)
 {
   *glyph_coords = NULL;
@@ -642,3 +708,10 @@ ge_coord_vec_t* ge_glyph_get_str_coords(const char* str, ge_coord_t start_coord)
   }
   return coord_vec;
 }
+
+uint64_t ge_glyph_get_bitmap(char glyph)
+{
+  // Characters outside of ASCII are negative when char is signed
+  const unsigned char index = glyph;
+  return (index < 128 ? GE_GLYPH_BITMAP_ARR[index] : 0);
+}
@@ -14,8 +14,35 @@ typedef struct ge_grid {
   size_t width;
   size_t height;
   uint8_t* pixel_arr;
+  uint64_t generation;
+  // Only set if the pixels are owned by something else
+  ge_grid_free_func_t free_func;
+  void* free_user_data;
 } ge_grid_t;
 
+typedef enum ge_grid_op {
+  GE_GRID_OP_LUT,
+  GE_GRID_OP_ADD_SAT,
+  GE_GRID_OP_SUB_SAT,
+  GE_GRID_OP_THRESHOLD,
+} ge_grid_op_t;
+
+typedef struct ge_grid_op_data {
+  ge_grid_op_t op;
+  ge_grid_t* grid;
+  ge_rect_t rect;
+  const uint8_t* lut;
+  uint8_t value;
+  uint8_t low_value;
+  uint8_t high_value;
+  size_t num_tasks;
+} ge_grid_op_data_t;
+
+// Rects smaller than this aren't worth splitting between workers
+static const size_t GE_GRID_MIN_PARALLEL_NUM_PIXELS = 1 << 18;
+
+static void ge_grid_run_op(ge_grid_op_data_t* op_data, ge_pool_t* pool);
+static void ge_grid_op_task(size_t task_index, void* user_data);
 static void ge_grid_scale_blit_rect_impl(ge_grid_t* grid, const ge_grid_t* blit_grid,
                                          ge_rect_t blit_rect, ge_coord_t coord,
                                          size_t pixel_multiplier);
@@ -38,12 +65,32 @@ ge_grid_t* ge_grid_create(size_t width, size_t height)
   return grid;
 }
 
+ge_grid_t* ge_grid_create_from_pixel_arr(size_t width, size_t height, uint8_t* pixel_arr,
+                                         ge_grid_free_func_t free_func, void* user_data)
+{
+  ge_grid_t* grid = calloc(1, sizeof(ge_grid_t));
+  if (grid == NULL) {
+    return NULL;
+  }
+  grid->width = width;
+  grid->height = height;
+  grid->pixel_arr = pixel_arr;
+  grid->free_func = free_func;
+  grid->free_user_data = user_data;
+  return grid;
+}
+
 void ge_grid_free(ge_grid_t* grid)
 {
   if (grid == NULL) {
     return;
   }
-  free(grid->pixel_arr);
+  if (grid->free_func != NULL) {
+    grid->free_func(grid->free_user_data);
+  }
+  else {
+    free(grid->pixel_arr);
+  }
   free(grid);
 }
 
@@ -69,6 +116,8 @@ const uint8_t* ge_grid_get_pixel_arr(const ge_grid_t* grid)
 
 uint8_t* ge_grid_get_pixel_arr_mut(ge_grid_t* grid)
 {
+  // Assume the caller is going to modify the pixels
+  ++grid->generation;
   return grid->pixel_arr;
 }
 
@@ -84,12 +133,19 @@ void ge_grid_copy_pixel_arr(ge_grid_t* src_grid, const ge_grid_t* dest_grid)
   }
   const size_t size = src_grid->width * src_grid->height;
   memcpy(src_grid->pixel_arr, dest_grid->pixel_arr, size);
+  ++src_grid->generation;
 }
 
 void ge_grid_clear_pixel_arr(ge_grid_t* grid)
 {
   const size_t size = grid->width * grid->height;
   memset(grid->pixel_arr, 0, size);
+  ++grid->generation;
+}
+
+uint64_t ge_grid_get_generation(const ge_grid_t* grid)
+{
+  return grid->generation;
 }
 
 bool ge_grid_has_coord(const ge_grid_t* grid, ge_coord_t coord)
@@ -108,6 +164,7 @@ void ge_grid_set_coord(ge_grid_t* grid, ge_coord_t coord, uint8_t value)
 {
   abort_on_coord_out_of_bounds(grid, coord);
   grid->pixel_arr[grid->width * coord.y + coord.x] = value;
+  ++grid->generation;
 }
 
 uint8_t ge_grid_get_coord_wrapped(const ge_grid_t* grid, ge_coord_t coord)
@@ -168,6 +225,7 @@ void ge_grid_blit(ge_grid_t* grid, const ge_grid_t* blit_grid, ge_coord_t coord)
          + blit_rect.min_coord.x);
     memcpy(dest_pixel_row, src_pixel_row, blit_width);
   }
+  ++grid->generation;
 }
 
 void ge_grid_scale_blit(ge_grid_t* grid, const ge_grid_t* blit_grid, ge_coord_t coord,
@@ -184,6 +242,59 @@ void ge_grid_scale_blit_rect(ge_grid_t* grid, const ge_grid_t* blit_grid, ge_rec
   ge_grid_scale_blit_rect_impl(grid, blit_grid, blit_rect, coord, pixel_multiplier);
 }
 
+void ge_grid_apply_lut(ge_grid_t* grid, ge_rect_t rect, const uint8_t lut[256], ge_pool_t* pool)
+{
+  ge_grid_op_data_t op_data = {.op = GE_GRID_OP_LUT, .grid = grid, .rect = rect, .lut = lut};
+  ge_grid_run_op(&op_data, pool);
+}
+
+void ge_grid_add_sat(ge_grid_t* grid, ge_rect_t rect, uint8_t value, ge_pool_t* pool)
+{
+  ge_grid_op_data_t op_data = {
+      .op = GE_GRID_OP_ADD_SAT,
+      .grid = grid,
+      .rect = rect,
+      .value = value,
+  };
+  ge_grid_run_op(&op_data, pool);
+}
+
+void ge_grid_sub_sat(ge_grid_t* grid, ge_rect_t rect, uint8_t value, ge_pool_t* pool)
+{
+  ge_grid_op_data_t op_data = {
+      .op = GE_GRID_OP_SUB_SAT,
+      .grid = grid,
+      .rect = rect,
+      .value = value,
+  };
+  ge_grid_run_op(&op_data, pool);
+}
+
+void ge_grid_scale_sat(ge_grid_t* grid, ge_rect_t rect, double factor, ge_pool_t* pool)
+{
+  // There are only 256 values, so scaling is just a table lookup
+  uint8_t lut[256];
+  for (size_t ii = 0; ii < 256; ++ii) {
+    const double scaled_value = ii * factor + 0.5;
+    lut[ii] = (scaled_value >= 255.0 ? 255 : (scaled_value > 0.0 ? (uint8_t) scaled_value : 0));
+  }
+  ge_grid_apply_lut(grid, rect, lut, pool);
+}
+
+void ge_grid_threshold(ge_grid_t* grid, ge_rect_t rect, uint8_t threshold, uint8_t low_value,
+                       uint8_t high_value, ge_pool_t* pool)
+{
+  ge_grid_op_data_t op_data = {
+      .op = GE_GRID_OP_THRESHOLD,
+      .grid = grid,
+      .rect = rect,
+      .value = threshold,
+      .low_value = low_value,
+      .high_value = high_value,
+  };
+  ge_grid_run_op(&op_data, pool);
+}
+
 static void ge_grid_scale_blit_rect_impl(ge_grid_t* grid, const ge_grid_t* blit_grid,
                                          ge_rect_t blit_rect, ge_coord_t coord,
                                          size_t pixel_multiplier)
@@ -222,6 +333,64 @@ static void ge_grid_scale_blit_rect_impl(ge_grid_t* grid, const ge_grid_t* blit_
       memcpy(dest_pixel_row, last_filed_row, scaled_blit_width);
     }
   }
+  ++grid->generation;
+}
+
+static void ge_grid_run_op(ge_grid_op_data_t* op_data, ge_pool_t* pool)
+{
+  abort_on_rect_out_of_bounds(op_data->grid, op_data->rect);
+  const ge_rect_t rect = op_data->rect;
+  if (rect.min_coord.x >= rect.max_coord.x || rect.min_coord.y >= rect.max_coord.y) {
+    return;
+  }
+  const size_t num_pixels =
+      (rect.max_coord.x - rect.min_coord.x) * (rect.max_coord.y - rect.min_coord.y);
+  const bool is_parallel = (pool != NULL && num_pixels >= GE_GRID_MIN_PARALLEL_NUM_PIXELS);
+  op_data->num_tasks = (is_parallel ? 4 * (ge_pool_get_num_workers(pool) + 1) : 1);
+  ge_pool_run((is_parallel ? pool : NULL), ge_grid_op_task, op_data, op_data->num_tasks);
+  ++op_data->grid->generation;
+}
+
+static void ge_grid_op_task(size_t task_index, void* user_data)
+{
+  const ge_grid_op_data_t* const op_data = user_data;
+  const ge_rect_t rect = op_data->rect;
+  const size_t height = rect.max_coord.y - rect.min_coord.y;
+  const size_t num_tasks = op_data->num_tasks;
+  const size_t begin_row = rect.min_coord.y + height * task_index / num_tasks;
+  const size_t end_row = rect.min_coord.y + height * (task_index + 1) / num_tasks;
+  const size_t width = rect.max_coord.x - rect.min_coord.x;
+  const uint8_t value = op_data->value;
+  const uint8_t low_value = op_data->low_value;
+  const uint8_t high_value = op_data->high_value;
+  for (size_t jj = begin_row; jj < end_row; ++jj) {
+    uint8_t* const pixel_row = op_data->grid->pixel_arr + op_data->grid->width * jj
+                               + rect.min_coord.x;
+    // Each op gets its own loop, so the compiler can vectorize each loop on its own
+    switch (op_data->op) {
+    case GE_GRID_OP_LUT:
+      for (size_t ii = 0; ii < width; ++ii) {
+        pixel_row[ii] = op_data->lut[pixel_row[ii]];
+      }
+      break;
+    case GE_GRID_OP_ADD_SAT:
+      for (size_t ii = 0; ii < width; ++ii) {
+        const uint8_t sum = pixel_row[ii] + value;
+        pixel_row[ii] = (sum < value ? 255 : sum);
+      }
+      break;
+    case GE_GRID_OP_SUB_SAT:
+      for (size_t ii = 0; ii < width; ++ii) {
+        pixel_row[ii] = (pixel_row[ii] > value ? pixel_row[ii] - value : 0);
+      }
+      break;
+    case GE_GRID_OP_THRESHOLD:
+      for (size_t ii = 0; ii < width; ++ii) {
+        pixel_row[ii] = (pixel_row[ii] < value ? low_value : high_value);
+      }
+      break;
+    }
+  }
 }
 
 static void abort_on_coord_out_of_bounds(const ge_grid_t* grid, ge_coord_t coord)
@@ -0,0 +1,335 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/history.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_engine/bitset.h"
+#include "grid_engine/log.h"
+
+typedef struct ge_history_tile {
+  size_t ref_count;
+  // Tiles on the right and bottom edges only use part of the pixels
+  uint8_t pixel_arr[];
+} ge_history_tile_t;
+
+typedef struct ge_history_snapshot {
+  ge_history_tile_t** tile_arr;
+} ge_history_snapshot_t;
+
+typedef struct ge_history {
+  ge_grid_t* grid;
+  size_t tile_size;
+  size_t num_tiles_x;
+  size_t num_tiles_y;
+  size_t num_tiles;
+  // Snapshots are kept in a ring, so the oldest can be dropped without moving the rest
+  size_t max_num_snapshots;
+  ge_history_snapshot_t* snapshot_arr;
+  size_t first_snapshot_index;
+  size_t num_snapshots;
+  size_t num_stored_tiles;
+  // Tiles marked by the caller
+  ge_bitset_t* dirty_tile_bitset;
+  // Tiles which could be different from the newest snapshot, after restoring or truncating
+  ge_bitset_t* stale_tile_bitset;
+  // The snapshot the grid matched when it had the synced generation, or `SIZE_MAX` if none
+  size_t synced_snapshot_index;
+  uint64_t synced_generation;
+} ge_history_t;
+
+static ge_history_tile_t** ge_history_get_tile_arr(const ge_history_t* history,
+                                                   size_t snapshot_index);
+static void ge_history_release_snapshot(ge_history_t* history, size_t snapshot_index);
+static ge_rect_t ge_history_get_tile_rect(const ge_history_t* history, size_t tile_index);
+static ge_history_tile_t* ge_history_store_tile(ge_history_t* history, size_t tile_index);
+static void ge_history_release_tile(ge_history_t* history, ge_history_tile_t* tile);
+static bool ge_history_tile_equals(const ge_history_t* history, const ge_history_tile_t* tile,
+                                   size_t tile_index);
+static void ge_history_load_tile(ge_history_t* history, const ge_history_tile_t* tile,
+                                 size_t tile_index, uint8_t* pixel_arr);
+static void abort_on_zero_size(size_t size, const char* name);
+static void abort_on_snapshot_out_of_bounds(const ge_history_t* history, size_t snapshot_index);
+
+ge_history_t* ge_history_create(ge_grid_t* grid, size_t tile_size, size_t max_num_snapshots)
+{
+  abort_on_zero_size(tile_size, "tile size");
+  abort_on_zero_size(max_num_snapshots, "max number of snapshots");
+  ge_history_t* history = calloc(1, sizeof(ge_history_t));
+  if (history == NULL) {
+    return NULL;
+  }
+  history->grid = grid;
+  history->tile_size = tile_size;
+  history->num_tiles_x = (ge_grid_get_width(grid) + tile_size - 1) / tile_size;
+  history->num_tiles_y = (ge_grid_get_height(grid) + tile_size - 1) / tile_size;
+  history->num_tiles = history->num_tiles_x * history->num_tiles_y;
+  history->max_num_snapshots = max_num_snapshots;
+  history->synced_snapshot_index = SIZE_MAX;
+  history->snapshot_arr = calloc(max_num_snapshots, sizeof(ge_history_snapshot_t));
+  history->dirty_tile_bitset = ge_bitset_create(history->num_tiles);
+  history->stale_tile_bitset = ge_bitset_create(history->num_tiles);
+  if (history->snapshot_arr == NULL || history->dirty_tile_bitset == NULL
+      || history->stale_tile_bitset == NULL) {
+    ge_history_free(history);
+    return NULL;
+  }
+  return history;
+}
+
+void ge_history_free(ge_history_t* history)
+{
+  if (history == NULL) {
+    return;
+  }
+  if (history->snapshot_arr != NULL) {
+    ge_history_truncate(history, 0);
+  }
+  free(history->snapshot_arr);
+  ge_bitset_free(history->dirty_tile_bitset);
+  ge_bitset_free(history->stale_tile_bitset);
+  free(history);
+}
+
+size_t ge_history_get_num_snapshots(const ge_history_t* history)
+{
+  return history->num_snapshots;
+}
+
+size_t ge_history_get_max_num_snapshots(const ge_history_t* history)
+{
+  return history->max_num_snapshots;
+}
+
+size_t ge_history_get_num_stored_tiles(const ge_history_t* history)
+{
+  return history->num_stored_tiles;
+}
+
+void ge_history_mark_dirty(ge_history_t* history, ge_rect_t rect)
+{
+  const ge_rect_t overlap_rect = ge_rect_overlap(ge_grid_get_rect(history->grid), rect);
+  if (overlap_rect.min_coord.x >= overlap_rect.max_coord.x
+      || overlap_rect.min_coord.y >= overlap_rect.max_coord.y) {
+    return;
+  }
+  const size_t tile_size = history->tile_size;
+  const size_t min_tile_x = overlap_rect.min_coord.x / tile_size;
+  const size_t min_tile_y = overlap_rect.min_coord.y / tile_size;
+  const size_t max_tile_x = (overlap_rect.max_coord.x - 1) / tile_size;
+  const size_t max_tile_y = (overlap_rect.max_coord.y - 1) / tile_size;
+  for (size_t jj = min_tile_y; jj <= max_tile_y; ++jj) {
+    const size_t row_index = history->num_tiles_x * jj;
+    ge_bitset_set_range(history->dirty_tile_bitset, row_index + min_tile_x,
+                        row_index + max_tile_x + 1, true);
+  }
+}
+
+bool ge_history_snapshot(ge_history_t* history)
+{
+  const size_t num_tiles = history->num_tiles;
+  ge_history_tile_t** const tile_arr = malloc(num_tiles * sizeof(ge_history_tile_t*));
+  if (tile_arr == NULL && num_tiles > 0) {
+    return false;
+  }
+  ge_history_tile_t** const newest_tile_arr =
+      (history->num_snapshots > 0 ? ge_history_get_tile_arr(history, history->num_snapshots - 1)
+                                  : NULL);
+  // Without any marks, there's no telling which tiles changed
+  const uint64_t generation = ge_grid_get_generation(history->grid);
+  const bool is_changed = (generation != history->synced_generation);
+  const bool is_compare_all =
+      (newest_tile_arr == NULL
+       || (is_changed && ge_bitset_has_none(history->dirty_tile_bitset)));
+  for (size_t ii = 0; ii < num_tiles; ++ii) {
+    ge_history_tile_t* tile = (newest_tile_arr != NULL ? newest_tile_arr[ii] : NULL);
+    const bool is_compared =
+        (is_compare_all || ge_bitset_get(history->dirty_tile_bitset, ii)
+         || ge_bitset_get(history->stale_tile_bitset, ii));
+    if (is_compared && (tile == NULL || !ge_history_tile_equals(history, tile, ii))) {
+      tile = ge_history_store_tile(history, ii);
+      if (tile == NULL) {
+        // Undo everything, so the history is unchanged
+        for (size_t jj = 0; jj < ii; ++jj) {
+          ge_history_release_tile(history, tile_arr[jj]);
+        }
+        free(tile_arr);
+        return false;
+      }
+    }
+    else {
+      ++tile->ref_count;
+    }
+    tile_arr[ii] = tile;
+  }
+  if (history->num_snapshots == history->max_num_snapshots) {
+    ge_history_release_snapshot(history, 0);
+    history->first_snapshot_index =
+        (history->first_snapshot_index + 1) % history->max_num_snapshots;
+    --history->num_snapshots;
+  }
+  const size_t ring_index =
+      (history->first_snapshot_index + history->num_snapshots) % history->max_num_snapshots;
+  history->snapshot_arr[ring_index].tile_arr = tile_arr;
+  ++history->num_snapshots;
+  history->synced_snapshot_index = history->num_snapshots - 1;
+  history->synced_generation = generation;
+  ge_bitset_set_range(history->dirty_tile_bitset, 0, num_tiles, false);
+  ge_bitset_set_range(history->stale_tile_bitset, 0, num_tiles, false);
+  return true;
+}
+
+void ge_history_restore(ge_history_t* history, size_t snapshot_index)
+{
+  abort_on_snapshot_out_of_bounds(history, snapshot_index);
+  ge_history_tile_t** const tile_arr = ge_history_get_tile_arr(history, snapshot_index);
+  // If the grid still matches a snapshot, only the tiles which aren't shared need to be copied
+  const bool is_synced = (history->synced_snapshot_index != SIZE_MAX
+                          && ge_grid_get_generation(history->grid) == history->synced_generation);
+  ge_history_tile_t** const synced_tile_arr =
+      (is_synced ? ge_history_get_tile_arr(history, history->synced_snapshot_index) : NULL);
+  uint8_t* const pixel_arr = ge_grid_get_pixel_arr_mut(history->grid);
+  for (size_t ii = 0; ii < history->num_tiles; ++ii) {
+    if (synced_tile_arr == NULL || synced_tile_arr[ii] != tile_arr[ii]) {
+      ge_history_load_tile(history, tile_arr[ii], ii, pixel_arr);
+      ge_bitset_set(history->stale_tile_bitset, ii, true);
+    }
+  }
+  history->synced_snapshot_index = snapshot_index;
+  history->synced_generation = ge_grid_get_generation(history->grid);
+}
+
+void ge_history_truncate(ge_history_t* history, size_t num_snapshots)
+{
+  if (num_snapshots >= history->num_snapshots) {
+    return;
+  }
+  // Tiles which aren't shared with the new newest snapshot could be different in the grid
+  if (num_snapshots > 0) {
+    ge_history_tile_t** const newest_tile_arr =
+        ge_history_get_tile_arr(history, history->num_snapshots - 1);
+    ge_history_tile_t** const tile_arr = ge_history_get_tile_arr(history, num_snapshots - 1);
+    for (size_t ii = 0; ii < history->num_tiles; ++ii) {
+      if (newest_tile_arr[ii] != tile_arr[ii]) {
+        ge_bitset_set(history->stale_tile_bitset, ii, true);
+      }
+    }
+  }
+  for (size_t ii = num_snapshots; ii < history->num_snapshots; ++ii) {
+    ge_history_release_snapshot(history, ii);
+  }
+  history->num_snapshots = num_snapshots;
+  if (history->synced_snapshot_index != SIZE_MAX
+      && history->synced_snapshot_index >= num_snapshots) {
+    history->synced_snapshot_index = SIZE_MAX;
+  }
+}
+
+static ge_history_tile_t** ge_history_get_tile_arr(const ge_history_t* history,
+                                                   size_t snapshot_index)
+{
+  const size_t ring_index =
+      (history->first_snapshot_index + snapshot_index) % history->max_num_snapshots;
+  return history->snapshot_arr[ring_index].tile_arr;
+}
+
+static void ge_history_release_snapshot(ge_history_t* history, size_t snapshot_index)
+{
+  const size_t ring_index =
+      (history->first_snapshot_index + snapshot_index) % history->max_num_snapshots;
+  ge_history_snapshot_t* const snapshot = &history->snapshot_arr[ring_index];
+  for (size_t ii = 0; ii < history->num_tiles; ++ii) {
+    ge_history_release_tile(history, snapshot->tile_arr[ii]);
+  }
+  free(snapshot->tile_arr);
+  snapshot->tile_arr = NULL;
+}
+
+static ge_rect_t ge_history_get_tile_rect(const ge_history_t* history, size_t tile_index)
+{
+  const size_t tile_size = history->tile_size;
+  const ge_coord_t tile_coord = {(tile_index % history->num_tiles_x) * tile_size,
+                                 (tile_index / history->num_tiles_x) * tile_size};
+  return ge_rect_overlap(ge_grid_get_rect(history->grid),
+                         ge_rect_from_coord_wh(tile_coord, tile_size, tile_size));
+}
+
+static ge_history_tile_t* ge_history_store_tile(ge_history_t* history, size_t tile_index)
+{
+  const size_t tile_size = history->tile_size;
+  ge_history_tile_t* const tile = malloc(sizeof(ge_history_tile_t) + tile_size * tile_size);
+  if (tile == NULL) {
+    return NULL;
+  }
+  tile->ref_count = 1;
+  const ge_rect_t rect = ge_history_get_tile_rect(history, tile_index);
+  const size_t width = ge_grid_get_width(history->grid);
+  const size_t rect_width = ge_rect_get_width(rect);
+  const uint8_t* const pixel_arr = ge_grid_get_pixel_arr(history->grid);
+  for (ptrdiff_t jj = rect.min_coord.y; jj < rect.max_coord.y; ++jj) {
+    memcpy(tile->pixel_arr + tile_size * (jj - rect.min_coord.y),
+           pixel_arr + width * jj + rect.min_coord.x, rect_width);
+  }
+  ++history->num_stored_tiles;
+  return tile;
+}
+
+static void ge_history_release_tile(ge_history_t* history, ge_history_tile_t* tile)
+{
+  if (--tile->ref_count == 0) {
+    free(tile);
+    --history->num_stored_tiles;
+  }
+}
+
+static bool ge_history_tile_equals(const ge_history_t* history, const ge_history_tile_t* tile,
+                                   size_t tile_index)
+{
+  const size_t tile_size = history->tile_size;
+  const ge_rect_t rect = ge_history_get_tile_rect(history, tile_index);
+  const size_t width = ge_grid_get_width(history->grid);
+  const size_t rect_width = ge_rect_get_width(rect);
+  const uint8_t* const pixel_arr = ge_grid_get_pixel_arr(history->grid);
+  for (ptrdiff_t jj = rect.min_coord.y; jj < rect.max_coord.y; ++jj) {
+    if (memcmp(tile->pixel_arr + tile_size * (jj - rect.min_coord.y),
+               pixel_arr + width * jj + rect.min_coord.x, rect_width)
+        != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void ge_history_load_tile(ge_history_t* history, const ge_history_tile_t* tile,
+                                 size_t tile_index, uint8_t* pixel_arr)
+{
+  const size_t tile_size = history->tile_size;
+  const ge_rect_t rect = ge_history_get_tile_rect(history, tile_index);
+  const size_t width = ge_grid_get_width(history->grid);
+  const size_t rect_width = ge_rect_get_width(rect);
+  for (ptrdiff_t jj = rect.min_coord.y; jj < rect.max_coord.y; ++jj) {
+    memcpy(pixel_arr + width * jj + rect.min_coord.x,
+           tile->pixel_arr + tile_size * (jj - rect.min_coord.y), rect_width);
+  }
+}
+
+static void abort_on_zero_size(size_t size, const char* name)
+{
+  if (size == 0) {
+    GE_LOG_ERROR("History %s must be greater than zero!", name);
+    abort();
+  }
+}
+
+static void abort_on_snapshot_out_of_bounds(const ge_history_t* history, size_t snapshot_index)
+{
+  if (snapshot_index >= history->num_snapshots) {
+    GE_LOG_ERROR("History snapshot is out of bounds! %zu", snapshot_index);
+    abort();
+  }
+}
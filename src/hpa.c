@@ -0,0 +1,656 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/hpa.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_engine/bitset.h"
+#include "grid_engine/log.h"
+#include "grid_engine/pqueue.h"
+
+typedef struct ge_hpa_cluster {
+  size_t num_nodes;
+  size_t* node_index_arr;  // Grid index of each entrance node in the cluster
+  size_t* node_dist_arr;   // Distance between each pair of nodes, or `SIZE_MAX` if unreachable
+} ge_hpa_cluster_t;
+
+typedef struct ge_hpa {
+  const uint8_t* pixel_arr;
+  const ge_mz_grid_t* mz_grid;
+  size_t width;
+  size_t height;
+  size_t cluster_size;
+  size_t num_clusters_x;
+  size_t num_clusters_y;
+  ge_hpa_cluster_t* cluster_arr;
+  ge_bitset_t* dirty_bitset;
+  // Scratch space for searching within a single cluster, indexed relative to the cluster
+  size_t* node_index_scratch_arr;
+  size_t* queue_arr;
+  size_t* local_dist_arr;
+  size_t* start_dist_arr;
+  size_t* end_dist_arr;
+  // State for searching the abstract graph, indexed by grid index
+  uint32_t generation;
+  uint32_t* seen_gen_arr;
+  uint32_t* closed_gen_arr;
+  size_t* cost_arr;
+  size_t* parent_arr;
+  ge_pqueue_t* pqueue;
+} ge_hpa_t;
+
+// Long entrances get a node at each end, otherwise just one in the middle
+static const size_t GE_HPA_WIDE_ENTRANCE_SIZE = 6;
+
+#define GE_HPA_TIE_BREAKER_BITS 16
+#define GE_HPA_TIE_BREAKER_MASK (((size_t) 1 << GE_HPA_TIE_BREAKER_BITS) - 1)
+
+static ge_hpa_t* ge_hpa_create_common(size_t width, size_t height, size_t cluster_size);
+static bool ge_hpa_rebuild_cluster(ge_hpa_t* hpa, size_t cluster_index);
+static size_t ge_hpa_add_side_nodes(ge_hpa_t* hpa, ge_coord_t coord, ge_coord_t step,
+                                    size_t length, ge_mz_con_t con, size_t num_nodes);
+static size_t ge_hpa_add_node(ge_hpa_t* hpa, ge_coord_t coord, size_t num_nodes);
+static bool ge_hpa_search(ge_hpa_t* hpa, size_t start_index, size_t end_index,
+                          ge_coord_vec_t* waypoints);
+static bool ge_hpa_relax(ge_hpa_t* hpa, size_t index, size_t succ_index, size_t dist,
+                         size_t end_index);
+static bool ge_hpa_refine(ge_hpa_t* hpa, ge_coord_t from_coord, ge_coord_t to_coord,
+                          ge_coord_vec_t* path, size_t path_offset);
+static void ge_hpa_cluster_bfs(ge_hpa_t* hpa, size_t cluster_index, ge_coord_t start_coord,
+                               size_t* dist_arr);
+static size_t ge_hpa_find_node(const ge_hpa_t* hpa, size_t cluster_index, size_t index);
+static bool ge_hpa_can_step(const ge_hpa_t* hpa, ge_coord_t coord, ge_mz_con_t con);
+static bool ge_hpa_is_walkable(const ge_hpa_t* hpa, ge_coord_t coord);
+static size_t ge_hpa_get_cluster_index(const ge_hpa_t* hpa, ge_coord_t coord);
+static ge_coord_t ge_hpa_get_cluster_origin(const ge_hpa_t* hpa, size_t cluster_index);
+static size_t ge_hpa_get_local_index(const ge_hpa_t* hpa, size_t cluster_index, ge_coord_t coord);
+static ge_coord_t ge_hpa_index_to_coord(const ge_hpa_t* hpa, size_t index);
+static ge_coord_t ge_hpa_get_nbr_coord(ge_coord_t coord, ge_mz_con_t con);
+static void ge_hpa_next_generation(ge_hpa_t* hpa);
+static size_t ge_hpa_get_heuristic(const ge_hpa_t* hpa, size_t index, size_t other_index);
+static size_t ge_hpa_get_priority(size_t cost, size_t heuristic);
+static void abort_on_coord_out_of_bounds(const ge_hpa_t* hpa, ge_coord_t coord);
+static void abort_on_invalid_cluster_size(size_t cluster_size);
+static ptrdiff_t pd_abs(ptrdiff_t v);
+
+ge_hpa_t* ge_hpa_create(const ge_grid_t* grid, size_t cluster_size)
+{
+  ge_hpa_t* hpa =
+      ge_hpa_create_common(ge_grid_get_width(grid), ge_grid_get_height(grid), cluster_size);
+  if (hpa == NULL) {
+    return NULL;
+  }
+  hpa->pixel_arr = ge_grid_get_pixel_arr(grid);
+  return hpa;
+}
+
+ge_hpa_t* ge_hpa_create_mz(const ge_mz_grid_t* grid, size_t cluster_size)
+{
+  ge_hpa_t* hpa =
+      ge_hpa_create_common(ge_mz_grid_get_width(grid), ge_mz_grid_get_height(grid), cluster_size);
+  if (hpa == NULL) {
+    return NULL;
+  }
+  hpa->mz_grid = grid;
+  return hpa;
+}
+
+void ge_hpa_free(ge_hpa_t* hpa)
+{
+  if (hpa == NULL) {
+    return;
+  }
+  if (hpa->cluster_arr != NULL) {
+    for (size_t ii = 0; ii < hpa->num_clusters_x * hpa->num_clusters_y; ++ii) {
+      free(hpa->cluster_arr[ii].node_index_arr);
+      free(hpa->cluster_arr[ii].node_dist_arr);
+    }
+  }
+  free(hpa->cluster_arr);
+  ge_bitset_free(hpa->dirty_bitset);
+  free(hpa->node_index_scratch_arr);
+  free(hpa->queue_arr);
+  free(hpa->local_dist_arr);
+  free(hpa->start_dist_arr);
+  free(hpa->end_dist_arr);
+  free(hpa->seen_gen_arr);
+  free(hpa->closed_gen_arr);
+  free(hpa->cost_arr);
+  free(hpa->parent_arr);
+  ge_pqueue_free(hpa->pqueue);
+  free(hpa);
+}
+
+size_t ge_hpa_get_cluster_size(const ge_hpa_t* hpa)
+{
+  return hpa->cluster_size;
+}
+
+void ge_hpa_update_coord(ge_hpa_t* hpa, ge_coord_t coord)
+{
+  abort_on_coord_out_of_bounds(hpa, coord);
+  // Entrances on the edge of a cluster are shared with the neighboring cluster
+  ge_bitset_set(hpa->dirty_bitset, ge_hpa_get_cluster_index(hpa, coord), true);
+  GE_MZ_FOR_ALL_CONS (con) {
+    const ge_coord_t nbr_coord = ge_hpa_get_nbr_coord(coord, con);
+    if (ge_coord_within(nbr_coord, hpa->width, hpa->height)) {
+      ge_bitset_set(hpa->dirty_bitset, ge_hpa_get_cluster_index(hpa, nbr_coord), true);
+    }
+  }
+}
+
+bool ge_hpa_rebuild(ge_hpa_t* hpa)
+{
+  size_t cluster_index = GE_BITSET_SEARCH_INIT;
+  while ((cluster_index = ge_bitset_search(hpa->dirty_bitset, cluster_index))
+         != GE_BITSET_SEARCH_INIT) {
+    if (!ge_hpa_rebuild_cluster(hpa, cluster_index)) {
+      return false;
+    }
+    ge_bitset_set(hpa->dirty_bitset, cluster_index, false);
+  }
+  return true;
+}
+
+bool ge_hpa_find_path(ge_hpa_t* hpa, ge_coord_t start_coord, ge_coord_t end_coord,
+                      ge_coord_vec_t* waypoints)
+{
+  abort_on_coord_out_of_bounds(hpa, start_coord);
+  abort_on_coord_out_of_bounds(hpa, end_coord);
+  if (!ge_hpa_is_walkable(hpa, start_coord) || !ge_hpa_is_walkable(hpa, end_coord)) {
+    return false;
+  }
+  if (!ge_hpa_rebuild(hpa)) {
+    return false;
+  }
+  ge_hpa_next_generation(hpa);
+  const size_t start_index = hpa->width * start_coord.y + start_coord.x;
+  const size_t end_index = hpa->width * end_coord.y + end_coord.x;
+  return ge_hpa_search(hpa, start_index, end_index, waypoints);
+}
+
+bool ge_hpa_refine_segment(ge_hpa_t* hpa, const ge_coord_vec_t* waypoints, size_t segment_index,
+                           ge_coord_vec_t* path)
+{
+  if (segment_index + 1 >= ge_coord_vec_size(waypoints)) {
+    GE_LOG_ERROR("Segment index is out of bounds! %zu", segment_index);
+    abort();
+  }
+  return ge_hpa_refine(hpa, ge_coord_vec_get(waypoints, segment_index),
+                       ge_coord_vec_get(waypoints, segment_index + 1), path, 0);
+}
+
+bool ge_hpa_refine_path(ge_hpa_t* hpa, const ge_coord_vec_t* waypoints, ge_coord_vec_t* path)
+{
+  const size_t num_waypoints = ge_coord_vec_size(waypoints);
+  if (num_waypoints == 0 || !ge_coord_vec_resize(path, 1)) {
+    return false;
+  }
+  ge_coord_vec_set(path, 0, ge_coord_vec_get(waypoints, 0));
+  // Each segment overwrites the last coord of the previous segment, which is the same coord
+  for (size_t ii = 0; ii + 1 < num_waypoints; ++ii) {
+    if (!ge_hpa_refine(hpa, ge_coord_vec_get(waypoints, ii), ge_coord_vec_get(waypoints, ii + 1),
+                       path, ge_coord_vec_size(path) - 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static ge_hpa_t* ge_hpa_create_common(size_t width, size_t height, size_t cluster_size)
+{
+  abort_on_invalid_cluster_size(cluster_size);
+  ge_hpa_t* hpa = calloc(1, sizeof(ge_hpa_t));
+  if (hpa == NULL) {
+    return NULL;
+  }
+  hpa->width = width;
+  hpa->height = height;
+  hpa->cluster_size = cluster_size;
+  hpa->num_clusters_x = (width + cluster_size - 1) / cluster_size;
+  hpa->num_clusters_y = (height + cluster_size - 1) / cluster_size;
+  const size_t num_clusters = hpa->num_clusters_x * hpa->num_clusters_y;
+  const size_t cluster_area = cluster_size * cluster_size;
+  const size_t size = (width * height != 0 ? width * height : 1);
+  hpa->cluster_arr = calloc(num_clusters != 0 ? num_clusters : 1, sizeof(ge_hpa_cluster_t));
+  hpa->dirty_bitset = ge_bitset_create(num_clusters);
+  hpa->node_index_scratch_arr = malloc(4 * cluster_size * sizeof(size_t));
+  hpa->queue_arr = malloc(cluster_area * sizeof(size_t));
+  hpa->local_dist_arr = malloc(cluster_area * sizeof(size_t));
+  hpa->start_dist_arr = malloc(cluster_area * sizeof(size_t));
+  hpa->end_dist_arr = malloc(cluster_area * sizeof(size_t));
+  hpa->seen_gen_arr = calloc(size, sizeof(uint32_t));
+  hpa->closed_gen_arr = calloc(size, sizeof(uint32_t));
+  hpa->cost_arr = malloc(size * sizeof(size_t));
+  hpa->parent_arr = malloc(size * sizeof(size_t));
+  hpa->pqueue = ge_pqueue_create();
+  if (hpa->cluster_arr == NULL || hpa->dirty_bitset == NULL || hpa->node_index_scratch_arr == NULL
+      || hpa->queue_arr == NULL || hpa->local_dist_arr == NULL || hpa->start_dist_arr == NULL
+      || hpa->end_dist_arr == NULL || hpa->seen_gen_arr == NULL || hpa->closed_gen_arr == NULL
+      || hpa->cost_arr == NULL || hpa->parent_arr == NULL || hpa->pqueue == NULL) {
+    ge_hpa_free(hpa);
+    return NULL;
+  }
+  // Everything is built lazily, before the first query
+  ge_bitset_set_range(hpa->dirty_bitset, 0, num_clusters, true);
+  return hpa;
+}
+
+static bool ge_hpa_rebuild_cluster(ge_hpa_t* hpa, size_t cluster_index)
+{
+  const size_t cluster_size = hpa->cluster_size;
+  const ge_coord_t origin = ge_hpa_get_cluster_origin(hpa, cluster_index);
+  const size_t cluster_width =
+      (hpa->width - origin.x < cluster_size ? hpa->width - origin.x : cluster_size);
+  const size_t cluster_height =
+      (hpa->height - origin.y < cluster_size ? hpa->height - origin.y : cluster_size);
+  const ge_coord_t far_coord = {origin.x + cluster_width - 1, origin.y + cluster_height - 1};
+  // Find the entrances on each side, which the neighboring cluster will find the same way
+  size_t num_nodes = 0;
+  if (origin.y != 0) {
+    num_nodes = ge_hpa_add_side_nodes(hpa, origin, (ge_coord_t){1, 0}, cluster_width,
+                                      GE_MZ_CON_NORTH, num_nodes);
+  }
+  if ((size_t) far_coord.y + 1 != hpa->height) {
+    num_nodes = ge_hpa_add_side_nodes(hpa, (ge_coord_t){origin.x, far_coord.y}, (ge_coord_t){1, 0},
+                                      cluster_width, GE_MZ_CON_SOUTH, num_nodes);
+  }
+  if (origin.x != 0) {
+    num_nodes = ge_hpa_add_side_nodes(hpa, origin, (ge_coord_t){0, 1}, cluster_height,
+                                      GE_MZ_CON_WEST, num_nodes);
+  }
+  if ((size_t) far_coord.x + 1 != hpa->width) {
+    num_nodes = ge_hpa_add_side_nodes(hpa, (ge_coord_t){far_coord.x, origin.y}, (ge_coord_t){0, 1},
+                                      cluster_height, GE_MZ_CON_EAST, num_nodes);
+  }
+  ge_hpa_cluster_t* const cluster = &hpa->cluster_arr[cluster_index];
+  if (num_nodes != cluster->num_nodes || cluster->node_index_arr == NULL) {
+    const size_t arr_size = (num_nodes != 0 ? num_nodes : 1);
+    size_t* const node_index_arr = malloc(arr_size * sizeof(size_t));
+    size_t* const node_dist_arr = malloc(arr_size * arr_size * sizeof(size_t));
+    if (node_index_arr == NULL || node_dist_arr == NULL) {
+      free(node_index_arr);
+      free(node_dist_arr);
+      return false;
+    }
+    free(cluster->node_index_arr);
+    free(cluster->node_dist_arr);
+    cluster->node_index_arr = node_index_arr;
+    cluster->node_dist_arr = node_dist_arr;
+  }
+  cluster->num_nodes = num_nodes;
+  memcpy(cluster->node_index_arr, hpa->node_index_scratch_arr, num_nodes * sizeof(size_t));
+  // Find the distances between each pair of nodes, staying within the cluster
+  for (size_t ii = 0; ii < num_nodes; ++ii) {
+    const ge_coord_t node_coord = ge_hpa_index_to_coord(hpa, cluster->node_index_arr[ii]);
+    ge_hpa_cluster_bfs(hpa, cluster_index, node_coord, hpa->local_dist_arr);
+    for (size_t jj = 0; jj < num_nodes; ++jj) {
+      const ge_coord_t other_coord = ge_hpa_index_to_coord(hpa, cluster->node_index_arr[jj]);
+      const size_t local_index = ge_hpa_get_local_index(hpa, cluster_index, other_coord);
+      cluster->node_dist_arr[num_nodes * ii + jj] = hpa->local_dist_arr[local_index];
+    }
+  }
+  return true;
+}
+
+static size_t ge_hpa_add_side_nodes(ge_hpa_t* hpa, ge_coord_t coord, ge_coord_t step,
+                                    size_t length, ge_mz_con_t con, size_t num_nodes)
+{
+  // Every connection in a maze is an entrance, since cells along the side may not be connected
+  if (hpa->mz_grid != NULL) {
+    for (size_t ii = 0; ii < length; ++ii) {
+      const ge_coord_t side_coord = ge_coord_add(coord, ge_coord_mul(step, ii));
+      if (ge_hpa_can_step(hpa, side_coord, con)) {
+        num_nodes = ge_hpa_add_node(hpa, side_coord, num_nodes);
+      }
+    }
+    return num_nodes;
+  }
+  // On a plain grid, each run of open cells along the side is one entrance
+  size_t begin = 0;
+  for (size_t ii = 0; ii <= length; ++ii) {
+    const ge_coord_t side_coord = ge_coord_add(coord, ge_coord_mul(step, ii));
+    if (ii != length && ge_hpa_can_step(hpa, side_coord, con)) {
+      continue;
+    }
+    if (ii != begin) {
+      const size_t entrance_size = ii - begin;
+      const ge_coord_t begin_coord = ge_coord_add(coord, ge_coord_mul(step, begin));
+      const ge_coord_t last_coord = ge_coord_add(coord, ge_coord_mul(step, ii - 1));
+      if (entrance_size >= GE_HPA_WIDE_ENTRANCE_SIZE) {
+        num_nodes = ge_hpa_add_node(hpa, begin_coord, num_nodes);
+        num_nodes = ge_hpa_add_node(hpa, last_coord, num_nodes);
+      }
+      else {
+        const size_t middle = begin + (entrance_size - 1) / 2;
+        const ge_coord_t middle_coord = ge_coord_add(coord, ge_coord_mul(step, middle));
+        num_nodes = ge_hpa_add_node(hpa, middle_coord, num_nodes);
+      }
+    }
+    begin = ii + 1;
+  }
+  return num_nodes;
+}
+
+static size_t ge_hpa_add_node(ge_hpa_t* hpa, ge_coord_t coord, size_t num_nodes)
+{
+  // Corners can be an entrance on two sides, but are only one node
+  const size_t index = hpa->width * coord.y + coord.x;
+  for (size_t ii = 0; ii < num_nodes; ++ii) {
+    if (hpa->node_index_scratch_arr[ii] == index) {
+      return num_nodes;
+    }
+  }
+  hpa->node_index_scratch_arr[num_nodes] = index;
+  return num_nodes + 1;
+}
+
+static bool ge_hpa_search(ge_hpa_t* hpa, size_t start_index, size_t end_index,
+                          ge_coord_vec_t* waypoints)
+{
+  const ge_coord_t start_coord = ge_hpa_index_to_coord(hpa, start_index);
+  const ge_coord_t end_coord = ge_hpa_index_to_coord(hpa, end_index);
+  const size_t start_cluster_index = ge_hpa_get_cluster_index(hpa, start_coord);
+  const size_t end_cluster_index = ge_hpa_get_cluster_index(hpa, end_coord);
+  // The start and end are temporarily connected to the nodes in their clusters
+  ge_hpa_cluster_bfs(hpa, start_cluster_index, start_coord, hpa->start_dist_arr);
+  ge_hpa_cluster_bfs(hpa, end_cluster_index, end_coord, hpa->end_dist_arr);
+  const uint32_t generation = hpa->generation;
+  ge_pqueue_clear(hpa->pqueue);
+  hpa->seen_gen_arr[start_index] = generation;
+  hpa->cost_arr[start_index] = 0;
+  hpa->parent_arr[start_index] = start_index;
+  const size_t start_priority =
+      ge_hpa_get_priority(0, ge_hpa_get_heuristic(hpa, start_index, end_index));
+  if (!ge_pqueue_push(hpa->pqueue, start_priority, start_index)) {
+    return false;
+  }
+  bool found_path = false;
+  while (!ge_pqueue_is_empty(hpa->pqueue)) {
+    const size_t index = ge_pqueue_pop(hpa->pqueue).value;
+    // Stale entries are skipped rather than removed from the queue
+    if (hpa->closed_gen_arr[index] == generation) {
+      continue;
+    }
+    hpa->closed_gen_arr[index] = generation;
+    if (index == end_index) {
+      found_path = true;
+      break;
+    }
+    const ge_coord_t coord = ge_hpa_index_to_coord(hpa, index);
+    const size_t cluster_index = ge_hpa_get_cluster_index(hpa, coord);
+    const ge_hpa_cluster_t* const cluster = &hpa->cluster_arr[cluster_index];
+    if (index == start_index) {
+      for (size_t ii = 0; ii < cluster->num_nodes; ++ii) {
+        const size_t succ_index = cluster->node_index_arr[ii];
+        const size_t local_index = ge_hpa_get_local_index(
+            hpa, cluster_index, ge_hpa_index_to_coord(hpa, succ_index));
+        if (!ge_hpa_relax(hpa, index, succ_index, hpa->start_dist_arr[local_index], end_index)) {
+          return false;
+        }
+      }
+    }
+    if (cluster_index == end_cluster_index) {
+      const size_t local_index = ge_hpa_get_local_index(hpa, cluster_index, coord);
+      if (!ge_hpa_relax(hpa, index, end_index, hpa->end_dist_arr[local_index], end_index)) {
+        return false;
+      }
+    }
+    const size_t node_index = ge_hpa_find_node(hpa, cluster_index, index);
+    if (node_index == SIZE_MAX) {
+      continue;
+    }
+    // Edges to other nodes within the cluster
+    for (size_t ii = 0; ii < cluster->num_nodes; ++ii) {
+      const size_t dist = cluster->node_dist_arr[cluster->num_nodes * node_index + ii];
+      if (!ge_hpa_relax(hpa, index, cluster->node_index_arr[ii], dist, end_index)) {
+        return false;
+      }
+    }
+    // Edges to the matching nodes in neighboring clusters
+    GE_MZ_FOR_ALL_CONS (con) {
+      if (!ge_hpa_can_step(hpa, coord, con)) {
+        continue;
+      }
+      const ge_coord_t nbr_coord = ge_hpa_get_nbr_coord(coord, con);
+      const size_t nbr_cluster_index = ge_hpa_get_cluster_index(hpa, nbr_coord);
+      const size_t nbr_index = hpa->width * nbr_coord.y + nbr_coord.x;
+      if (nbr_cluster_index != cluster_index
+          && ge_hpa_find_node(hpa, nbr_cluster_index, nbr_index) != SIZE_MAX) {
+        if (!ge_hpa_relax(hpa, index, nbr_index, 1, end_index)) {
+          return false;
+        }
+      }
+    }
+  }
+  if (!found_path) {
+    return false;
+  }
+  size_t num_waypoints = 1;
+  for (size_t index = end_index; index != start_index; index = hpa->parent_arr[index]) {
+    ++num_waypoints;
+  }
+  if (!ge_coord_vec_resize(waypoints, num_waypoints)) {
+    return false;
+  }
+  size_t waypoint_index = num_waypoints;
+  for (size_t index = end_index; index != start_index; index = hpa->parent_arr[index]) {
+    ge_coord_vec_set(waypoints, --waypoint_index, ge_hpa_index_to_coord(hpa, index));
+  }
+  ge_coord_vec_set(waypoints, 0, start_coord);
+  return true;
+}
+
+static bool ge_hpa_relax(ge_hpa_t* hpa, size_t index, size_t succ_index, size_t dist,
+                         size_t end_index)
+{
+  const uint32_t generation = hpa->generation;
+  if (dist == SIZE_MAX || succ_index == index || hpa->closed_gen_arr[succ_index] == generation) {
+    return true;
+  }
+  const size_t succ_cost = hpa->cost_arr[index] + dist;
+  if (hpa->seen_gen_arr[succ_index] == generation && succ_cost >= hpa->cost_arr[succ_index]) {
+    return true;
+  }
+  hpa->seen_gen_arr[succ_index] = generation;
+  hpa->cost_arr[succ_index] = succ_cost;
+  hpa->parent_arr[succ_index] = index;
+  const size_t priority =
+      ge_hpa_get_priority(succ_cost, ge_hpa_get_heuristic(hpa, succ_index, end_index));
+  return ge_pqueue_push(hpa->pqueue, priority, succ_index);
+}
+
+static bool ge_hpa_refine(ge_hpa_t* hpa, ge_coord_t from_coord, ge_coord_t to_coord,
+                          ge_coord_vec_t* path, size_t path_offset)
+{
+  abort_on_coord_out_of_bounds(hpa, from_coord);
+  abort_on_coord_out_of_bounds(hpa, to_coord);
+  const size_t cluster_index = ge_hpa_get_cluster_index(hpa, from_coord);
+  if (cluster_index != ge_hpa_get_cluster_index(hpa, to_coord)) {
+    // Segments between clusters are always a single step
+    GE_MZ_FOR_ALL_CONS (con) {
+      if (ge_coord_equals(ge_hpa_get_nbr_coord(from_coord, con), to_coord)
+          && ge_hpa_can_step(hpa, from_coord, con)) {
+        if (!ge_coord_vec_resize(path, path_offset + 2)) {
+          return false;
+        }
+        ge_coord_vec_set(path, path_offset, from_coord);
+        ge_coord_vec_set(path, path_offset + 1, to_coord);
+        return true;
+      }
+    }
+    return false;
+  }
+  // Search backwards from the end, then walk downhill from the start
+  ge_hpa_cluster_bfs(hpa, cluster_index, to_coord, hpa->local_dist_arr);
+  const size_t dist =
+      hpa->local_dist_arr[ge_hpa_get_local_index(hpa, cluster_index, from_coord)];
+  if (dist == SIZE_MAX || !ge_coord_vec_resize(path, path_offset + dist + 1)) {
+    return false;
+  }
+  ge_coord_t coord = from_coord;
+  ge_coord_vec_set(path, path_offset, coord);
+  for (size_t ii = 1; ii <= dist; ++ii) {
+    GE_MZ_FOR_ALL_CONS (con) {
+      const ge_coord_t nbr_coord = ge_hpa_get_nbr_coord(coord, con);
+      if (ge_hpa_can_step(hpa, coord, con)
+          && ge_hpa_get_cluster_index(hpa, nbr_coord) == cluster_index
+          && hpa->local_dist_arr[ge_hpa_get_local_index(hpa, cluster_index, nbr_coord)]
+                 == dist - ii) {
+        coord = nbr_coord;
+        break;
+      }
+    }
+    ge_coord_vec_set(path, path_offset + ii, coord);
+  }
+  return true;
+}
+
+static void ge_hpa_cluster_bfs(ge_hpa_t* hpa, size_t cluster_index, ge_coord_t start_coord,
+                               size_t* dist_arr)
+{
+  const size_t cluster_size = hpa->cluster_size;
+  for (size_t ii = 0; ii < cluster_size * cluster_size; ++ii) {
+    dist_arr[ii] = SIZE_MAX;
+  }
+  const ge_coord_t origin = ge_hpa_get_cluster_origin(hpa, cluster_index);
+  const size_t cluster_width =
+      (hpa->width - origin.x < cluster_size ? hpa->width - origin.x : cluster_size);
+  const size_t cluster_height =
+      (hpa->height - origin.y < cluster_size ? hpa->height - origin.y : cluster_size);
+  size_t queue_begin = 0;
+  size_t queue_end = 0;
+  const size_t start_local_index = ge_hpa_get_local_index(hpa, cluster_index, start_coord);
+  dist_arr[start_local_index] = 0;
+  hpa->queue_arr[queue_end++] = start_local_index;
+  while (queue_begin != queue_end) {
+    const size_t local_index = hpa->queue_arr[queue_begin++];
+    const ge_coord_t local_coord = {local_index % cluster_size, local_index / cluster_size};
+    const ge_coord_t coord = ge_coord_add(origin, local_coord);
+    GE_MZ_FOR_ALL_CONS (con) {
+      // Stay within the cluster
+      const ge_coord_t nbr_local_coord = ge_hpa_get_nbr_coord(local_coord, con);
+      if (!ge_coord_within(nbr_local_coord, cluster_width, cluster_height)
+          || !ge_hpa_can_step(hpa, coord, con)) {
+        continue;
+      }
+      const size_t nbr_local_index = cluster_size * nbr_local_coord.y + nbr_local_coord.x;
+      if (dist_arr[nbr_local_index] == SIZE_MAX) {
+        dist_arr[nbr_local_index] = dist_arr[local_index] + 1;
+        hpa->queue_arr[queue_end++] = nbr_local_index;
+      }
+    }
+  }
+}
+
+static size_t ge_hpa_find_node(const ge_hpa_t* hpa, size_t cluster_index, size_t index)
+{
+  const ge_hpa_cluster_t* const cluster = &hpa->cluster_arr[cluster_index];
+  for (size_t ii = 0; ii < cluster->num_nodes; ++ii) {
+    if (cluster->node_index_arr[ii] == index) {
+      return ii;
+    }
+  }
+  return SIZE_MAX;
+}
+
+static bool ge_hpa_can_step(const ge_hpa_t* hpa, ge_coord_t coord, ge_mz_con_t con)
+{
+  const ge_coord_t nbr_coord = ge_hpa_get_nbr_coord(coord, con);
+  if (!ge_coord_within(nbr_coord, hpa->width, hpa->height)) {
+    return false;
+  }
+  if (hpa->mz_grid != NULL) {
+    return ge_mz_grid_has_con_at_coord(hpa->mz_grid, coord, con);
+  }
+  return ge_hpa_is_walkable(hpa, coord) && ge_hpa_is_walkable(hpa, nbr_coord);
+}
+
+static bool ge_hpa_is_walkable(const ge_hpa_t* hpa, ge_coord_t coord)
+{
+  // Every cell of a maze is walkable, even if it's not connected to anything
+  if (hpa->mz_grid != NULL) {
+    return true;
+  }
+  return hpa->pixel_arr[hpa->width * coord.y + coord.x] != 0;
+}
+
+static size_t ge_hpa_get_cluster_index(const ge_hpa_t* hpa, ge_coord_t coord)
+{
+  return hpa->num_clusters_x * (coord.y / hpa->cluster_size) + coord.x / hpa->cluster_size;
+}
+
+static ge_coord_t ge_hpa_get_cluster_origin(const ge_hpa_t* hpa, size_t cluster_index)
+{
+  return (ge_coord_t){(cluster_index % hpa->num_clusters_x) * hpa->cluster_size,
+                      (cluster_index / hpa->num_clusters_x) * hpa->cluster_size};
+}
+
+static size_t ge_hpa_get_local_index(const ge_hpa_t* hpa, size_t cluster_index, ge_coord_t coord)
+{
+  const ge_coord_t origin = ge_hpa_get_cluster_origin(hpa, cluster_index);
+  return hpa->cluster_size * (coord.y - origin.y) + (coord.x - origin.x);
+}
+
+static ge_coord_t ge_hpa_index_to_coord(const ge_hpa_t* hpa, size_t index)
+{
+  return (ge_coord_t){index % hpa->width, index / hpa->width};
+}
+
+static ge_coord_t ge_hpa_get_nbr_coord(ge_coord_t coord, ge_mz_con_t con)
+{
+  // This is called a lot, so avoid going through the directions
+  static const ge_coord_t con_offsets[GE_MZ_NUM_CONS] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
+  return (ge_coord_t){coord.x + con_offsets[con].x, coord.y + con_offsets[con].y};
+}
+
+static void ge_hpa_next_generation(ge_hpa_t* hpa)
+{
+  // Old generations would be misinterpreted after wrapping around
+  if (hpa->generation == UINT32_MAX) {
+    memset(hpa->seen_gen_arr, 0, hpa->width * hpa->height * sizeof(uint32_t));
+    memset(hpa->closed_gen_arr, 0, hpa->width * hpa->height * sizeof(uint32_t));
+    hpa->generation = 0;
+  }
+  ++hpa->generation;
+}
+
+static size_t ge_hpa_get_heuristic(const ge_hpa_t* hpa, size_t index, size_t other_index)
+{
+  const ge_coord_t coord = ge_hpa_index_to_coord(hpa, index);
+  const ge_coord_t other_coord = ge_hpa_index_to_coord(hpa, other_index);
+  return pd_abs(coord.x - other_coord.x) + pd_abs(coord.y - other_coord.y);
+}
+
+static size_t ge_hpa_get_priority(size_t cost, size_t heuristic)
+{
+  // Break ties in favor of the lowest heuristic, which avoids expanding lots of equally good paths
+  const size_t tie_breaker =
+      (heuristic < GE_HPA_TIE_BREAKER_MASK ? heuristic : GE_HPA_TIE_BREAKER_MASK);
+  return ((cost + heuristic) << GE_HPA_TIE_BREAKER_BITS) | tie_breaker;
+}
+
+static void abort_on_coord_out_of_bounds(const ge_hpa_t* hpa, ge_coord_t coord)
+{
+  if (!ge_coord_within(coord, hpa->width, hpa->height)) {
+    GE_LOG_ERROR("Coord is out of bounds! (%li, %li)", coord.x, coord.y);
+    abort();
+  }
+}
+
+static void abort_on_invalid_cluster_size(size_t cluster_size)
+{
+  if (cluster_size == 0) {
+    GE_LOG_ERROR("Cluster size must not be zero!");
+    abort();
+  }
+}
+
+static ptrdiff_t pd_abs(ptrdiff_t v)
+{
+  return (v > 0 ? v : -v);
+}
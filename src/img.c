@@ -6,14 +6,260 @@
 #include "grid_engine/img.h"
 
 #include <SDL2/SDL_image.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "grid_engine/grid.h"
 #include "grid_engine/log.h"
-#include "grid_engine/palette.h"
+#include "grid_engine/quant.h"
+#include "grid_engine/raw.h"
 
-static ge_color_t pixel_rbga(uint32_t tex_pixel);
+// Rec. 709 luma coefficients in 16-bit fixed point, which add up to exactly 1.0
+#define GE_IMG_RED_WEIGHT 13933
+#define GE_IMG_GREEN_WEIGHT 46871
+#define GE_IMG_BLUE_WEIGHT 4732
+
+// Strips smaller than this aren't worth splitting between workers
+static const size_t GE_IMG_MIN_PARALLEL_NUM_PIXELS = 1 << 18;
+// Images are converted in strips of about this many pixels, which is 4 MiB as RGBA
+static const size_t GE_IMG_STRIP_NUM_PIXELS = 1 << 20;
+
+// Reads an image from top to bottom, a strip of rows at a time
+typedef struct ge_img_reader {
+  size_t width;
+  size_t height;
+  // Binary PGM and PPM files are decoded as they are read
+  SDL_RWops* rw;
+  size_t num_channels;
+  size_t max_value;
+  // Anything else is decoded by SDL_image all at once
+  SDL_Surface* sdl_surface;
+  size_t next_row;
+} ge_img_reader_t;
+
+typedef struct ge_img_saver {
+  SDL_Thread* thread;
+  SDL_atomic_t is_busy;
+  // Everything below is only used by the thread while a save is in progress
+  bool is_saved;
+  ge_grid_t* snapshot_grid;
+  char* filename;
+  ge_img_format_t format;
+  bool has_palette;
+  ge_palette_t palette;
+} ge_img_saver_t;
+
+typedef struct ge_img_convert_data {
+  const uint8_t* rgba_pixel_arr;
+  size_t pitch;
+  uint8_t* pixel_arr;
+  size_t width;
+  size_t height;
+  size_t num_tasks;
+} ge_img_convert_data_t;
+
+static SDL_Surface* ge_img_load_rgba_surface(const char* filename);
+static bool ge_img_save_png(const ge_grid_t* grid, const char* filename,
+                            const ge_palette_t* palette);
+static int ge_img_saver_main(void* data);
+static bool ge_img_reader_open(ge_img_reader_t* reader, const char* filename);
+static bool ge_img_reader_open_pnm(ge_img_reader_t* reader, const char* filename);
+static bool ge_img_reader_read(ge_img_reader_t* reader, uint8_t* rgba_pixel_arr, size_t num_rows);
+static void ge_img_reader_close(ge_img_reader_t* reader);
+static bool ge_img_read_pnm_value(SDL_RWops* rw, size_t* value);
+static void ge_img_convert(const uint8_t* rgba_pixel_arr, uint8_t* pixel_arr, size_t width,
+                           size_t height, ge_pool_t* pool);
+static void ge_img_convert_task(size_t task_index, void* user_data);
+static void ge_img_convert_row(const uint8_t* rgba_pixel_row, uint8_t* pixel_row, size_t width);
 
 ge_grid_t* ge_img_load(const char* filename)
+{
+  return ge_img_load_with_pool(filename, NULL);
+}
+
+ge_grid_t* ge_img_load_with_pool(const char* filename, ge_pool_t* pool)
+{
+  ge_img_reader_t reader;
+  if (!ge_img_reader_open(&reader, filename)) {
+    return NULL;
+  }
+  const size_t width = reader.width;
+  const size_t height = reader.height;
+  const size_t strip_height =
+      (width < GE_IMG_STRIP_NUM_PIXELS ? GE_IMG_STRIP_NUM_PIXELS / width : 1);
+  ge_grid_t* const grid = ge_grid_create(width, height);
+  uint8_t* const rgba_pixel_arr = malloc(4 * width * strip_height);
+  if (grid == NULL || rgba_pixel_arr == NULL) {
+    free(rgba_pixel_arr);
+    ge_grid_free(grid);
+    ge_img_reader_close(&reader);
+    return NULL;
+  }
+  // Each strip is converted straight into the grid
+  uint8_t* const pixel_arr = ge_grid_get_pixel_arr_mut(grid);
+  bool is_read = true;
+  for (size_t jj = 0; jj < height && is_read; jj += strip_height) {
+    const size_t num_rows = (height - jj < strip_height ? height - jj : strip_height);
+    is_read = ge_img_reader_read(&reader, rgba_pixel_arr, num_rows);
+    if (is_read) {
+      ge_img_convert(rgba_pixel_arr, pixel_arr + width * jj, width, num_rows, pool);
+    }
+  }
+  free(rgba_pixel_arr);
+  ge_img_reader_close(&reader);
+  if (!is_read) {
+    ge_grid_free(grid);
+    return NULL;
+  }
+  return grid;
+}
+
+ge_tl_grid_t* ge_img_load_tl(const char* filename, const char* tl_filename, size_t tile_size,
+                             size_t num_cached_tiles, ge_pool_t* pool)
+{
+  ge_img_reader_t reader;
+  if (!ge_img_reader_open(&reader, filename)) {
+    return NULL;
+  }
+  const size_t width = reader.width;
+  const size_t height = reader.height;
+  ge_tl_grid_t* const tl_grid =
+      ge_tl_grid_create(tl_filename, width, height, tile_size, num_cached_tiles);
+  // Strips are a row of tiles, so every tile is written once, all at once
+  ge_grid_t* const strip_grid = ge_grid_create(width, tile_size);
+  uint8_t* const rgba_pixel_arr = malloc(4 * width * tile_size);
+  if (tl_grid == NULL || strip_grid == NULL || rgba_pixel_arr == NULL) {
+    free(rgba_pixel_arr);
+    ge_grid_free(strip_grid);
+    ge_tl_grid_free(tl_grid);
+    ge_img_reader_close(&reader);
+    return NULL;
+  }
+  bool is_read = true;
+  for (size_t jj = 0; jj < height && is_read; jj += tile_size) {
+    const size_t num_rows = (height - jj < tile_size ? height - jj : tile_size);
+    is_read = ge_img_reader_read(&reader, rgba_pixel_arr, num_rows);
+    if (is_read) {
+      ge_img_convert(rgba_pixel_arr, ge_grid_get_pixel_arr_mut(strip_grid), width, num_rows, pool);
+      const ge_rect_t strip_rect = ge_rect_from_coord_wh((ge_coord_t){0, 0}, width, num_rows);
+      ge_tl_grid_blit_rect(tl_grid, strip_grid, strip_rect, (ge_coord_t){0, jj});
+    }
+  }
+  free(rgba_pixel_arr);
+  ge_grid_free(strip_grid);
+  ge_img_reader_close(&reader);
+  if (!is_read) {
+    ge_tl_grid_free(tl_grid);
+    return NULL;
+  }
+  return tl_grid;
+}
+
+ge_grid_t* ge_img_load_color(const char* filename, ge_quant_dither_t dither, ge_pool_t* pool,
+                             ge_palette_t* palette)
+{
+  SDL_Surface* const sdl_surface = ge_img_load_rgba_surface(filename);
+  if (sdl_surface == NULL) {
+    return NULL;
+  }
+  ge_grid_t* const grid = ge_grid_create(sdl_surface->w, sdl_surface->h);
+  if (grid == NULL
+      || !ge_quant_build_palette(sdl_surface->pixels, sdl_surface->pitch, sdl_surface->w,
+                                 sdl_surface->h, pool, palette)
+      || !ge_quant_map(sdl_surface->pixels, sdl_surface->pitch, palette, dither, pool, grid)) {
+    ge_grid_free(grid);
+    SDL_FreeSurface(sdl_surface);
+    return NULL;
+  }
+  SDL_FreeSurface(sdl_surface);
+  return grid;
+}
+
+bool ge_img_save(const ge_grid_t* grid, const char* filename, ge_img_format_t format,
+                 const ge_palette_t* palette)
+{
+  if (format == GE_IMG_FORMAT_RAW) {
+    return ge_raw_save(grid, filename);
+  }
+  return ge_img_save_png(grid, filename, palette);
+}
+
+ge_img_saver_t* ge_img_saver_create(void)
+{
+  ge_img_saver_t* saver = calloc(1, sizeof(ge_img_saver_t));
+  if (saver == NULL) {
+    return NULL;
+  }
+  saver->is_saved = true;
+  return saver;
+}
+
+void ge_img_saver_free(ge_img_saver_t* saver)
+{
+  if (saver == NULL) {
+    return;
+  }
+  ge_img_saver_wait(saver);
+  ge_grid_free(saver->snapshot_grid);
+  free(saver->filename);
+  free(saver);
+}
+
+bool ge_img_saver_save(ge_img_saver_t* saver, const ge_grid_t* grid, const char* filename,
+                       ge_img_format_t format, const ge_palette_t* palette)
+{
+  ge_img_saver_wait(saver);
+  // Only the snapshot is taken here, which is just a copy, so the caller isn't held up
+  const size_t width = ge_grid_get_width(grid);
+  const size_t height = ge_grid_get_height(grid);
+  if (saver->snapshot_grid == NULL || ge_grid_get_width(saver->snapshot_grid) != width
+      || ge_grid_get_height(saver->snapshot_grid) != height) {
+    ge_grid_free(saver->snapshot_grid);
+    saver->snapshot_grid = ge_grid_create(width, height);
+    if (saver->snapshot_grid == NULL) {
+      return false;
+    }
+  }
+  const size_t filename_size = strlen(filename) + 1;
+  char* const filename_copy = realloc(saver->filename, filename_size);
+  if (filename_copy == NULL) {
+    return false;
+  }
+  memcpy(filename_copy, filename, filename_size);
+  saver->filename = filename_copy;
+  ge_grid_copy_pixel_arr(saver->snapshot_grid, grid);
+  saver->format = format;
+  saver->has_palette = (palette != NULL);
+  if (palette != NULL) {
+    saver->palette = *palette;
+  }
+  SDL_AtomicSet(&saver->is_busy, 1);
+  saver->thread = SDL_CreateThread(ge_img_saver_main, "ge_img_saver", saver);
+  if (saver->thread == NULL) {
+    GE_LOG_ERROR("Failed to create thread: %s", SDL_GetError());
+    SDL_AtomicSet(&saver->is_busy, 0);
+    return false;
+  }
+  return true;
+}
+
+bool ge_img_saver_is_busy(ge_img_saver_t* saver)
+{
+  return SDL_AtomicGet(&saver->is_busy) != 0;
+}
+
+bool ge_img_saver_wait(ge_img_saver_t* saver)
+{
+  if (saver->thread != NULL) {
+    SDL_WaitThread(saver->thread, NULL);
+    saver->thread = NULL;
+  }
+  return saver->is_saved;
+}
+
+static SDL_Surface* ge_img_load_rgba_surface(const char* filename)
 {
   SDL_Surface* const sdl_load_surface = IMG_Load(filename);
   if (sdl_load_surface == NULL) {
@@ -21,59 +267,240 @@ ge_grid_t* ge_img_load(const char* filename)
     GE_LOG_ERROR("SDL image error: %s", IMG_GetError());
     return NULL;
   }
-  // Convert to a predetermined format
+  // Convert to a format with the same byte order on every platform
   SDL_Surface* const sdl_surface =
-      SDL_ConvertSurfaceFormat(sdl_load_surface, SDL_PIXELFORMAT_RGBA8888, 0);
+      SDL_ConvertSurfaceFormat(sdl_load_surface, SDL_PIXELFORMAT_RGBA32, 0);
   SDL_FreeSurface(sdl_load_surface);
+  return sdl_surface;
+}
+
+static bool ge_img_save_png(const ge_grid_t* grid, const char* filename,
+                            const ge_palette_t* palette)
+{
+  // Pixel values are used as palette indices, so they are saved exactly
+  const size_t width = ge_grid_get_width(grid);
+  const size_t height = ge_grid_get_height(grid);
+  SDL_Surface* const sdl_surface =
+      SDL_CreateRGBSurfaceWithFormat(0, width, height, 8, SDL_PIXELFORMAT_INDEX8);
   if (sdl_surface == NULL) {
-    return NULL;
+    GE_LOG_ERROR("Failed to create surface! %s", SDL_GetError());
+    return false;
   }
-  // Convert the surface to a grid, converting to grayscale, ignoring alpha
-  ge_grid_t* const grid = ge_grid_create(sdl_surface->w, sdl_surface->h);
-  if (grid == NULL) {
-    SDL_FreeSurface(sdl_surface);
-    return NULL;
+  SDL_Color sdl_color_arr[256];
+  for (size_t ii = 0; ii < 256; ++ii) {
+    const ge_color_t gray_color = {.red = ii, .blue = ii, .green = ii};
+    const ge_color_t color = (palette != NULL ? palette->colormap[ii] : gray_color);
+    sdl_color_arr[ii] = (SDL_Color){color.red, color.green, color.blue, 255};
   }
-  uint8_t* const tex_pixel_arr = sdl_surface->pixels;
-  for (size_t jj = 0; jj < (size_t) sdl_surface->h; ++jj) {
-    uint32_t* const tex_pixel_row = (uint32_t*) &tex_pixel_arr[sdl_surface->pitch * jj];
-    for (size_t ii = 0; ii < (size_t) sdl_surface->w; ++ii) {
-      uint32_t* const tex_pixel = &tex_pixel_row[ii];
-      const ge_color_t pixel_color = pixel_rbga(*tex_pixel);
-      // Convert pixel to grayscale using Rec. 709 coefficients (round by adding 0.5)
-      const uint8_t pixel_value = (0.2126f * pixel_color.red + 0.7152f * pixel_color.green
-                                   + 0.0722f * pixel_color.blue + 0.5f);
-      ge_grid_set_coord(grid, (ge_coord_t){ii, jj}, pixel_value);
-    }
+  SDL_SetPaletteColors(sdl_surface->format->palette, sdl_color_arr, 0, 256);
+  const uint8_t* const pixel_arr = ge_grid_get_pixel_arr(grid);
+  uint8_t* const surface_pixel_arr = sdl_surface->pixels;
+  for (size_t jj = 0; jj < height; ++jj) {
+    memcpy(surface_pixel_arr + sdl_surface->pitch * jj, pixel_arr + width * jj, width);
+  }
+  const bool is_saved = (IMG_SavePNG(sdl_surface, filename) == 0);
+  if (!is_saved) {
+    GE_LOG_ERROR("Failed to save image! %s", IMG_GetError());
   }
   SDL_FreeSurface(sdl_surface);
-  return grid;
+  return is_saved;
 }
 
-#if SDL_BYTEORDER == SDL_LIL_ENDIAN
-#define RGBA_R_SHIFT 24
-#define RGBA_B_SHIFT 16
-#define RGBA_G_SHIFT 8
-#define RGBA_A_SHIFT 0
-#else
-#define RGBA_R_SHIFT 0
-#define RGBA_B_SHIFT 8
-#define RGBA_G_SHIFT 16
-#define RGBA_A_SHIFT 24
-#endif
-
-static ge_color_t pixel_rbga(uint32_t tex_pixel)
-{
-  // Assumes texture format is SDL_PIXELFORMAT_RGBA8888. The conversion does not
-  // handle alpha, and completely ignores it in the conversion.
-  ge_color_t pixel_color;
-  pixel_color.red = (tex_pixel >> RGBA_R_SHIFT) & 0xFF;
-  pixel_color.green = (tex_pixel >> RGBA_G_SHIFT) & 0xFF;
-  pixel_color.blue = (tex_pixel >> RGBA_B_SHIFT) & 0xFF;
-  return pixel_color;
-}
-
-#undef RGBA_R_SHIFT
-#undef RGBA_G_SHIFT
-#undef RGBA_B_SHIFT
-#undef RGBA_A_SHIFT
+static int ge_img_saver_main(void* data)
+{
+  ge_img_saver_t* const saver = data;
+  saver->is_saved = ge_img_save(saver->snapshot_grid, saver->filename, saver->format,
+                                (saver->has_palette ? &saver->palette : NULL));
+  SDL_AtomicSet(&saver->is_busy, 0);
+  return 0;
+}
+
+static bool ge_img_reader_open(ge_img_reader_t* reader, const char* filename)
+{
+  *reader = (ge_img_reader_t){0};
+  if (ge_img_reader_open_pnm(reader, filename)) {
+    return true;
+  }
+  reader->sdl_surface = IMG_Load(filename);
+  if (reader->sdl_surface == NULL) {
+    GE_LOG_ERROR("Grid engine failed to load image!");
+    GE_LOG_ERROR("SDL image error: %s", IMG_GetError());
+    return false;
+  }
+  // Strips can't be converted from formats smaller than a byte, so convert those all at once
+  if (SDL_ISPIXELFORMAT_INDEXED(reader->sdl_surface->format->format)
+      && reader->sdl_surface->format->format != SDL_PIXELFORMAT_INDEX8) {
+    SDL_Surface* const sdl_surface =
+        SDL_ConvertSurfaceFormat(reader->sdl_surface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(reader->sdl_surface);
+    reader->sdl_surface = sdl_surface;
+    if (sdl_surface == NULL) {
+      return false;
+    }
+  }
+  reader->width = reader->sdl_surface->w;
+  reader->height = reader->sdl_surface->h;
+  return true;
+}
+
+static bool ge_img_reader_open_pnm(ge_img_reader_t* reader, const char* filename)
+{
+  SDL_RWops* const rw = SDL_RWFromFile(filename, "rb");
+  if (rw == NULL) {
+    return false;
+  }
+  // Only 8-bit binary files are read here, anything else is left to SDL_image
+  char magic[2];
+  size_t max_value = 0;
+  if (SDL_RWread(rw, magic, 1, sizeof(magic)) != sizeof(magic) || magic[0] != 'P'
+      || (magic[1] != '5' && magic[1] != '6') || !ge_img_read_pnm_value(rw, &reader->width)
+      || !ge_img_read_pnm_value(rw, &reader->height) || !ge_img_read_pnm_value(rw, &max_value)
+      || reader->width == 0 || reader->height == 0 || max_value == 0 || max_value > 255) {
+    SDL_RWclose(rw);
+    return false;
+  }
+  reader->rw = rw;
+  reader->num_channels = (magic[1] == '5' ? 1 : 3);
+  reader->max_value = max_value;
+  return true;
+}
+
+static bool ge_img_reader_read(ge_img_reader_t* reader, uint8_t* rgba_pixel_arr, size_t num_rows)
+{
+  const size_t width = reader->width;
+  const size_t begin_row = reader->next_row;
+  reader->next_row += num_rows;
+  if (reader->rw != NULL) {
+    for (size_t jj = 0; jj < num_rows; ++jj) {
+      // Read the row into the start of the RGBA row, then spread it out from the end, so no
+      // channel is overwritten before it's read
+      uint8_t* const rgba_pixel_row = rgba_pixel_arr + 4 * width * jj;
+      const size_t num_channels = reader->num_channels;
+      const size_t row_size = num_channels * width;
+      if (SDL_RWread(reader->rw, rgba_pixel_row, 1, row_size) != row_size) {
+        GE_LOG_ERROR("Failed to read image! %s", SDL_GetError());
+        return false;
+      }
+      const size_t max_value = reader->max_value;
+      for (size_t ii = width; ii-- > 0;) {
+        uint8_t rgb_arr[3];
+        for (size_t kk = 0; kk < 3; ++kk) {
+          const size_t value = rgba_pixel_row[num_channels * ii + (num_channels == 3 ? kk : 0)];
+          rgb_arr[kk] = (max_value == 255 ? value : (255 * value + max_value / 2) / max_value);
+        }
+        rgba_pixel_row[4 * ii] = rgb_arr[0];
+        rgba_pixel_row[4 * ii + 1] = rgb_arr[1];
+        rgba_pixel_row[4 * ii + 2] = rgb_arr[2];
+        rgba_pixel_row[4 * ii + 3] = 255;
+      }
+    }
+    return true;
+  }
+  SDL_Surface* const sdl_surface = reader->sdl_surface;
+  const uint8_t* const surface_pixel_arr =
+      (const uint8_t*) sdl_surface->pixels + sdl_surface->pitch * begin_row;
+  if (sdl_surface->format->format == SDL_PIXELFORMAT_INDEX8) {
+    // SDL can't convert indexed pixels without a whole surface, so look up the palette here
+    const SDL_Color* const sdl_color_arr = sdl_surface->format->palette->colors;
+    for (size_t jj = 0; jj < num_rows; ++jj) {
+      const uint8_t* const surface_pixel_row = surface_pixel_arr + sdl_surface->pitch * jj;
+      uint8_t* const rgba_pixel_row = rgba_pixel_arr + 4 * width * jj;
+      for (size_t ii = 0; ii < width; ++ii) {
+        const SDL_Color sdl_color = sdl_color_arr[surface_pixel_row[ii]];
+        rgba_pixel_row[4 * ii] = sdl_color.r;
+        rgba_pixel_row[4 * ii + 1] = sdl_color.g;
+        rgba_pixel_row[4 * ii + 2] = sdl_color.b;
+        rgba_pixel_row[4 * ii + 3] = sdl_color.a;
+      }
+    }
+    return true;
+  }
+  if (SDL_ConvertPixels(width, num_rows, sdl_surface->format->format, surface_pixel_arr,
+                        sdl_surface->pitch, SDL_PIXELFORMAT_RGBA32, rgba_pixel_arr, 4 * width)
+      != 0) {
+    GE_LOG_ERROR("Failed to convert image! %s", SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+static void ge_img_reader_close(ge_img_reader_t* reader)
+{
+  if (reader->rw != NULL) {
+    SDL_RWclose(reader->rw);
+  }
+  if (reader->sdl_surface != NULL) {
+    SDL_FreeSurface(reader->sdl_surface);
+  }
+}
+
+static bool ge_img_read_pnm_value(SDL_RWops* rw, size_t* value)
+{
+  // Skip whitespace and comments before the value
+  char byte = ' ';
+  bool is_comment = false;
+  while (is_comment || byte == ' ' || byte == '\t' || byte == '\r' || byte == '\n'
+         || byte == '#') {
+    is_comment = (byte == '#' || (is_comment && byte != '\n'));
+    if (SDL_RWread(rw, &byte, 1, 1) != 1) {
+      return false;
+    }
+  }
+  // Just one byte of whitespace follows the value, which is read along with it
+  *value = 0;
+  size_t num_digits = 0;
+  while (byte >= '0' && byte <= '9') {
+    if (*value > (SIZE_MAX - 9) / 10) {
+      return false;
+    }
+    *value = 10 * *value + (byte - '0');
+    ++num_digits;
+    if (SDL_RWread(rw, &byte, 1, 1) != 1) {
+      return false;
+    }
+  }
+  return (num_digits != 0 && (byte == ' ' || byte == '\t' || byte == '\r' || byte == '\n'));
+}
+
+static void ge_img_convert(const uint8_t* rgba_pixel_arr, uint8_t* pixel_arr, size_t width,
+                           size_t height, ge_pool_t* pool)
+{
+  // Convert to grayscale, ignoring alpha, splitting big strips into bands of rows
+  const bool is_parallel = (pool != NULL && width * height >= GE_IMG_MIN_PARALLEL_NUM_PIXELS);
+  ge_img_convert_data_t convert_data = {
+      .rgba_pixel_arr = rgba_pixel_arr,
+      .pitch = 4 * width,
+      .pixel_arr = pixel_arr,
+      .width = width,
+      .height = height,
+      .num_tasks = (is_parallel ? 4 * (ge_pool_get_num_workers(pool) + 1) : 1),
+  };
+  ge_pool_run((is_parallel ? pool : NULL), ge_img_convert_task, &convert_data,
+              convert_data.num_tasks);
+}
+
+static void ge_img_convert_task(size_t task_index, void* user_data)
+{
+  const ge_img_convert_data_t* const convert_data = user_data;
+  const size_t height = convert_data->height;
+  const size_t num_tasks = convert_data->num_tasks;
+  const size_t begin_row = height * task_index / num_tasks;
+  const size_t end_row = height * (task_index + 1) / num_tasks;
+  for (size_t jj = begin_row; jj < end_row; ++jj) {
+    ge_img_convert_row(convert_data->rgba_pixel_arr + convert_data->pitch * jj,
+                       convert_data->pixel_arr + convert_data->width * jj, convert_data->width);
+  }
+}
+
+static void ge_img_convert_row(const uint8_t* rgba_pixel_row, uint8_t* pixel_row, size_t width)
+{
+  // Integer math with no branches, so compilers can vectorize the loop
+  for (size_t ii = 0; ii < width; ++ii) {
+    const uint32_t red = rgba_pixel_row[4 * ii];
+    const uint32_t green = rgba_pixel_row[4 * ii + 1];
+    const uint32_t blue = rgba_pixel_row[4 * ii + 2];
+    pixel_row[ii] = (GE_IMG_RED_WEIGHT * red + GE_IMG_GREEN_WEIGHT * green
+                     + GE_IMG_BLUE_WEIGHT * blue + (1 << 15))
+                    >> 16;
+  }
+}
@@ -9,7 +9,8 @@
 
 void ge_log(ge_log_level_t log_level, const char* format, ...)
 {
-  SDL_LogPriority sdl_priority;
+  // Unknown levels are logged as errors
+  SDL_LogPriority sdl_priority = SDL_LOG_PRIORITY_ERROR;
   switch (log_level) {
   case GE_LOG_LEVEL_ERROR:
     sdl_priority = SDL_LOG_PRIORITY_ERROR;
@@ -0,0 +1,235 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/mipmap.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "grid_engine/bitset.h"
+#include "grid_engine/log.h"
+
+// Enough levels for any grid which fits in memory
+#define GE_MIPMAP_MAX_NUM_LEVELS 64
+// Each pixel covers up to 2x2 pixels in the level below
+#define GE_MIPMAP_MAX_NUM_VALUES 4
+
+typedef struct ge_mipmap {
+  const ge_grid_t* source_grid;
+  ge_mipmap_mode_t mode;
+  size_t num_levels;
+  ge_grid_t* level_arr[GE_MIPMAP_MAX_NUM_LEVELS];  // Level 0 is the source grid, so it's unused
+  bool is_built;
+  uint64_t source_generation;
+  // Dirty regions are tracked in tiles of the source grid
+  size_t num_tiles_x;
+  size_t num_tiles_y;
+  ge_bitset_t* dirty_tile_bitset;
+} ge_mipmap_t;
+
+static const size_t GE_MIPMAP_TILE_SIZE = 64;
+
+static void ge_mipmap_build_rect(ge_mipmap_t* mipmap, size_t level, ge_rect_t rect);
+static uint8_t ge_mipmap_reduce(ge_mipmap_mode_t mode, const uint8_t* values, size_t num_values);
+static ge_rect_t ge_mipmap_halve_rect(ge_rect_t rect);
+static void abort_on_level_out_of_bounds(const ge_mipmap_t* mipmap, size_t level);
+
+ge_mipmap_t* ge_mipmap_create(const ge_grid_t* source_grid, ge_mipmap_mode_t mode)
+{
+  ge_mipmap_t* mipmap = calloc(1, sizeof(ge_mipmap_t));
+  if (mipmap == NULL) {
+    return NULL;
+  }
+  mipmap->source_grid = source_grid;
+  mipmap->mode = mode;
+  // Keep halving until the level is a single pixel, rounding up so no pixels are lost
+  size_t width = ge_grid_get_width(source_grid);
+  size_t height = ge_grid_get_height(source_grid);
+  mipmap->num_levels = 1;
+  while (width > 1 || height > 1) {
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+    mipmap->level_arr[mipmap->num_levels] = ge_grid_create(width, height);
+    if (mipmap->level_arr[mipmap->num_levels] == NULL) {
+      ge_mipmap_free(mipmap);
+      return NULL;
+    }
+    ++mipmap->num_levels;
+  }
+  const size_t tile_size = GE_MIPMAP_TILE_SIZE;
+  mipmap->num_tiles_x = (ge_grid_get_width(source_grid) + tile_size - 1) / tile_size;
+  mipmap->num_tiles_y = (ge_grid_get_height(source_grid) + tile_size - 1) / tile_size;
+  mipmap->dirty_tile_bitset = ge_bitset_create(mipmap->num_tiles_x * mipmap->num_tiles_y);
+  if (mipmap->dirty_tile_bitset == NULL) {
+    ge_mipmap_free(mipmap);
+    return NULL;
+  }
+  return mipmap;
+}
+
+void ge_mipmap_free(ge_mipmap_t* mipmap)
+{
+  if (mipmap == NULL) {
+    return;
+  }
+  for (size_t ii = 1; ii < mipmap->num_levels; ++ii) {
+    ge_grid_free(mipmap->level_arr[ii]);
+  }
+  ge_bitset_free(mipmap->dirty_tile_bitset);
+  free(mipmap);
+}
+
+ge_mipmap_mode_t ge_mipmap_get_mode(const ge_mipmap_t* mipmap)
+{
+  return mipmap->mode;
+}
+
+size_t ge_mipmap_get_num_levels(const ge_mipmap_t* mipmap)
+{
+  return mipmap->num_levels;
+}
+
+const ge_grid_t* ge_mipmap_get_level(const ge_mipmap_t* mipmap, size_t level)
+{
+  abort_on_level_out_of_bounds(mipmap, level);
+  return (level == 0 ? mipmap->source_grid : mipmap->level_arr[level]);
+}
+
+void ge_mipmap_set_mode(ge_mipmap_t* mipmap, ge_mipmap_mode_t mode)
+{
+  if (mode != mipmap->mode) {
+    mipmap->mode = mode;
+    mipmap->is_built = false;
+  }
+}
+
+void ge_mipmap_mark_dirty(ge_mipmap_t* mipmap, ge_rect_t rect)
+{
+  const ge_rect_t overlap_rect = ge_rect_overlap(ge_grid_get_rect(mipmap->source_grid), rect);
+  if (overlap_rect.min_coord.x >= overlap_rect.max_coord.x
+      || overlap_rect.min_coord.y >= overlap_rect.max_coord.y) {
+    return;
+  }
+  const size_t tile_size = GE_MIPMAP_TILE_SIZE;
+  const size_t min_tile_x = overlap_rect.min_coord.x / tile_size;
+  const size_t min_tile_y = overlap_rect.min_coord.y / tile_size;
+  const size_t max_tile_x = (overlap_rect.max_coord.x - 1) / tile_size;
+  const size_t max_tile_y = (overlap_rect.max_coord.y - 1) / tile_size;
+  for (size_t jj = min_tile_y; jj <= max_tile_y; ++jj) {
+    const size_t row_index = mipmap->num_tiles_x * jj;
+    ge_bitset_set_range(mipmap->dirty_tile_bitset, row_index + min_tile_x,
+                        row_index + max_tile_x + 1, true);
+  }
+}
+
+void ge_mipmap_update(ge_mipmap_t* mipmap)
+{
+  const uint64_t source_generation = ge_grid_get_generation(mipmap->source_grid);
+  const bool has_dirty_tiles = ge_bitset_has_any(mipmap->dirty_tile_bitset);
+  if (!mipmap->is_built || (source_generation != mipmap->source_generation && !has_dirty_tiles)) {
+    // Changes weren't marked, so everything has to be rebuilt
+    for (size_t ii = 1; ii < mipmap->num_levels; ++ii) {
+      ge_mipmap_build_rect(mipmap, ii, ge_grid_get_rect(mipmap->level_arr[ii]));
+    }
+  }
+  else if (has_dirty_tiles) {
+    // Rebuild the part of each level above each dirty tile
+    const size_t tile_size = GE_MIPMAP_TILE_SIZE;
+    const ge_rect_t source_rect = ge_grid_get_rect(mipmap->source_grid);
+    size_t tile_index = GE_BITSET_SEARCH_INIT;
+    while ((tile_index = ge_bitset_search(mipmap->dirty_tile_bitset, tile_index))
+           != GE_BITSET_SEARCH_INIT) {
+      const ge_coord_t tile_coord = {(tile_index % mipmap->num_tiles_x) * tile_size,
+                                     (tile_index / mipmap->num_tiles_x) * tile_size};
+      ge_rect_t rect =
+          ge_rect_overlap(source_rect, ge_rect_from_coord_wh(tile_coord, tile_size, tile_size));
+      for (size_t ii = 1; ii < mipmap->num_levels; ++ii) {
+        rect = ge_mipmap_halve_rect(rect);
+        ge_mipmap_build_rect(mipmap, ii, rect);
+      }
+    }
+  }
+  ge_bitset_set_range(mipmap->dirty_tile_bitset, 0, ge_bitset_get_size(mipmap->dirty_tile_bitset),
+                      false);
+  mipmap->is_built = true;
+  mipmap->source_generation = source_generation;
+}
+
+static void ge_mipmap_build_rect(ge_mipmap_t* mipmap, size_t level, ge_rect_t rect)
+{
+  const ge_grid_t* const below_grid = ge_mipmap_get_level(mipmap, level - 1);
+  const size_t below_width = ge_grid_get_width(below_grid);
+  const size_t below_height = ge_grid_get_height(below_grid);
+  const uint8_t* const below_pixel_arr = ge_grid_get_pixel_arr(below_grid);
+  ge_grid_t* const grid = mipmap->level_arr[level];
+  const size_t width = ge_grid_get_width(grid);
+  uint8_t* const pixel_arr = ge_grid_get_pixel_arr_mut(grid);
+  for (ptrdiff_t jj = rect.min_coord.y; jj < rect.max_coord.y; ++jj) {
+    for (ptrdiff_t ii = rect.min_coord.x; ii < rect.max_coord.x; ++ii) {
+      // Levels with an odd size have fewer pixels below the last row and column
+      uint8_t values[GE_MIPMAP_MAX_NUM_VALUES] = {0};
+      size_t num_values = 0;
+      for (size_t below_y = 2 * jj; below_y < 2 * (size_t) jj + 2; ++below_y) {
+        for (size_t below_x = 2 * ii; below_x < 2 * (size_t) ii + 2; ++below_x) {
+          if (below_x < below_width && below_y < below_height) {
+            values[num_values++] = below_pixel_arr[below_width * below_y + below_x];
+          }
+        }
+      }
+      pixel_arr[width * jj + ii] = ge_mipmap_reduce(mipmap->mode, values, num_values);
+    }
+  }
+}
+
+static uint8_t ge_mipmap_reduce(ge_mipmap_mode_t mode, const uint8_t* values, size_t num_values)
+{
+  uint8_t result = values[0];
+  if (mode == GE_MIPMAP_MODE_MAX) {
+    // The explicit bound keeps the unrolled loop within the array
+    for (size_t ii = 1; ii < num_values && ii < GE_MIPMAP_MAX_NUM_VALUES; ++ii) {
+      result = (values[ii] > result ? values[ii] : result);
+    }
+  }
+  else if (mode == GE_MIPMAP_MODE_MEAN) {
+    size_t sum = 0;
+    for (size_t ii = 0; ii < num_values; ++ii) {
+      sum += values[ii];
+    }
+    result = (sum + num_values / 2) / num_values;
+  }
+  else {
+    // Ties go to the largest value, so sparse details survive as well as they can
+    size_t best_count = 0;
+    for (size_t ii = 0; ii < num_values; ++ii) {
+      size_t count = 0;
+      for (size_t jj = 0; jj < num_values; ++jj) {
+        count += (values[jj] == values[ii]);
+      }
+      if (count > best_count || (count == best_count && values[ii] > result)) {
+        best_count = count;
+        result = values[ii];
+      }
+    }
+  }
+  return result;
+}
+
+static ge_rect_t ge_mipmap_halve_rect(ge_rect_t rect)
+{
+  // Round outwards, so the rect covers every pixel above the original rect
+  return (ge_rect_t){
+      {rect.min_coord.x / 2, rect.min_coord.y / 2},
+      {(rect.max_coord.x + 1) / 2, (rect.max_coord.y + 1) / 2},
+  };
+}
+
+static void abort_on_level_out_of_bounds(const ge_mipmap_t* mipmap, size_t level)
+{
+  if (level >= mipmap->num_levels) {
+    GE_LOG_ERROR("Mipmap level is out of bounds! %zu", level);
+    abort();
+  }
+}
@@ -0,0 +1,417 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/mz_gen.h"
+
+#include <stdlib.h>
+
+#include "grid_engine/bitset.h"
+
+typedef struct ge_mz_eller {
+  size_t width;
+  size_t num_rows;
+  uint64_t rng_state;
+  size_t* set_arr;
+  size_t* parent_arr;
+  size_t* count_arr;
+  size_t* has_down_arr;
+} ge_mz_eller_t;
+
+static bool ge_mz_gen_begin(ge_mz_grid_t* grid);
+static void ge_mz_gen_end(ge_mz_grid_t* grid, bool render_deferred);
+static size_t ge_mz_gen_get_cons(const ge_mz_grid_t* grid, size_t index, ge_mz_con_t* cons);
+static size_t ge_mz_gen_step(const ge_mz_grid_t* grid, size_t index, ge_mz_con_t con);
+static void ge_mz_gen_add_con(ge_mz_grid_t* grid, size_t index, ge_mz_con_t con);
+static size_t find_root(size_t* parent_arr, size_t index);
+static uint64_t next_random(uint64_t* rng_state);
+static size_t next_random_below(uint64_t* rng_state, size_t limit);
+static bool next_random_bool(uint64_t* rng_state);
+
+bool ge_mz_gen_backtracker(ge_mz_grid_t* grid, uint64_t seed)
+{
+  const size_t width = ge_mz_grid_get_width(grid);
+  const size_t size = width * ge_mz_grid_get_height(grid);
+  if (size == 0) {
+    return true;
+  }
+  // The stack holds the connection used to enter each cell, which is enough to backtrack
+  uint8_t* const con_stack = malloc(size * sizeof(uint8_t));
+  if (con_stack == NULL) {
+    return false;
+  }
+  const bool render_deferred = ge_mz_gen_begin(grid);
+  uint64_t rng_state = seed;
+  size_t index = next_random_below(&rng_state, size);
+  size_t con_stack_size = 0;
+  while (true) {
+    // Find neighbors which are still unvisited, e.g., have no connections
+    ge_mz_con_t nbr_cons[GE_MZ_NUM_CONS];
+    const size_t num_nbrs = ge_mz_gen_get_cons(grid, index, nbr_cons);
+    ge_mz_con_t unvisited_cons[GE_MZ_NUM_CONS];
+    size_t num_unvisited = 0;
+    for (size_t ii = 0; ii < num_nbrs; ++ii) {
+      const size_t nbr_index = ge_mz_gen_step(grid, index, nbr_cons[ii]);
+      const ge_coord_t nbr_coord = {nbr_index % width, nbr_index / width};
+      if (ge_mz_grid_has_con_at_coord(grid, nbr_coord, GE_MZ_CON_NONE)) {
+        unvisited_cons[num_unvisited++] = nbr_cons[ii];
+      }
+    }
+    // If all neighbors have been visited, pop the stack to backtrack
+    if (num_unvisited == 0) {
+      if (con_stack_size == 0) {
+        break;
+      }
+      const ge_mz_con_t pop_con = con_stack[--con_stack_size];
+      index = ge_mz_gen_step(grid, index, ge_mz_con_get_opposite(pop_con));
+      continue;
+    }
+    // Otherwise, pick a random direction, push onto the stack
+    const ge_mz_con_t unvisited_con = unvisited_cons[next_random_below(&rng_state, num_unvisited)];
+    ge_mz_gen_add_con(grid, index, unvisited_con);
+    index = ge_mz_gen_step(grid, index, unvisited_con);
+    con_stack[con_stack_size++] = unvisited_con;
+  }
+  ge_mz_gen_end(grid, render_deferred);
+  free(con_stack);
+  return true;
+}
+
+bool ge_mz_gen_kruskal(ge_mz_grid_t* grid, uint64_t seed)
+{
+  const size_t width = ge_mz_grid_get_width(grid);
+  const size_t height = ge_mz_grid_get_height(grid);
+  const size_t size = width * height;
+  if (size == 0) {
+    return true;
+  }
+  // Each wall is stored as the index of the cell, times two, plus one if it's the south wall
+  const size_t max_num_walls = 2 * size;
+  size_t* const wall_arr = malloc(max_num_walls * sizeof(size_t));
+  size_t* const parent_arr = malloc(size * sizeof(size_t));
+  if (wall_arr == NULL || parent_arr == NULL) {
+    free(wall_arr);
+    free(parent_arr);
+    return false;
+  }
+  const bool render_deferred = ge_mz_gen_begin(grid);
+  size_t num_walls = 0;
+  for (size_t jj = 0; jj < height; ++jj) {
+    for (size_t ii = 0; ii < width; ++ii) {
+      const size_t index = width * jj + ii;
+      if (ii + 1 < width) {
+        wall_arr[num_walls++] = 2 * index;
+      }
+      if (jj + 1 < height) {
+        wall_arr[num_walls++] = 2 * index + 1;
+      }
+    }
+  }
+  for (size_t ii = 0; ii < size; ++ii) {
+    parent_arr[ii] = ii;
+  }
+  // Shuffle the walls, then remove walls between cells which are not yet connected
+  uint64_t rng_state = seed;
+  for (size_t ii = num_walls; ii > 1; --ii) {
+    const size_t jj = next_random_below(&rng_state, ii);
+    const size_t wall = wall_arr[ii - 1];
+    wall_arr[ii - 1] = wall_arr[jj];
+    wall_arr[jj] = wall;
+  }
+  size_t num_sets = size;
+  for (size_t ii = 0; ii < num_walls && num_sets > 1; ++ii) {
+    const size_t index = wall_arr[ii] / 2;
+    const ge_mz_con_t con = (wall_arr[ii] % 2 == 0 ? GE_MZ_CON_EAST : GE_MZ_CON_SOUTH);
+    const size_t root = find_root(parent_arr, index);
+    const size_t nbr_root = find_root(parent_arr, ge_mz_gen_step(grid, index, con));
+    if (root == nbr_root) {
+      continue;
+    }
+    parent_arr[nbr_root] = root;
+    --num_sets;
+    ge_mz_gen_add_con(grid, index, con);
+  }
+  ge_mz_gen_end(grid, render_deferred);
+  free(wall_arr);
+  free(parent_arr);
+  return true;
+}
+
+bool ge_mz_gen_wilson(ge_mz_grid_t* grid, uint64_t seed)
+{
+  const size_t size = ge_mz_grid_get_width(grid) * ge_mz_grid_get_height(grid);
+  if (size == 0) {
+    return true;
+  }
+  ge_bitset_t* const maze_bitset = ge_bitset_create(size);
+  uint8_t* const walk_con_arr = malloc(size * sizeof(uint8_t));
+  if (maze_bitset == NULL || walk_con_arr == NULL) {
+    ge_bitset_free(maze_bitset);
+    free(walk_con_arr);
+    return false;
+  }
+  const bool render_deferred = ge_mz_gen_begin(grid);
+  uint64_t rng_state = seed;
+  ge_bitset_set(maze_bitset, next_random_below(&rng_state, size), true);
+  for (size_t start_index = 0; start_index < size; ++start_index) {
+    // Randomly walk until reaching the maze. Only the last way out of each cell is remembered,
+    // which erases any loops in the walk.
+    size_t index = start_index;
+    while (!ge_bitset_get(maze_bitset, index)) {
+      ge_mz_con_t nbr_cons[GE_MZ_NUM_CONS];
+      const size_t num_nbrs = ge_mz_gen_get_cons(grid, index, nbr_cons);
+      const ge_mz_con_t walk_con = nbr_cons[next_random_below(&rng_state, num_nbrs)];
+      walk_con_arr[index] = walk_con;
+      index = ge_mz_gen_step(grid, index, walk_con);
+    }
+    // Follow the walk again, adding it to the maze
+    index = start_index;
+    while (!ge_bitset_get(maze_bitset, index)) {
+      ge_mz_gen_add_con(grid, index, walk_con_arr[index]);
+      ge_bitset_set(maze_bitset, index, true);
+      index = ge_mz_gen_step(grid, index, walk_con_arr[index]);
+    }
+  }
+  ge_mz_gen_end(grid, render_deferred);
+  ge_bitset_free(maze_bitset);
+  free(walk_con_arr);
+  return true;
+}
+
+bool ge_mz_gen_eller(ge_mz_grid_t* grid, uint64_t seed)
+{
+  const size_t width = ge_mz_grid_get_width(grid);
+  const size_t height = ge_mz_grid_get_height(grid);
+  if (width * height == 0) {
+    return true;
+  }
+  ge_mz_eller_t* const eller = ge_mz_eller_create(width, seed);
+  uint8_t* const row_values = malloc(width * sizeof(uint8_t));
+  if (eller == NULL || row_values == NULL) {
+    ge_mz_eller_free(eller);
+    free(row_values);
+    return false;
+  }
+  const bool render_deferred = ge_mz_gen_begin(grid);
+  for (size_t jj = 0; jj < height; ++jj) {
+    ge_mz_eller_next_row(eller, jj + 1 == height, row_values);
+    for (size_t ii = 0; ii < width; ++ii) {
+      const ge_coord_t coord = {ii, jj};
+      const uint8_t prv_value = ge_mz_grid_get_coord(grid, coord);
+      const uint8_t nxt_value = ge_mz_value_set_con(prv_value, GE_MZ_CON_NONE) | row_values[ii];
+      ge_mz_grid_set_coord(grid, coord, nxt_value);
+    }
+  }
+  ge_mz_gen_end(grid, render_deferred);
+  ge_mz_eller_free(eller);
+  free(row_values);
+  return true;
+}
+
+ge_mz_eller_t* ge_mz_eller_create(size_t width, uint64_t seed)
+{
+  ge_mz_eller_t* eller = calloc(1, sizeof(ge_mz_eller_t));
+  if (eller == NULL) {
+    return NULL;
+  }
+  eller->width = width;
+  eller->num_rows = 0;
+  eller->rng_state = seed;
+  // All of the arrays are allocated together, but there's always at least one element
+  const size_t arr_size = (width != 0 ? width : 1);
+  eller->set_arr = calloc(4 * arr_size, sizeof(size_t));
+  if (eller->set_arr == NULL) {
+    free(eller);
+    return NULL;
+  }
+  eller->parent_arr = eller->set_arr + arr_size;
+  eller->count_arr = eller->parent_arr + arr_size;
+  eller->has_down_arr = eller->count_arr + arr_size;
+  for (size_t ii = 0; ii < width; ++ii) {
+    eller->set_arr[ii] = SIZE_MAX;
+  }
+  return eller;
+}
+
+void ge_mz_eller_free(ge_mz_eller_t* eller)
+{
+  if (eller == NULL) {
+    return;
+  }
+  free(eller->set_arr);
+  free(eller);
+}
+
+size_t ge_mz_eller_get_width(const ge_mz_eller_t* eller)
+{
+  return eller->width;
+}
+
+size_t ge_mz_eller_get_num_rows(const ge_mz_eller_t* eller)
+{
+  return eller->num_rows;
+}
+
+void ge_mz_eller_next_row(ge_mz_eller_t* eller, bool is_last_row, uint8_t* row_values)
+{
+  const size_t width = eller->width;
+  size_t* const set_arr = eller->set_arr;
+  size_t* const parent_arr = eller->parent_arr;
+  size_t* const count_arr = eller->count_arr;
+  size_t* const has_down_arr = eller->has_down_arr;
+  ++eller->num_rows;
+  // Sets are named by the position of one of their cells in the previous row. Cells connected from
+  // above stay in the same set, and all other cells start in a set of their own. The count array
+  // is used to map each set to the first cell in this row which belongs to it.
+  for (size_t ii = 0; ii < width; ++ii) {
+    count_arr[ii] = SIZE_MAX;
+  }
+  for (size_t ii = 0; ii < width; ++ii) {
+    const size_t set = set_arr[ii];
+    if (set == SIZE_MAX) {
+      row_values[ii] = 0;
+      parent_arr[ii] = ii;
+      continue;
+    }
+    if (count_arr[set] == SIZE_MAX) {
+      count_arr[set] = ii;
+    }
+    row_values[ii] = ge_mz_con_to_bits(GE_MZ_CON_NORTH);
+    parent_arr[ii] = count_arr[set];
+  }
+  // Randomly join neighboring cells in different sets, but join all of them on the last row
+  for (size_t ii = 0; ii + 1 < width; ++ii) {
+    const size_t root = find_root(parent_arr, ii);
+    const size_t nbr_root = find_root(parent_arr, ii + 1);
+    if (root == nbr_root || !(is_last_row || next_random_bool(&eller->rng_state))) {
+      continue;
+    }
+    parent_arr[nbr_root] = root;
+    row_values[ii] |= ge_mz_con_to_bits(GE_MZ_CON_EAST);
+    row_values[ii + 1] |= ge_mz_con_to_bits(GE_MZ_CON_WEST);
+  }
+  // The last row has no connections down, so the next row starts a new maze
+  if (is_last_row) {
+    for (size_t ii = 0; ii < width; ++ii) {
+      set_arr[ii] = SIZE_MAX;
+    }
+    return;
+  }
+  // Randomly connect cells down, making sure every set gets at least one connection
+  for (size_t ii = 0; ii < width; ++ii) {
+    count_arr[ii] = 0;
+    has_down_arr[ii] = false;
+  }
+  for (size_t ii = 0; ii < width; ++ii) {
+    parent_arr[ii] = find_root(parent_arr, ii);
+    ++count_arr[parent_arr[ii]];
+  }
+  for (size_t ii = 0; ii < width; ++ii) {
+    const size_t root = parent_arr[ii];
+    const bool is_last_in_set = (--count_arr[root] == 0);
+    if (next_random_bool(&eller->rng_state) || (is_last_in_set && !has_down_arr[root])) {
+      row_values[ii] |= ge_mz_con_to_bits(GE_MZ_CON_SOUTH);
+      has_down_arr[root] = true;
+      set_arr[ii] = root;
+    }
+    else {
+      set_arr[ii] = SIZE_MAX;
+    }
+  }
+}
+
+static bool ge_mz_gen_begin(ge_mz_grid_t* grid)
+{
+  // Rendering is deferred during generation, and all connections are removed
+  const bool render_deferred = ge_mz_grid_is_render_deferred(grid);
+  ge_mz_grid_set_render_deferred(grid, true);
+  const size_t width = ge_mz_grid_get_width(grid);
+  const size_t height = ge_mz_grid_get_height(grid);
+  for (size_t jj = 0; jj < height; ++jj) {
+    for (size_t ii = 0; ii < width; ++ii) {
+      ge_mz_grid_set_con_at_coord(grid, (ge_coord_t){ii, jj}, GE_MZ_CON_NONE);
+    }
+  }
+  return render_deferred;
+}
+
+static void ge_mz_gen_end(ge_mz_grid_t* grid, bool render_deferred)
+{
+  ge_mz_grid_set_render_deferred(grid, render_deferred);
+}
+
+static size_t ge_mz_gen_get_cons(const ge_mz_grid_t* grid, size_t index, ge_mz_con_t* cons)
+{
+  // Get the connections which lead to other cells of the grid
+  const size_t width = ge_mz_grid_get_width(grid);
+  const size_t height = ge_mz_grid_get_height(grid);
+  const size_t x = index % width;
+  const size_t y = index / width;
+  size_t num_cons = 0;
+  if (y > 0) {
+    cons[num_cons++] = GE_MZ_CON_NORTH;
+  }
+  if (x + 1 < width) {
+    cons[num_cons++] = GE_MZ_CON_EAST;
+  }
+  if (y + 1 < height) {
+    cons[num_cons++] = GE_MZ_CON_SOUTH;
+  }
+  if (x > 0) {
+    cons[num_cons++] = GE_MZ_CON_WEST;
+  }
+  return num_cons;
+}
+
+static size_t ge_mz_gen_step(const ge_mz_grid_t* grid, size_t index, ge_mz_con_t con)
+{
+  const size_t width = ge_mz_grid_get_width(grid);
+  switch (con) {
+  case GE_MZ_CON_NORTH:
+    return index - width;
+  case GE_MZ_CON_EAST:
+    return index + 1;
+  case GE_MZ_CON_SOUTH:
+    return index + width;
+  case GE_MZ_CON_WEST:
+    return index - 1;
+  default:
+    return index;
+  }
+}
+
+static void ge_mz_gen_add_con(ge_mz_grid_t* grid, size_t index, ge_mz_con_t con)
+{
+  const size_t width = ge_mz_grid_get_width(grid);
+  ge_mz_grid_add_con_at_coord(grid, (ge_coord_t){index % width, index / width}, con);
+}
+
+static size_t find_root(size_t* parent_arr, size_t index)
+{
+  // Union-find with path halving
+  while (parent_arr[index] != index) {
+    parent_arr[index] = parent_arr[parent_arr[index]];
+    index = parent_arr[index];
+  }
+  return index;
+}
+
+static uint64_t next_random(uint64_t* rng_state)
+{
+  // See also: https://prng.di.unimi.it/splitmix64.c
+  uint64_t value = (*rng_state += UINT64_C(0x9E3779B97F4A7C15));
+  value = (value ^ (value >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+  value = (value ^ (value >> 27)) * UINT64_C(0x94D049BB133111EB);
+  return value ^ (value >> 31);
+}
+
+static size_t next_random_below(uint64_t* rng_state, size_t limit)
+{
+  return (size_t) (next_random(rng_state) % limit);
+}
+
+static bool next_random_bool(uint64_t* rng_state)
+{
+  return next_random(rng_state) >> 63;
+}
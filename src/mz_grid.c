@@ -10,11 +10,14 @@
 #include "grid_engine/bitset.h"
 #include "grid_engine/grid.h"
 #include "grid_engine/log.h"
+#include "grid_engine/pqueue.h"
 
 typedef struct ge_mz_grid {
   ge_grid_t* logic_grid;
   ge_grid_t* render_grid;
   ge_bitset_t* edge_bitset;
+  ge_bitset_t* dirty_row_bitset;
+  bool render_deferred;
 } ge_mz_grid_t;
 
 const ge_mz_con_t GE_MZ_CONS[GE_MZ_NUM_CONS] = {
@@ -73,6 +76,13 @@ static const uint8_t GE_MZ_PATH_TO_BITS[GE_MZ_NUM_PATHS] = {
     GE_MZ_PATH_VISITED_BITS,
 };
 
+static void ge_mz_grid_render_row(ge_mz_grid_t* grid, size_t row);
+static bool ge_mz_grid_bfs(const ge_mz_grid_t* grid, size_t start_index, size_t end_index,
+                           size_t* dist_arr);
+static size_t ge_mz_grid_get_con_indices(const ge_mz_grid_t* grid, size_t index,
+                                         size_t* nbr_indices);
+static void abort_on_coord_out_of_bounds(const ge_mz_grid_t* grid, ge_coord_t coord);
+
 uint8_t ge_mz_con_to_bits(ge_mz_con_t con)
 {
   return GE_MZ_CON_TO_BITS[con];
@@ -173,6 +183,14 @@ ge_mz_grid_t* ge_mz_grid_create(size_t width, size_t height)
     free(grid);
     return NULL;
   }
+  grid->dirty_row_bitset = ge_bitset_create(height);
+  if (grid->dirty_row_bitset == NULL) {
+    ge_grid_free(grid->logic_grid);
+    ge_grid_free(grid->render_grid);
+    ge_bitset_free(grid->edge_bitset);
+    free(grid);
+    return NULL;
+  }
   // Render the cells of the maze (assuming all unconnected)
   for (size_t jj = 1; jj < render_height; jj += 2) {
     for (size_t ii = 1; ii < render_width; ii += 2) {
@@ -190,11 +208,13 @@ void ge_mz_grid_free(ge_mz_grid_t* grid)
   ge_grid_free(grid->logic_grid);
   ge_grid_free(grid->render_grid);
   ge_bitset_free(grid->edge_bitset);
+  ge_bitset_free(grid->dirty_row_bitset);
   free(grid);
 }
 
 ge_grid_t* ge_mz_grid_get_render_grid(ge_mz_grid_t* grid)
 {
+  ge_mz_grid_update_render_grid(grid);
   return grid->render_grid;
 }
 
@@ -254,6 +274,9 @@ void ge_mz_grid_set_coord(ge_mz_grid_t* grid, ge_coord_t coord, uint8_t value)
     const uint8_t nxt_value = (added_con ? ge_mz_value_add_con(nbr_value, ops_con)
                                          : ge_mz_value_rm_con(nbr_value, ops_con));
     ge_grid_set_coord(grid->logic_grid, nbr_coord, nxt_value);
+    if (grid->render_deferred && nbr_coord.y != coord.y) {
+      ge_bitset_set(grid->dirty_row_bitset, nbr_coord.y, true);
+    }
   }
   // Update the edge bitset
   const bool prv_edge = ge_mz_value_is_path(prv_value, GE_MZ_PATH_EDGE);
@@ -263,7 +286,11 @@ void ge_mz_grid_set_coord(ge_mz_grid_t* grid, ge_coord_t coord, uint8_t value)
     const size_t bitset_index = width * coord.y + coord.x;
     ge_bitset_set(grid->edge_bitset, bitset_index, cur_edge);
   }
-  // Update the rendered grid
+  // Update the rendered grid, or just mark it dirty to be rendered later
+  if (grid->render_deferred) {
+    ge_bitset_set(grid->dirty_row_bitset, coord.y, true);
+    return;
+  }
   const ge_coord_t render_coord = {2 * coord.x + 1, 2 * coord.y + 1};
   for (size_t ii = 0; ii < GE_MZ_NUM_CONS; ++ii) {
     const ge_mz_con_t con = GE_MZ_CONS[ii];
@@ -348,3 +375,231 @@ ge_coord_t ge_mz_grid_next_edge_coord(const ge_mz_grid_t* grid, ge_coord_t start
   return (edge_index != GE_BITSET_SEARCH_INIT ? (ge_coord_t){edge_index % width, edge_index / width}
                                               : GE_INVALID_COORD);
 }
+
+void ge_mz_grid_set_render_deferred(ge_mz_grid_t* grid, bool render_deferred)
+{
+  grid->render_deferred = render_deferred;
+  if (!render_deferred) {
+    ge_mz_grid_update_render_grid(grid);
+  }
+}
+
+bool ge_mz_grid_is_render_deferred(const ge_mz_grid_t* grid)
+{
+  return grid->render_deferred;
+}
+
+void ge_mz_grid_update_render_grid(ge_mz_grid_t* grid)
+{
+  if (ge_bitset_has_none(grid->dirty_row_bitset)) {
+    return;
+  }
+  size_t row = GE_BITSET_SEARCH_INIT;
+  while ((row = ge_bitset_search(grid->dirty_row_bitset, row)) != GE_BITSET_SEARCH_INIT) {
+    ge_mz_grid_render_row(grid, row);
+  }
+  const size_t height = ge_grid_get_height(grid->logic_grid);
+  ge_bitset_set_range(grid->dirty_row_bitset, 0, height, false);
+}
+
+bool ge_mz_grid_get_distances(const ge_mz_grid_t* grid, ge_coord_t start_coord, size_t* dist_arr)
+{
+  abort_on_coord_out_of_bounds(grid, start_coord);
+  const size_t width = ge_grid_get_width(grid->logic_grid);
+  const size_t start_index = width * start_coord.y + start_coord.x;
+  return ge_mz_grid_bfs(grid, start_index, SIZE_MAX, dist_arr);
+}
+
+bool ge_mz_grid_get_distances_weighted(const ge_mz_grid_t* grid, ge_coord_t start_coord,
+                                       ge_mz_weight_func_t weight_func, void* user_data,
+                                       size_t* dist_arr)
+{
+  abort_on_coord_out_of_bounds(grid, start_coord);
+  const size_t width = ge_grid_get_width(grid->logic_grid);
+  const size_t height = ge_grid_get_height(grid->logic_grid);
+  ge_pqueue_t* const pqueue = ge_pqueue_create();
+  if (pqueue == NULL) {
+    return false;
+  }
+  for (size_t ii = 0; ii < width * height; ++ii) {
+    dist_arr[ii] = SIZE_MAX;
+  }
+  const size_t start_index = width * start_coord.y + start_coord.x;
+  dist_arr[start_index] = 0;
+  if (!ge_pqueue_push(pqueue, 0, start_index)) {
+    ge_pqueue_free(pqueue);
+    return false;
+  }
+  // Dijkstra's algorithm, where stale entries are skipped rather than removed from the queue
+  while (!ge_pqueue_is_empty(pqueue)) {
+    const ge_pqueue_entry_t entry = ge_pqueue_pop(pqueue);
+    if (entry.priority > dist_arr[entry.value]) {
+      continue;
+    }
+    const ge_coord_t coord = {entry.value % width, entry.value / width};
+    size_t nbr_indices[GE_MZ_NUM_CONS];
+    const size_t num_nbrs = ge_mz_grid_get_con_indices(grid, entry.value, nbr_indices);
+    for (size_t ii = 0; ii < num_nbrs; ++ii) {
+      const size_t nbr_index = nbr_indices[ii];
+      const ge_coord_t nbr_coord = {nbr_index % width, nbr_index / width};
+      const size_t nbr_dist = entry.priority + weight_func(coord, nbr_coord, user_data);
+      if (nbr_dist < dist_arr[nbr_index]) {
+        dist_arr[nbr_index] = nbr_dist;
+        if (!ge_pqueue_push(pqueue, nbr_dist, nbr_index)) {
+          ge_pqueue_free(pqueue);
+          return false;
+        }
+      }
+    }
+  }
+  ge_pqueue_free(pqueue);
+  return true;
+}
+
+ge_coord_vec_t* ge_mz_grid_get_path(const ge_mz_grid_t* grid, ge_coord_t start_coord,
+                                    ge_coord_t end_coord)
+{
+  abort_on_coord_out_of_bounds(grid, start_coord);
+  abort_on_coord_out_of_bounds(grid, end_coord);
+  const size_t width = ge_grid_get_width(grid->logic_grid);
+  const size_t height = ge_grid_get_height(grid->logic_grid);
+  ge_coord_vec_t* const path = ge_coord_vec_create();
+  size_t* const dist_arr = malloc(width * height * sizeof(size_t));
+  if (path == NULL || dist_arr == NULL) {
+    ge_coord_vec_free(path);
+    free(dist_arr);
+    return NULL;
+  }
+  // Search from the start until we reach the end, then walk back to the start
+  const size_t start_index = width * start_coord.y + start_coord.x;
+  const size_t end_index = width * end_coord.y + end_coord.x;
+  if (!ge_mz_grid_bfs(grid, start_index, end_index, dist_arr)) {
+    ge_coord_vec_free(path);
+    free(dist_arr);
+    return NULL;
+  }
+  if (dist_arr[end_index] == SIZE_MAX) {
+    free(dist_arr);
+    return path;
+  }
+  if (!ge_coord_vec_resize(path, dist_arr[end_index] + 1)) {
+    ge_coord_vec_free(path);
+    free(dist_arr);
+    return NULL;
+  }
+  size_t index = end_index;
+  while (true) {
+    ge_coord_vec_set(path, dist_arr[index], (ge_coord_t){index % width, index / width});
+    if (index == start_index) {
+      break;
+    }
+    size_t nbr_indices[GE_MZ_NUM_CONS];
+    const size_t num_nbrs = ge_mz_grid_get_con_indices(grid, index, nbr_indices);
+    for (size_t ii = 0; ii < num_nbrs; ++ii) {
+      if (dist_arr[nbr_indices[ii]] + 1 == dist_arr[index]) {
+        index = nbr_indices[ii];
+        break;
+      }
+    }
+  }
+  free(dist_arr);
+  return path;
+}
+
+static void ge_mz_grid_render_row(ge_mz_grid_t* grid, size_t row)
+{
+  // Only the connection pixels are rendered, the cell and corner pixels never change. Each cell
+  // renders its east and south connections, and the north and west borders are done separately.
+  // Connections are kept symmetric, so this matches rendering every connection of every cell.
+  const size_t width = ge_grid_get_width(grid->logic_grid);
+  const size_t render_width = ge_grid_get_width(grid->render_grid);
+  if (width == 0) {
+    return;
+  }
+  const uint8_t* const logic_row = ge_grid_get_pixel_arr(grid->logic_grid) + width * row;
+  uint8_t* const render_pixel_arr = ge_grid_get_pixel_arr_mut(grid->render_grid);
+  uint8_t* const render_row = render_pixel_arr + render_width * (2 * row);
+  uint8_t* const render_cell_row = render_row + render_width;
+  uint8_t* const render_south_row = render_cell_row + render_width;
+  if (row == 0) {
+    for (size_t ii = 0; ii < width; ++ii) {
+      render_row[2 * ii + 1] = (logic_row[ii] & GE_MZ_CON_NORTH_BIT ? 255 : 0);
+    }
+  }
+  render_cell_row[0] = (logic_row[0] & GE_MZ_CON_WEST_BIT ? 255 : 0);
+  for (size_t ii = 0; ii < width; ++ii) {
+    render_cell_row[2 * ii + 2] = (logic_row[ii] & GE_MZ_CON_EAST_BIT ? 255 : 0);
+  }
+  for (size_t ii = 0; ii < width; ++ii) {
+    render_south_row[2 * ii + 1] = (logic_row[ii] & GE_MZ_CON_SOUTH_BIT ? 255 : 0);
+  }
+}
+
+static bool ge_mz_grid_bfs(const ge_mz_grid_t* grid, size_t start_index, size_t end_index,
+                           size_t* dist_arr)
+{
+  // With unit weights, a bucket queue only ever uses the current and next buckets, which is the
+  // same as a plain FIFO queue. Every cell is queued at most once, so the queue never wraps.
+  const size_t size = ge_grid_get_width(grid->logic_grid) * ge_grid_get_height(grid->logic_grid);
+  size_t* const queue = malloc(size * sizeof(size_t));
+  if (queue == NULL) {
+    return false;
+  }
+  for (size_t ii = 0; ii < size; ++ii) {
+    dist_arr[ii] = SIZE_MAX;
+  }
+  size_t queue_head = 0;
+  size_t queue_tail = 0;
+  dist_arr[start_index] = 0;
+  queue[queue_tail++] = start_index;
+  while (queue_head != queue_tail) {
+    const size_t index = queue[queue_head++];
+    if (index == end_index) {
+      break;
+    }
+    size_t nbr_indices[GE_MZ_NUM_CONS];
+    const size_t num_nbrs = ge_mz_grid_get_con_indices(grid, index, nbr_indices);
+    for (size_t ii = 0; ii < num_nbrs; ++ii) {
+      const size_t nbr_index = nbr_indices[ii];
+      if (dist_arr[nbr_index] == SIZE_MAX) {
+        dist_arr[nbr_index] = dist_arr[index] + 1;
+        queue[queue_tail++] = nbr_index;
+      }
+    }
+  }
+  free(queue);
+  return true;
+}
+
+static size_t ge_mz_grid_get_con_indices(const ge_mz_grid_t* grid, size_t index,
+                                         size_t* nbr_indices)
+{
+  // Work directly on indices, since this is the inner loop of all the searches
+  const size_t width = ge_grid_get_width(grid->logic_grid);
+  const size_t height = ge_grid_get_height(grid->logic_grid);
+  const uint8_t value = ge_grid_get_pixel_arr(grid->logic_grid)[index];
+  const size_t x = index % width;
+  const size_t y = index / width;
+  size_t num_nbrs = 0;
+  if ((value & GE_MZ_CON_NORTH_BIT) && y > 0) {
+    nbr_indices[num_nbrs++] = index - width;
+  }
+  if ((value & GE_MZ_CON_EAST_BIT) && x + 1 < width) {
+    nbr_indices[num_nbrs++] = index + 1;
+  }
+  if ((value & GE_MZ_CON_SOUTH_BIT) && y + 1 < height) {
+    nbr_indices[num_nbrs++] = index + width;
+  }
+  if ((value & GE_MZ_CON_WEST_BIT) && x > 0) {
+    nbr_indices[num_nbrs++] = index - 1;
+  }
+  return num_nbrs;
+}
+
+static void abort_on_coord_out_of_bounds(const ge_mz_grid_t* grid, ge_coord_t coord)
+{
+  if (!ge_grid_has_coord(grid->logic_grid, coord)) {
+    GE_LOG_ERROR("Coord is out of bounds! (%li, %li)", coord.x, coord.y);
+    abort();
+  }
+}
@@ -5,6 +5,12 @@
 
 #include "grid_engine/palette.h"
 
+#include <stdlib.h>
+
+#include "grid_engine/log.h"
+
+static void abort_on_bad_range(size_t begin_index, size_t end_index);
+
 const ge_palette_t GE_PALETTE_INFERNO = {
     .colormap =
         {
@@ -62,3 +68,46 @@ const ge_palette_t GE_PALETTE_INFERNO = {
             {252, 254, 164},
         },
 };
+
+void ge_palette_cycle(ge_palette_t* palette, const ge_palette_t* source_palette,
+                      size_t begin_index, size_t end_index, ptrdiff_t shift)
+{
+  abort_on_bad_range(begin_index, end_index);
+  // Copy first, in case the palettes are the same
+  const ge_palette_t source_copy = *source_palette;
+  *palette = source_copy;
+  const size_t num_colors = end_index - begin_index;
+  if (num_colors == 0) {
+    return;
+  }
+  const size_t offset = (size_t) (shift % (ptrdiff_t) num_colors + (ptrdiff_t) num_colors);
+  for (size_t ii = 0; ii < num_colors; ++ii) {
+    palette->colormap[begin_index + (ii + offset) % num_colors] =
+        source_copy.colormap[begin_index + ii];
+  }
+}
+
+void ge_palette_lerp(ge_palette_t* palette, const ge_palette_t* palette_a,
+                     const ge_palette_t* palette_b, double ratio)
+{
+  // Blend in fixed point, with the ratio clamped so colors can't overflow
+  const double clamped_ratio = (ratio < 0.0 ? 0.0 : (ratio > 1.0 ? 1.0 : ratio));
+  const int weight = clamped_ratio * 256.0 + 0.5;
+  for (size_t ii = 0; ii < 256; ++ii) {
+    const ge_color_t color_a = palette_a->colormap[ii];
+    const ge_color_t color_b = palette_b->colormap[ii];
+    palette->colormap[ii] = (ge_color_t){
+        .red = (color_a.red * (256 - weight) + color_b.red * weight + 128) >> 8,
+        .green = (color_a.green * (256 - weight) + color_b.green * weight + 128) >> 8,
+        .blue = (color_a.blue * (256 - weight) + color_b.blue * weight + 128) >> 8,
+    };
+  }
+}
+
+static void abort_on_bad_range(size_t begin_index, size_t end_index)
+{
+  if (begin_index > end_index || end_index > 256) {
+    GE_LOG_ERROR("Palette range is out of bounds! %zu to %zu", begin_index, end_index);
+    abort();
+  }
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/pool.h"
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "grid_engine/log.h"
+
+typedef struct ge_pool {
+  size_t num_workers;
+  SDL_Thread** thread_arr;
+  SDL_mutex* mutex;
+  SDL_cond* work_cond;
+  SDL_cond* done_cond;
+  // Everything below is protected by the mutex
+  bool is_quitting;
+  size_t job_id;
+  ge_pool_func_t func;
+  void* user_data;
+  size_t num_tasks;
+  size_t next_task_index;
+  size_t num_tasks_done;
+} ge_pool_t;
+
+static int ge_pool_worker_main(void* data);
+static void ge_pool_run_tasks(ge_pool_t* pool);
+
+ge_pool_t* ge_pool_create(size_t num_workers)
+{
+  if (num_workers == 0) {
+    const int num_cpus = SDL_GetCPUCount();
+    num_workers = (num_cpus > 1 ? num_cpus - 1 : 1);
+  }
+  ge_pool_t* pool = calloc(1, sizeof(ge_pool_t));
+  if (pool == NULL) {
+    return NULL;
+  }
+  pool->thread_arr = calloc(num_workers, sizeof(SDL_Thread*));
+  pool->mutex = SDL_CreateMutex();
+  pool->work_cond = SDL_CreateCond();
+  pool->done_cond = SDL_CreateCond();
+  if (pool->thread_arr == NULL || pool->mutex == NULL || pool->work_cond == NULL
+      || pool->done_cond == NULL) {
+    ge_pool_free(pool);
+    return NULL;
+  }
+  for (size_t ii = 0; ii < num_workers; ++ii) {
+    pool->thread_arr[ii] = SDL_CreateThread(ge_pool_worker_main, "ge_pool_worker", pool);
+    if (pool->thread_arr[ii] == NULL) {
+      GE_LOG_ERROR("Failed to create thread: %s", SDL_GetError());
+      ge_pool_free(pool);
+      return NULL;
+    }
+    pool->num_workers = ii + 1;
+  }
+  return pool;
+}
+
+void ge_pool_free(ge_pool_t* pool)
+{
+  if (pool == NULL) {
+    return;
+  }
+  if (pool->num_workers != 0) {
+    SDL_LockMutex(pool->mutex);
+    pool->is_quitting = true;
+    SDL_CondBroadcast(pool->work_cond);
+    SDL_UnlockMutex(pool->mutex);
+    for (size_t ii = 0; ii < pool->num_workers; ++ii) {
+      SDL_WaitThread(pool->thread_arr[ii], NULL);
+    }
+  }
+  if (pool->done_cond != NULL) {
+    SDL_DestroyCond(pool->done_cond);
+  }
+  if (pool->work_cond != NULL) {
+    SDL_DestroyCond(pool->work_cond);
+  }
+  if (pool->mutex != NULL) {
+    SDL_DestroyMutex(pool->mutex);
+  }
+  free(pool->thread_arr);
+  free(pool);
+}
+
+size_t ge_pool_get_num_workers(const ge_pool_t* pool)
+{
+  return pool->num_workers;
+}
+
+void ge_pool_run(ge_pool_t* pool, ge_pool_func_t func, void* user_data, size_t num_tasks)
+{
+  // Without a pool, or with a single task, there's no point waking up the workers
+  if (pool == NULL || num_tasks <= 1) {
+    for (size_t ii = 0; ii < num_tasks; ++ii) {
+      func(ii, user_data);
+    }
+    return;
+  }
+  SDL_LockMutex(pool->mutex);
+  ++pool->job_id;
+  pool->func = func;
+  pool->user_data = user_data;
+  pool->num_tasks = num_tasks;
+  pool->next_task_index = 0;
+  pool->num_tasks_done = 0;
+  SDL_CondBroadcast(pool->work_cond);
+  // The calling thread helps out, then waits for any tasks still running on workers
+  ge_pool_run_tasks(pool);
+  while (pool->num_tasks_done != pool->num_tasks) {
+    SDL_CondWait(pool->done_cond, pool->mutex);
+  }
+  SDL_UnlockMutex(pool->mutex);
+}
+
+static int ge_pool_worker_main(void* data)
+{
+  ge_pool_t* const pool = data;
+  size_t last_job_id = 0;
+  SDL_LockMutex(pool->mutex);
+  while (true) {
+    while (!pool->is_quitting && pool->job_id == last_job_id) {
+      SDL_CondWait(pool->work_cond, pool->mutex);
+    }
+    if (pool->is_quitting) {
+      break;
+    }
+    last_job_id = pool->job_id;
+    ge_pool_run_tasks(pool);
+  }
+  SDL_UnlockMutex(pool->mutex);
+  return 0;
+}
+
+static void ge_pool_run_tasks(ge_pool_t* pool)
+{
+  // Must be called with the mutex locked, which is released while running each task
+  while (pool->next_task_index < pool->num_tasks) {
+    const size_t task_index = pool->next_task_index++;
+    const ge_pool_func_t func = pool->func;
+    void* const user_data = pool->user_data;
+    SDL_UnlockMutex(pool->mutex);
+    func(task_index, user_data);
+    SDL_LockMutex(pool->mutex);
+    if (++pool->num_tasks_done == pool->num_tasks) {
+      SDL_CondSignal(pool->done_cond);
+    }
+  }
+}
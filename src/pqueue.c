@@ -0,0 +1,138 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/pqueue.h"
+
+#include <stdlib.h>
+
+#include "grid_engine/log.h"
+
+typedef struct ge_pqueue {
+  size_t capacity;
+  size_t size;
+  ge_pqueue_entry_t* entry_buffer;
+} ge_pqueue_t;
+
+static const size_t GE_PQUEUE_DEFAULT_CAPACITY = 64;
+
+static void abort_on_empty(const ge_pqueue_t* pqueue);
+
+ge_pqueue_t* ge_pqueue_create()
+{
+  ge_pqueue_t* pqueue = calloc(1, sizeof(ge_pqueue_t));
+  if (pqueue == NULL) {
+    return NULL;
+  }
+  pqueue->capacity = GE_PQUEUE_DEFAULT_CAPACITY;
+  pqueue->size = 0;
+  pqueue->entry_buffer = calloc(pqueue->capacity, sizeof(ge_pqueue_entry_t));
+  if (pqueue->entry_buffer == NULL) {
+    free(pqueue);
+    return NULL;
+  }
+  return pqueue;
+}
+
+void ge_pqueue_free(ge_pqueue_t* pqueue)
+{
+  if (pqueue == NULL) {
+    return;
+  }
+  free(pqueue->entry_buffer);
+  free(pqueue);
+}
+
+size_t ge_pqueue_size(const ge_pqueue_t* pqueue)
+{
+  return pqueue->size;
+}
+
+bool ge_pqueue_is_empty(const ge_pqueue_t* pqueue)
+{
+  return (pqueue->size == 0);
+}
+
+void ge_pqueue_clear(ge_pqueue_t* pqueue)
+{
+  pqueue->size = 0;
+}
+
+bool ge_pqueue_reserve(ge_pqueue_t* pqueue, size_t capacity)
+{
+  if (capacity <= pqueue->capacity) {
+    return true;
+  }
+  ge_pqueue_entry_t* const entry_buffer =
+      realloc(pqueue->entry_buffer, capacity * sizeof(ge_pqueue_entry_t));
+  if (entry_buffer == NULL) {
+    return false;
+  }
+  pqueue->capacity = capacity;
+  pqueue->entry_buffer = entry_buffer;
+  return true;
+}
+
+bool ge_pqueue_push(ge_pqueue_t* pqueue, size_t priority, size_t value)
+{
+  if (pqueue->size == pqueue->capacity) {
+    if (!ge_pqueue_reserve(pqueue, 2 * pqueue->capacity)) {
+      return false;
+    }
+  }
+  // Sift the new entry up from the bottom of the heap
+  ge_pqueue_entry_t* const entries = pqueue->entry_buffer;
+  size_t index = pqueue->size++;
+  while (index > 0) {
+    const size_t parent_index = (index - 1) / 2;
+    if (entries[parent_index].priority <= priority) {
+      break;
+    }
+    entries[index] = entries[parent_index];
+    index = parent_index;
+  }
+  entries[index] = (ge_pqueue_entry_t){priority, value};
+  return true;
+}
+
+ge_pqueue_entry_t ge_pqueue_peek(const ge_pqueue_t* pqueue)
+{
+  abort_on_empty(pqueue);
+  return pqueue->entry_buffer[0];
+}
+
+ge_pqueue_entry_t ge_pqueue_pop(ge_pqueue_t* pqueue)
+{
+  abort_on_empty(pqueue);
+  // Sift the last entry down from the top of the heap
+  ge_pqueue_entry_t* const entries = pqueue->entry_buffer;
+  const ge_pqueue_entry_t top_entry = entries[0];
+  const ge_pqueue_entry_t last_entry = entries[--pqueue->size];
+  size_t index = 0;
+  while (true) {
+    size_t child_index = 2 * index + 1;
+    if (child_index >= pqueue->size) {
+      break;
+    }
+    if (child_index + 1 < pqueue->size
+        && entries[child_index + 1].priority < entries[child_index].priority) {
+      ++child_index;
+    }
+    if (last_entry.priority <= entries[child_index].priority) {
+      break;
+    }
+    entries[index] = entries[child_index];
+    index = child_index;
+  }
+  entries[index] = last_entry;
+  return top_entry;
+}
+
+static void abort_on_empty(const ge_pqueue_t* pqueue)
+{
+  if (pqueue->size == 0) {
+    GE_LOG_ERROR("Priority queue is empty!");
+    abort();
+  }
+}
@@ -0,0 +1,357 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/quant.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+// Colors are counted with 5 bits per channel, for 32K bins in total
+#define GE_QUANT_BITS 5
+#define GE_QUANT_SIDE (1 << GE_QUANT_BITS)
+#define GE_QUANT_NUM_BINS (GE_QUANT_SIDE * GE_QUANT_SIDE * GE_QUANT_SIDE)
+#define GE_QUANT_NUM_COLORS 256
+// How far the dither pattern moves each channel, about the distance between palette colors
+#define GE_QUANT_DITHER_SPREAD 32
+
+typedef struct ge_quant_bin {
+  uint64_t count;
+  uint64_t red_sum;
+  uint64_t green_sum;
+  uint64_t blue_sum;
+} ge_quant_bin_t;
+
+// A box of bins, including the min and max bins on each axis
+typedef struct ge_quant_box {
+  size_t min_arr[3];
+  size_t max_arr[3];
+  uint64_t count;
+} ge_quant_box_t;
+
+typedef struct ge_quant_count_data {
+  const uint8_t* rgba_pixel_arr;
+  size_t pitch;
+  size_t width;
+  size_t height;
+  size_t num_tasks;
+  ge_quant_bin_t* bin_arr;  // One histogram for each task
+} ge_quant_count_data_t;
+
+typedef struct ge_quant_map_data {
+  const uint8_t* rgba_pixel_arr;
+  size_t pitch;
+  const ge_palette_t* palette;
+  ge_quant_dither_t dither;
+  uint8_t* pixel_arr;
+  size_t width;
+  size_t height;
+  size_t num_tasks;
+  uint8_t* index_arr;  // The nearest palette entry for each bin
+} ge_quant_map_data_t;
+
+// Images smaller than this aren't worth splitting between workers
+static const size_t GE_QUANT_MIN_PARALLEL_NUM_PIXELS = 1 << 20;
+
+static const int GE_QUANT_BAYER_ARR[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+static void ge_quant_count_task(size_t task_index, void* user_data);
+static void ge_quant_nearest_task(size_t task_index, void* user_data);
+static void ge_quant_map_task(size_t task_index, void* user_data);
+static void ge_quant_shrink_box(const ge_quant_bin_t* bin_arr, ge_quant_box_t* box);
+static void ge_quant_split_box(const ge_quant_bin_t* bin_arr, ge_quant_box_t* box,
+                               ge_quant_box_t* split_box);
+static ge_color_t ge_quant_get_box_color(const ge_quant_bin_t* bin_arr, const ge_quant_box_t* box);
+static size_t ge_quant_get_bin_index(size_t red, size_t green, size_t blue);
+static size_t ge_quant_get_num_tasks(ge_pool_t* pool, size_t width, size_t height,
+                                     size_t tasks_per_worker);
+
+bool ge_quant_build_palette(const uint8_t* rgba_pixel_arr, size_t pitch, size_t width,
+                            size_t height, ge_pool_t* pool, ge_palette_t* palette)
+{
+  // Each task needs its own histogram, so only use one task per thread
+  const size_t num_tasks = ge_quant_get_num_tasks(pool, width, height, 1);
+  ge_quant_bin_t* const bin_arr = calloc(num_tasks * GE_QUANT_NUM_BINS, sizeof(ge_quant_bin_t));
+  if (bin_arr == NULL) {
+    return false;
+  }
+  ge_quant_count_data_t count_data = {
+      .rgba_pixel_arr = rgba_pixel_arr,
+      .pitch = pitch,
+      .width = width,
+      .height = height,
+      .num_tasks = num_tasks,
+      .bin_arr = bin_arr,
+  };
+  ge_pool_run(pool, ge_quant_count_task, &count_data, num_tasks);
+  // Merge all the histograms into the first one
+  for (size_t ii = 1; ii < num_tasks; ++ii) {
+    const ge_quant_bin_t* const task_bin_arr = bin_arr + GE_QUANT_NUM_BINS * ii;
+    for (size_t jj = 0; jj < GE_QUANT_NUM_BINS; ++jj) {
+      bin_arr[jj].count += task_bin_arr[jj].count;
+      bin_arr[jj].red_sum += task_bin_arr[jj].red_sum;
+      bin_arr[jj].green_sum += task_bin_arr[jj].green_sum;
+      bin_arr[jj].blue_sum += task_bin_arr[jj].blue_sum;
+    }
+  }
+  // Median cut, starting with one box around every color
+  ge_quant_box_t box_arr[GE_QUANT_NUM_COLORS];
+  size_t num_boxes = 0;
+  if (width != 0 && height != 0) {
+    box_arr[0] = (ge_quant_box_t){
+        {0, 0, 0},
+        {GE_QUANT_SIDE - 1, GE_QUANT_SIDE - 1, GE_QUANT_SIDE - 1},
+        0,
+    };
+    ge_quant_shrink_box(bin_arr, &box_arr[0]);
+    num_boxes = 1;
+  }
+  while (num_boxes < GE_QUANT_NUM_COLORS) {
+    // Split the most common colors first, then favor big boxes, so rare but distinct colors
+    // still get their own entries
+    const bool is_volume_weighted = (num_boxes >= GE_QUANT_NUM_COLORS / 2);
+    size_t best_index = SIZE_MAX;
+    uint64_t best_score = 0;
+    for (size_t ii = 0; ii < num_boxes; ++ii) {
+      const ge_quant_box_t* const box = &box_arr[ii];
+      uint64_t volume = 1;
+      for (size_t jj = 0; jj < 3; ++jj) {
+        volume *= box->max_arr[jj] - box->min_arr[jj] + 1;
+      }
+      const uint64_t score = (is_volume_weighted ? box->count * volume : box->count);
+      if (volume > 1 && score > best_score) {
+        best_index = ii;
+        best_score = score;
+      }
+    }
+    if (best_index == SIZE_MAX) {
+      // Every box is a single bin, so there are no more colors to split
+      break;
+    }
+    ge_quant_split_box(bin_arr, &box_arr[best_index], &box_arr[num_boxes]);
+    ++num_boxes;
+  }
+  for (size_t ii = 0; ii < GE_QUANT_NUM_COLORS; ++ii) {
+    palette->colormap[ii] = (ii < num_boxes ? ge_quant_get_box_color(bin_arr, &box_arr[ii])
+                                            : (ge_color_t){.red = 0, .blue = 0, .green = 0});
+  }
+  free(bin_arr);
+  return true;
+}
+
+bool ge_quant_map(const uint8_t* rgba_pixel_arr, size_t pitch, const ge_palette_t* palette,
+                  ge_quant_dither_t dither, ge_pool_t* pool, ge_grid_t* grid)
+{
+  uint8_t* const index_arr = malloc(GE_QUANT_NUM_BINS);
+  if (index_arr == NULL) {
+    return false;
+  }
+  ge_quant_map_data_t map_data = {
+      .rgba_pixel_arr = rgba_pixel_arr,
+      .pitch = pitch,
+      .palette = palette,
+      .dither = dither,
+      .pixel_arr = ge_grid_get_pixel_arr_mut(grid),
+      .width = ge_grid_get_width(grid),
+      .height = ge_grid_get_height(grid),
+      .num_tasks = (pool != NULL ? 4 * (ge_pool_get_num_workers(pool) + 1) : 1),
+      .index_arr = index_arr,
+  };
+  // Find the nearest palette entry for every bin first, so each pixel is just a lookup
+  ge_pool_run(pool, ge_quant_nearest_task, &map_data, map_data.num_tasks);
+  map_data.num_tasks = ge_quant_get_num_tasks(pool, map_data.width, map_data.height, 4);
+  ge_pool_run(pool, ge_quant_map_task, &map_data, map_data.num_tasks);
+  free(index_arr);
+  return true;
+}
+
+static void ge_quant_count_task(size_t task_index, void* user_data)
+{
+  const ge_quant_count_data_t* const count_data = user_data;
+  ge_quant_bin_t* const bin_arr = count_data->bin_arr + GE_QUANT_NUM_BINS * task_index;
+  const size_t height = count_data->height;
+  const size_t num_tasks = count_data->num_tasks;
+  const size_t begin_row = height * task_index / num_tasks;
+  const size_t end_row = height * (task_index + 1) / num_tasks;
+  for (size_t jj = begin_row; jj < end_row; ++jj) {
+    const uint8_t* const rgba_pixel_row = count_data->rgba_pixel_arr + count_data->pitch * jj;
+    for (size_t ii = 0; ii < count_data->width; ++ii) {
+      const uint8_t red = rgba_pixel_row[4 * ii];
+      const uint8_t green = rgba_pixel_row[4 * ii + 1];
+      const uint8_t blue = rgba_pixel_row[4 * ii + 2];
+      ge_quant_bin_t* const bin = &bin_arr[ge_quant_get_bin_index(
+          red >> (8 - GE_QUANT_BITS), green >> (8 - GE_QUANT_BITS), blue >> (8 - GE_QUANT_BITS))];
+      ++bin->count;
+      bin->red_sum += red;
+      bin->green_sum += green;
+      bin->blue_sum += blue;
+    }
+  }
+}
+
+static void ge_quant_nearest_task(size_t task_index, void* user_data)
+{
+  const ge_quant_map_data_t* const map_data = user_data;
+  const size_t num_tasks = map_data->num_tasks;
+  const size_t begin_index = GE_QUANT_NUM_BINS * task_index / num_tasks;
+  const size_t end_index = GE_QUANT_NUM_BINS * (task_index + 1) / num_tasks;
+  for (size_t ii = begin_index; ii < end_index; ++ii) {
+    // Compare the palette to the center of the bin
+    const int half_bin_size = 1 << (7 - GE_QUANT_BITS);
+    const int red = ((ii >> (2 * GE_QUANT_BITS)) << (8 - GE_QUANT_BITS)) + half_bin_size;
+    const int green =
+        (((ii >> GE_QUANT_BITS) & (GE_QUANT_SIDE - 1)) << (8 - GE_QUANT_BITS)) + half_bin_size;
+    const int blue = ((ii & (GE_QUANT_SIDE - 1)) << (8 - GE_QUANT_BITS)) + half_bin_size;
+    size_t best_index = 0;
+    int best_dist = INT_MAX;
+    for (size_t jj = 0; jj < GE_QUANT_NUM_COLORS; ++jj) {
+      const ge_color_t color = map_data->palette->colormap[jj];
+      const int red_diff = red - color.red;
+      const int green_diff = green - color.green;
+      const int blue_diff = blue - color.blue;
+      const int dist = red_diff * red_diff + green_diff * green_diff + blue_diff * blue_diff;
+      if (dist < best_dist) {
+        best_index = jj;
+        best_dist = dist;
+      }
+    }
+    map_data->index_arr[ii] = best_index;
+  }
+}
+
+static void ge_quant_map_task(size_t task_index, void* user_data)
+{
+  const ge_quant_map_data_t* const map_data = user_data;
+  const size_t height = map_data->height;
+  const size_t num_tasks = map_data->num_tasks;
+  const size_t begin_row = height * task_index / num_tasks;
+  const size_t end_row = height * (task_index + 1) / num_tasks;
+  for (size_t jj = begin_row; jj < end_row; ++jj) {
+    // Offsets are centered on zero, so dithering doesn't brighten or darken the image
+    int offset_arr[4] = {0};
+    if (map_data->dither == GE_QUANT_DITHER_ORDERED) {
+      for (size_t ii = 0; ii < 4; ++ii) {
+        offset_arr[ii] = (2 * GE_QUANT_BAYER_ARR[jj % 4][ii] - 15) * GE_QUANT_DITHER_SPREAD / 32;
+      }
+    }
+    const uint8_t* const rgba_pixel_row = map_data->rgba_pixel_arr + map_data->pitch * jj;
+    uint8_t* const pixel_row = map_data->pixel_arr + map_data->width * jj;
+    for (size_t ii = 0; ii < map_data->width; ++ii) {
+      const int offset = offset_arr[ii % 4];
+      size_t channel_arr[3];
+      for (size_t kk = 0; kk < 3; ++kk) {
+        const int value = rgba_pixel_row[4 * ii + kk] + offset;
+        const int clamped_value = (value < 0 ? 0 : (value > 255 ? 255 : value));
+        channel_arr[kk] = clamped_value >> (8 - GE_QUANT_BITS);
+      }
+      pixel_row[ii] = map_data->index_arr[ge_quant_get_bin_index(channel_arr[0], channel_arr[1],
+                                                                 channel_arr[2])];
+    }
+  }
+}
+
+static void ge_quant_shrink_box(const ge_quant_bin_t* bin_arr, ge_quant_box_t* box)
+{
+  // Shrink the box to fit the bins which have colors, and count the colors
+  size_t min_arr[3] = {GE_QUANT_SIDE, GE_QUANT_SIDE, GE_QUANT_SIDE};
+  size_t max_arr[3] = {0, 0, 0};
+  uint64_t count = 0;
+  for (size_t red = box->min_arr[0]; red <= box->max_arr[0]; ++red) {
+    for (size_t green = box->min_arr[1]; green <= box->max_arr[1]; ++green) {
+      for (size_t blue = box->min_arr[2]; blue <= box->max_arr[2]; ++blue) {
+        const ge_quant_bin_t* const bin = &bin_arr[ge_quant_get_bin_index(red, green, blue)];
+        if (bin->count == 0) {
+          continue;
+        }
+        const size_t coord_arr[3] = {red, green, blue};
+        for (size_t ii = 0; ii < 3; ++ii) {
+          min_arr[ii] = (coord_arr[ii] < min_arr[ii] ? coord_arr[ii] : min_arr[ii]);
+          max_arr[ii] = (coord_arr[ii] > max_arr[ii] ? coord_arr[ii] : max_arr[ii]);
+        }
+        count += bin->count;
+      }
+    }
+  }
+  for (size_t ii = 0; ii < 3; ++ii) {
+    box->min_arr[ii] = min_arr[ii];
+    box->max_arr[ii] = max_arr[ii];
+  }
+  box->count = count;
+}
+
+static void ge_quant_split_box(const ge_quant_bin_t* bin_arr, ge_quant_box_t* box,
+                               ge_quant_box_t* split_box)
+{
+  // Split along the longest axis
+  size_t axis = 0;
+  for (size_t ii = 1; ii < 3; ++ii) {
+    if (box->max_arr[ii] - box->min_arr[ii] > box->max_arr[axis] - box->min_arr[axis]) {
+      axis = ii;
+    }
+  }
+  uint64_t slice_count_arr[GE_QUANT_SIDE] = {0};
+  for (size_t red = box->min_arr[0]; red <= box->max_arr[0]; ++red) {
+    for (size_t green = box->min_arr[1]; green <= box->max_arr[1]; ++green) {
+      for (size_t blue = box->min_arr[2]; blue <= box->max_arr[2]; ++blue) {
+        const size_t coord_arr[3] = {red, green, blue};
+        slice_count_arr[coord_arr[axis]] +=
+            bin_arr[ge_quant_get_bin_index(red, green, blue)].count;
+      }
+    }
+  }
+  // Find the median, but keep at least one slice on each side. The box has been shrunk, so the
+  // first and last slices always have colors, and neither side is ever empty.
+  size_t split = box->min_arr[axis];
+  uint64_t count = slice_count_arr[split];
+  while (split + 1 < box->max_arr[axis] && 2 * count < box->count) {
+    ++split;
+    count += slice_count_arr[split];
+  }
+  *split_box = *box;
+  box->max_arr[axis] = split;
+  split_box->min_arr[axis] = split + 1;
+  ge_quant_shrink_box(bin_arr, box);
+  ge_quant_shrink_box(bin_arr, split_box);
+}
+
+static ge_color_t ge_quant_get_box_color(const ge_quant_bin_t* bin_arr, const ge_quant_box_t* box)
+{
+  // The average of every color in the box
+  uint64_t red_sum = 0;
+  uint64_t green_sum = 0;
+  uint64_t blue_sum = 0;
+  for (size_t red = box->min_arr[0]; red <= box->max_arr[0]; ++red) {
+    for (size_t green = box->min_arr[1]; green <= box->max_arr[1]; ++green) {
+      for (size_t blue = box->min_arr[2]; blue <= box->max_arr[2]; ++blue) {
+        const ge_quant_bin_t* const bin = &bin_arr[ge_quant_get_bin_index(red, green, blue)];
+        red_sum += bin->red_sum;
+        green_sum += bin->green_sum;
+        blue_sum += bin->blue_sum;
+      }
+    }
+  }
+  const uint64_t count = box->count;
+  return (ge_color_t){
+      .red = (red_sum + count / 2) / count,
+      .blue = (blue_sum + count / 2) / count,
+      .green = (green_sum + count / 2) / count,
+  };
+}
+
+static size_t ge_quant_get_bin_index(size_t red, size_t green, size_t blue)
+{
+  return (red << (2 * GE_QUANT_BITS)) | (green << GE_QUANT_BITS) | blue;
+}
+
+static size_t ge_quant_get_num_tasks(ge_pool_t* pool, size_t width, size_t height,
+                                     size_t tasks_per_worker)
+{
+  const bool is_parallel = (pool != NULL && width * height >= GE_QUANT_MIN_PARALLEL_NUM_PIXELS);
+  return (is_parallel ? tasks_per_worker * (ge_pool_get_num_workers(pool) + 1) : 1);
+}
@@ -0,0 +1,262 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/raw.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_engine/log.h"
+
+#define GE_RAW_HEADER_SIZE 64
+
+typedef struct ge_raw_header {
+  uint64_t format;
+  uint64_t width;
+  uint64_t height;
+  uint64_t stride;
+} ge_raw_header_t;
+
+typedef struct ge_raw_mapping {
+  void* ptr;
+  size_t size;
+} ge_raw_mapping_t;
+
+static const uint8_t GE_RAW_MAGIC[8] = {'G', 'E', 'R', 'A', 'W', 'G', 'R', 'D'};
+
+static bool ge_raw_parse_header(const uint8_t* bytes, uint64_t file_size, ge_raw_header_t* header);
+static void* ge_raw_map_file(const char* filename, ge_raw_map_mode_t mode, size_t* size);
+static void ge_raw_unmap_file(void* ptr, size_t size);
+static void ge_raw_free_mapping(void* user_data);
+static void write_u64_le(uint8_t* bytes, uint64_t value);
+static uint64_t read_u64_le(const uint8_t* bytes);
+
+bool ge_raw_save(const ge_grid_t* grid, const char* filename)
+{
+  SDL_RWops* const rw = SDL_RWFromFile(filename, "wb");
+  if (rw == NULL) {
+    GE_LOG_ERROR("Failed to create raw grid file! %s", SDL_GetError());
+    return false;
+  }
+  // Rows are never padded, so the file can always be mapped
+  const size_t width = ge_grid_get_width(grid);
+  const size_t height = ge_grid_get_height(grid);
+  uint8_t header[GE_RAW_HEADER_SIZE] = {0};
+  memcpy(header, GE_RAW_MAGIC, sizeof(GE_RAW_MAGIC));
+  write_u64_le(header + 8, GE_RAW_FORMAT_U8);
+  write_u64_le(header + 16, width);
+  write_u64_le(header + 24, height);
+  write_u64_le(header + 32, width);
+  const size_t num_bytes = width * height;
+  const bool is_written =
+      (SDL_RWwrite(rw, header, 1, sizeof(header)) == sizeof(header)
+       && (num_bytes == 0
+           || SDL_RWwrite(rw, ge_grid_get_pixel_arr(grid), 1, num_bytes) == num_bytes));
+  // Closing flushes the file, which can also fail
+  const bool is_closed = (SDL_RWclose(rw) == 0);
+  if (!is_written || !is_closed) {
+    GE_LOG_ERROR("Failed to write raw grid file! %s", SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+ge_grid_t* ge_raw_load(const char* filename)
+{
+  SDL_RWops* const rw = SDL_RWFromFile(filename, "rb");
+  if (rw == NULL) {
+    GE_LOG_ERROR("Failed to open raw grid file! %s", SDL_GetError());
+    return NULL;
+  }
+  uint8_t header_bytes[GE_RAW_HEADER_SIZE];
+  ge_raw_header_t header;
+  const Sint64 file_size = SDL_RWsize(rw);
+  if (file_size < GE_RAW_HEADER_SIZE
+      || SDL_RWread(rw, header_bytes, 1, sizeof(header_bytes)) != sizeof(header_bytes)
+      || !ge_raw_parse_header(header_bytes, file_size, &header)) {
+    GE_LOG_ERROR("Raw grid file has an invalid header!");
+    SDL_RWclose(rw);
+    return NULL;
+  }
+  ge_grid_t* const grid = ge_grid_create(header.width, header.height);
+  if (grid == NULL) {
+    SDL_RWclose(rw);
+    return NULL;
+  }
+  // Without padding, all the rows can be read at once
+  const bool is_padded = (header.stride != header.width);
+  const size_t num_reads = (is_padded ? header.height : 1);
+  const size_t read_size = (is_padded ? header.width : header.width * header.height);
+  uint8_t* const pixel_arr = ge_grid_get_pixel_arr_mut(grid);
+  bool is_read = true;
+  for (size_t jj = 0; jj < num_reads && is_read && read_size != 0; ++jj) {
+    const Sint64 offset = GE_RAW_HEADER_SIZE + (Sint64) header.stride * jj;
+    is_read = (SDL_RWseek(rw, offset, RW_SEEK_SET) >= 0
+               && SDL_RWread(rw, pixel_arr + read_size * jj, 1, read_size) == read_size);
+  }
+  SDL_RWclose(rw);
+  if (!is_read) {
+    GE_LOG_ERROR("Failed to read raw grid file! %s", SDL_GetError());
+    ge_grid_free(grid);
+    return NULL;
+  }
+  return grid;
+}
+
+ge_grid_t* ge_raw_map(const char* filename, ge_raw_map_mode_t mode)
+{
+  size_t size = 0;
+  uint8_t* const ptr = ge_raw_map_file(filename, mode, &size);
+  if (ptr == NULL) {
+    return NULL;
+  }
+  ge_raw_header_t header;
+  if (!ge_raw_parse_header(ptr, size, &header)) {
+    GE_LOG_ERROR("Raw grid file has an invalid header!");
+    ge_raw_unmap_file(ptr, size);
+    return NULL;
+  }
+  if (header.stride != header.width) {
+    GE_LOG_WARN("Raw grid file has padded rows, so it will be loaded instead of mapped");
+    ge_raw_unmap_file(ptr, size);
+    return ge_raw_load(filename);
+  }
+  ge_raw_mapping_t* const mapping = malloc(sizeof(ge_raw_mapping_t));
+  if (mapping == NULL) {
+    ge_raw_unmap_file(ptr, size);
+    return NULL;
+  }
+  mapping->ptr = ptr;
+  mapping->size = size;
+  ge_grid_t* const grid = ge_grid_create_from_pixel_arr(
+      header.width, header.height, ptr + GE_RAW_HEADER_SIZE, ge_raw_free_mapping, mapping);
+  if (grid == NULL) {
+    ge_raw_free_mapping(mapping);
+    return NULL;
+  }
+  return grid;
+}
+
+static bool ge_raw_parse_header(const uint8_t* bytes, uint64_t file_size, ge_raw_header_t* header)
+{
+  header->format = read_u64_le(bytes + 8);
+  header->width = read_u64_le(bytes + 16);
+  header->height = read_u64_le(bytes + 24);
+  header->stride = read_u64_le(bytes + 32);
+  // Make sure the file is big enough for all the rows, without overflowing
+  const uint64_t max_num_bytes = file_size - GE_RAW_HEADER_SIZE;
+  return (memcmp(bytes, GE_RAW_MAGIC, sizeof(GE_RAW_MAGIC)) == 0
+          && header->format == GE_RAW_FORMAT_U8 && header->stride >= header->width
+          && (header->height == 0 || header->stride <= max_num_bytes / header->height));
+}
+
+#ifdef _WIN32
+
+static void* ge_raw_map_file(const char* filename, ge_raw_map_mode_t mode, size_t* size)
+{
+  const HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    GE_LOG_ERROR("Failed to open raw grid file! %s", filename);
+    return NULL;
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < GE_RAW_HEADER_SIZE) {
+    GE_LOG_ERROR("Raw grid file is too small! %s", filename);
+    CloseHandle(file);
+    return NULL;
+  }
+  const bool is_read_only = (mode == GE_RAW_MAP_MODE_READ_ONLY);
+  const DWORD protect = (is_read_only ? PAGE_READONLY : PAGE_WRITECOPY);
+  const DWORD access = (is_read_only ? FILE_MAP_READ : FILE_MAP_COPY);
+  const HANDLE file_mapping = CreateFileMappingA(file, NULL, protect, 0, 0, NULL);
+  void* const ptr = (file_mapping != NULL ? MapViewOfFile(file_mapping, access, 0, 0, 0) : NULL);
+  // The view keeps its own references to the file
+  if (file_mapping != NULL) {
+    CloseHandle(file_mapping);
+  }
+  CloseHandle(file);
+  if (ptr == NULL) {
+    GE_LOG_ERROR("Failed to map raw grid file! %s", filename);
+    return NULL;
+  }
+  *size = file_size.QuadPart;
+  return ptr;
+}
+
+static void ge_raw_unmap_file(void* ptr, size_t size)
+{
+  (void) size;
+  UnmapViewOfFile(ptr);
+}
+
+#else
+
+static void* ge_raw_map_file(const char* filename, ge_raw_map_mode_t mode, size_t* size)
+{
+  const int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    GE_LOG_ERROR("Failed to open raw grid file! %s", filename);
+    return NULL;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size < GE_RAW_HEADER_SIZE) {
+    GE_LOG_ERROR("Raw grid file is too small! %s", filename);
+    close(fd);
+    return NULL;
+  }
+  // Private mappings are copy on write, and never change the file
+  const int prot = (mode == GE_RAW_MAP_MODE_READ_ONLY ? PROT_READ : PROT_READ | PROT_WRITE);
+  void* const ptr = mmap(NULL, file_stat.st_size, prot, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file
+  close(fd);
+  if (ptr == MAP_FAILED) {
+    GE_LOG_ERROR("Failed to map raw grid file! %s", filename);
+    return NULL;
+  }
+  *size = file_stat.st_size;
+  return ptr;
+}
+
+static void ge_raw_unmap_file(void* ptr, size_t size)
+{
+  munmap(ptr, size);
+}
+
+#endif
+
+static void ge_raw_free_mapping(void* user_data)
+{
+  ge_raw_mapping_t* const mapping = user_data;
+  ge_raw_unmap_file(mapping->ptr, mapping->size);
+  free(mapping);
+}
+
+static void write_u64_le(uint8_t* bytes, uint64_t value)
+{
+  for (size_t ii = 0; ii < 8; ++ii) {
+    bytes[ii] = (value >> (8 * ii)) & 0xFF;
+  }
+}
+
+static uint64_t read_u64_le(const uint8_t* bytes)
+{
+  uint64_t value = 0;
+  for (size_t ii = 0; ii < 8; ++ii) {
+    value |= (uint64_t) bytes[ii] << (8 * ii);
+  }
+  return value;
+}
@@ -5,39 +5,63 @@
 
 #include "grid_engine/sc_view.h"
 
-#include <assert.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "grid_engine/log.h"
+#include "grid_engine/mipmap.h"
+#include "grid_engine/tl_grid.h"
 
 typedef struct ge_sc_view {
   const ge_grid_t* source_grid;
+  // Tiled sources are copied through a window grid, big enough for any blit
+  ge_tl_grid_t* tl_source_grid;
+  ge_grid_t* window_grid;
+  size_t source_width;
+  size_t source_height;
   ge_grid_t* render_grid;
-  size_t pixel_multiplier;
+  size_t pixel_multiplier;  // Zero if the zoom isn't a whole number
+  double zoom;
   ge_rect_t sc_rect;
+  // The corner of the view in render pixels, which keeps the fraction of a source pixel
+  ge_coord_t subpx_coord;
+  // Other zoom levels sample the source, or a mipmap of it when zoomed out
+  ge_mipmap_t* mipmap;
+  ge_mipmap_mode_t mipmap_mode;
+  size_t* sample_arr;
+  // What the render grid currently shows, so it can be reused by the next refresh
+  bool is_rendered;
+  ge_coord_t rendered_subpx_coord;
+  uint64_t rendered_source_generation;
+  uint64_t rendered_generation;
 } ge_sc_view_t;
 
+static ge_sc_view_t* ge_sc_view_create_impl(size_t width, size_t height, size_t pixel_multiplier,
+                                            const ge_grid_t* source_grid,
+                                            ge_tl_grid_t* tl_source_grid);
+static void ge_sc_view_set_subpx_coord(ge_sc_view_t* view, ge_coord_t subpx_coord);
+static ge_coord_t ge_sc_view_get_max_subpx_coord(const ge_sc_view_t* view);
+static void ge_sc_view_update_sc_rect(ge_sc_view_t* view);
+static void ge_sc_view_blit(ge_sc_view_t* view, bool is_current);
+static void ge_sc_view_blit_render_rect(ge_sc_view_t* view, ge_rect_t render_rect);
+static void ge_sc_view_shift_render_grid(ge_sc_view_t* view, ge_coord_t shift);
+static void ge_sc_view_resample(ge_sc_view_t* view);
+static void ge_sc_view_prefetch(ge_sc_view_t* view, ge_coord_t shift);
+static void abort_on_invalid_zoom(double zoom);
+static ptrdiff_t pd_abs(ptrdiff_t v);
+
 ge_sc_view_t* ge_sc_view_create(size_t width, size_t height, size_t pixel_multiplier,
                                 const ge_grid_t* source_grid)
 {
-  // TODO Support smaller grid viewing
-  assert(width / pixel_multiplier <= ge_grid_get_width(source_grid));
-  assert(height / pixel_multiplier <= ge_grid_get_height(source_grid));
-  ge_sc_view_t* view = calloc(1, sizeof(ge_sc_view_t));
-  if (view == NULL) {
-    return NULL;
-  }
-  view->source_grid = source_grid;
-  view->render_grid = ge_grid_create(width, height);
-  if (view->render_grid == NULL) {
-    free(view);
-    return NULL;
-  }
-  view->pixel_multiplier = pixel_multiplier;
-  // The width and height should be constant, but the coord can change
-  view->sc_rect = ge_rect_from_wh(width / pixel_multiplier, height / pixel_multiplier);
-  return view;
+  return ge_sc_view_create_impl(width, height, pixel_multiplier, source_grid, NULL);
+}
+
+ge_sc_view_t* ge_sc_view_create_tl(size_t width, size_t height, size_t pixel_multiplier,
+                                   ge_tl_grid_t* tl_source_grid)
+{
+  return ge_sc_view_create_impl(width, height, pixel_multiplier, NULL, tl_source_grid);
 }
 
 void ge_sc_view_free(ge_sc_view_t* view)
@@ -45,14 +69,39 @@ void ge_sc_view_free(ge_sc_view_t* view)
   if (view == NULL) {
     return;
   }
+  ge_grid_free(view->window_grid);
   ge_grid_free(view->render_grid);
+  ge_mipmap_free(view->mipmap);
+  free(view->sample_arr);
   free(view);
 }
 
 void ge_sc_view_refresh(ge_sc_view_t* view)
 {
-  ge_grid_scale_blit_rect(view->render_grid, view->source_grid, view->sc_rect, (ge_coord_t){0, 0},
-                          view->pixel_multiplier);
+  // The old contents can only be reused if nothing else has drawn on either grid since
+  const uint64_t source_generation =
+      (view->tl_source_grid != NULL ? ge_tl_grid_get_generation(view->tl_source_grid)
+                                    : ge_grid_get_generation(view->source_grid));
+  const uint64_t generation = ge_grid_get_generation(view->render_grid);
+  const bool is_current =
+      (view->is_rendered && source_generation == view->rendered_source_generation
+       && generation == view->rendered_generation);
+  if (is_current && ge_coord_equals(view->subpx_coord, view->rendered_subpx_coord)) {
+    return;
+  }
+  if (view->pixel_multiplier == 0) {
+    ge_sc_view_resample(view);
+  }
+  else {
+    ge_sc_view_blit(view, is_current);
+  }
+  if (view->tl_source_grid != NULL && view->is_rendered) {
+    ge_sc_view_prefetch(view, ge_coord_sub(view->subpx_coord, view->rendered_subpx_coord));
+  }
+  view->is_rendered = true;
+  view->rendered_subpx_coord = view->subpx_coord;
+  view->rendered_source_generation = source_generation;
+  view->rendered_generation = ge_grid_get_generation(view->render_grid);
 }
 
 ge_grid_t* ge_sc_view_get_render_grid(ge_sc_view_t* view)
@@ -64,67 +113,358 @@ ge_grid_t* ge_sc_view_resize(ge_sc_view_t* view, size_t width, size_t height)
 {
   // Create a new render grid
   ge_grid_t* const new_render_grid = ge_grid_create(width, height);
-  if (new_render_grid == NULL) {
+  size_t* const new_sample_arr =
+      malloc((width + height != 0 ? width + height : 1) * sizeof(size_t));
+  ge_grid_t* const new_window_grid =
+      (view->tl_source_grid != NULL ? ge_grid_create(width + 1, height + 1) : NULL);
+  if (new_render_grid == NULL || new_sample_arr == NULL
+      || (view->tl_source_grid != NULL && new_window_grid == NULL)) {
+    ge_grid_free(new_render_grid);
+    free(new_sample_arr);
+    ge_grid_free(new_window_grid);
     return NULL;
   }
   // Replace the old render grid
   ge_grid_free(view->render_grid);
+  free(view->sample_arr);
+  ge_grid_free(view->window_grid);
   view->render_grid = new_render_grid;
+  view->sample_arr = new_sample_arr;
+  view->window_grid = new_window_grid;
+  view->is_rendered = false;
+  ge_sc_view_update_sc_rect(view);
   return view->render_grid;
 }
 
+void ge_sc_view_set_zoom(ge_sc_view_t* view, double zoom)
+{
+  abort_on_invalid_zoom(zoom);
+  // Keep the same source position in the corner of the view
+  view->subpx_coord = (ge_coord_t){floor(view->subpx_coord.x / view->zoom * zoom),
+                                   floor(view->subpx_coord.y / view->zoom * zoom)};
+  // Whole number zoom levels can use the faster scale blit
+  view->zoom = zoom;
+  view->pixel_multiplier = (zoom >= 1.0 && zoom == floor(zoom) ? (size_t) zoom : 0);
+  view->is_rendered = false;
+  ge_sc_view_update_sc_rect(view);
+}
+
+double ge_sc_view_get_zoom(const ge_sc_view_t* view)
+{
+  return view->zoom;
+}
+
+void ge_sc_view_set_mipmap_mode(ge_sc_view_t* view, ge_mipmap_mode_t mode)
+{
+  view->mipmap_mode = mode;
+  if (view->mipmap != NULL) {
+    ge_mipmap_set_mode(view->mipmap, mode);
+    view->is_rendered = false;
+  }
+}
+
+void ge_sc_view_mark_dirty(ge_sc_view_t* view, ge_rect_t rect)
+{
+  // Without a mipmap, there's nothing to update
+  if (view->mipmap != NULL) {
+    ge_mipmap_mark_dirty(view->mipmap, rect);
+  }
+}
+
 double ge_sc_view_get_max_x_abs_scroll(const ge_sc_view_t* view)
 {
-  const size_t subpx_width = ge_grid_get_width(view->source_grid) * view->pixel_multiplier;
-  const size_t subpx_max_x = subpx_width - ge_grid_get_width(view->render_grid);
-  return (double) subpx_max_x / view->pixel_multiplier;
+  const double subpx_width = view->source_width * view->zoom;
+  const double subpx_max_x = fmax(0.0, subpx_width - ge_grid_get_width(view->render_grid));
+  return subpx_max_x / view->zoom;
 }
 
 double ge_sc_view_get_max_y_abs_scroll(const ge_sc_view_t* view)
 {
-  const size_t subpx_height = ge_grid_get_height(view->source_grid) * view->pixel_multiplier;
-  const size_t subpx_max_y = subpx_height - ge_grid_get_height(view->render_grid);
-  return (double) subpx_max_y / view->pixel_multiplier;
+  const double subpx_height = view->source_height * view->zoom;
+  const double subpx_max_y = fmax(0.0, subpx_height - ge_grid_get_height(view->render_grid));
+  return subpx_max_y / view->zoom;
 }
 
 void ge_sc_view_scroll_to_x_abs(ge_sc_view_t* view, double x)
 {
-  // IEEE 754 doubles can exactly represent up to 52-bit integers
-  const ptrdiff_t xf = floor(x);
-  const ge_coord_t new_coord = {xf, view->sc_rect.min_coord.y};
-  const ge_rect_t new_rect = ge_rect_set_coord(view->sc_rect, new_coord);
-  const ge_rect_t source_rect = ge_grid_get_rect(view->source_grid);
-  if (!ge_rect_within_rect(source_rect, new_rect)) {
-    GE_LOG_ERROR("Scroll view exeeds bounds of source grid");
-    abort();
-  }
-  view->sc_rect = new_rect;
+  // Scroll by whole render pixels, which may be a fraction of a source pixel
+  const ptrdiff_t subpx_x = floor(x * view->zoom);
+  ge_sc_view_set_subpx_coord(view, (ge_coord_t){subpx_x, view->subpx_coord.y});
 }
 
 void ge_sc_view_scroll_to_y_abs(ge_sc_view_t* view, double y)
 {
-  // IEEE 754 doubles can exactly represent up to 52-bit integers
-  const ptrdiff_t yf = floor(y);
-  const ge_coord_t new_coord = {view->sc_rect.min_coord.x, yf};
-  const ge_rect_t new_rect = ge_rect_set_coord(view->sc_rect, new_coord);
-  const ge_rect_t source_rect = ge_grid_get_rect(view->source_grid);
-  if (!ge_rect_within_rect(source_rect, new_rect)) {
-    GE_LOG_ERROR("Scroll view exeeds bounds of source grid");
-    abort();
-  }
-  view->sc_rect = new_rect;
+  // Scroll by whole render pixels, which may be a fraction of a source pixel
+  const ptrdiff_t subpx_y = floor(y * view->zoom);
+  ge_sc_view_set_subpx_coord(view, (ge_coord_t){view->subpx_coord.x, subpx_y});
 }
 
 void ge_sc_view_scroll_to_x_pcnt(ge_sc_view_t* view, double percent_x)
 {
   const double ratio_x = fmax(0.0, fmin(percent_x / 100.0, 1.0));
-  const size_t delta_x = ge_grid_get_width(view->source_grid) - ge_rect_get_width(view->sc_rect);
-  ge_sc_view_scroll_to_x_abs(view, round(ratio_x * delta_x));
+  ge_sc_view_scroll_to_x_abs(view, ratio_x * ge_sc_view_get_max_x_abs_scroll(view));
 }
 
 void ge_sc_view_scroll_to_y_pcnt(ge_sc_view_t* view, double percent_y)
 {
   const double ratio_y = fmax(0.0, fmin(percent_y / 100.0, 1.0));
-  const size_t delta_y = ge_grid_get_height(view->source_grid) - ge_rect_get_height(view->sc_rect);
-  ge_sc_view_scroll_to_y_abs(view, round(ratio_y * delta_y));
+  ge_sc_view_scroll_to_y_abs(view, ratio_y * ge_sc_view_get_max_y_abs_scroll(view));
+}
+
+static ge_sc_view_t* ge_sc_view_create_impl(size_t width, size_t height, size_t pixel_multiplier,
+                                            const ge_grid_t* source_grid,
+                                            ge_tl_grid_t* tl_source_grid)
+{
+  abort_on_invalid_zoom(pixel_multiplier);
+  ge_sc_view_t* view = calloc(1, sizeof(ge_sc_view_t));
+  if (view == NULL) {
+    return NULL;
+  }
+  view->source_grid = source_grid;
+  view->tl_source_grid = tl_source_grid;
+  if (tl_source_grid != NULL) {
+    view->source_width = ge_tl_grid_get_width(tl_source_grid);
+    view->source_height = ge_tl_grid_get_height(tl_source_grid);
+    view->window_grid = ge_grid_create(width + 1, height + 1);
+  }
+  else {
+    view->source_width = ge_grid_get_width(source_grid);
+    view->source_height = ge_grid_get_height(source_grid);
+  }
+  view->render_grid = ge_grid_create(width, height);
+  view->sample_arr = malloc((width + height != 0 ? width + height : 1) * sizeof(size_t));
+  if (view->render_grid == NULL || view->sample_arr == NULL
+      || (tl_source_grid != NULL && view->window_grid == NULL)) {
+    ge_sc_view_free(view);
+    return NULL;
+  }
+  view->pixel_multiplier = pixel_multiplier;
+  view->zoom = pixel_multiplier;
+  view->mipmap_mode = GE_MIPMAP_MODE_MAX;
+  // The width and height only change with the zoom, but the coord changes with scrolling
+  ge_sc_view_update_sc_rect(view);
+  return view;
+}
+
+static void ge_sc_view_set_subpx_coord(ge_sc_view_t* view, ge_coord_t subpx_coord)
+{
+  const ge_coord_t max_subpx_coord = ge_sc_view_get_max_subpx_coord(view);
+  if (subpx_coord.x < 0 || subpx_coord.y < 0 || subpx_coord.x > max_subpx_coord.x
+      || subpx_coord.y > max_subpx_coord.y) {
+    GE_LOG_ERROR("Scroll view exeeds bounds of source grid");
+    abort();
+  }
+  view->subpx_coord = subpx_coord;
+  ge_sc_view_update_sc_rect(view);
+}
+
+static ge_coord_t ge_sc_view_get_max_subpx_coord(const ge_sc_view_t* view)
+{
+  const double subpx_width = view->source_width * view->zoom;
+  const double subpx_height = view->source_height * view->zoom;
+  return (ge_coord_t){
+      floor(fmax(0.0, subpx_width - ge_grid_get_width(view->render_grid))),
+      floor(fmax(0.0, subpx_height - ge_grid_get_height(view->render_grid))),
+  };
+}
+
+static void ge_sc_view_update_sc_rect(ge_sc_view_t* view)
+{
+  // Keep the corner in bounds, since the zoom or the size of the view may have changed
+  const ge_coord_t max_subpx_coord = ge_sc_view_get_max_subpx_coord(view);
+  view->subpx_coord.x =
+      (view->subpx_coord.x < max_subpx_coord.x ? view->subpx_coord.x : max_subpx_coord.x);
+  view->subpx_coord.y =
+      (view->subpx_coord.y < max_subpx_coord.y ? view->subpx_coord.y : max_subpx_coord.y);
+  // The rect covers the whole source pixels in view, and never goes past the source grid
+  const size_t source_width = view->source_width;
+  const size_t source_height = view->source_height;
+  const size_t view_width = ge_grid_get_width(view->render_grid) / view->zoom;
+  const size_t view_height = ge_grid_get_height(view->render_grid) / view->zoom;
+  const size_t width = (view_width < source_width ? view_width : source_width);
+  const size_t height = (view_height < source_height ? view_height : source_height);
+  const ge_coord_t coord = {floor(view->subpx_coord.x / view->zoom),
+                            floor(view->subpx_coord.y / view->zoom)};
+  view->sc_rect = ge_rect_from_coord_wh(coord, width, height);
+}
+
+static void ge_sc_view_blit(ge_sc_view_t* view, bool is_current)
+{
+  // After a short scroll, most of the old contents can be moved instead of drawn again
+  const ge_rect_t render_rect = ge_grid_get_rect(view->render_grid);
+  const size_t render_width = ge_rect_get_width(render_rect);
+  const size_t render_height = ge_rect_get_height(render_rect);
+  const bool is_covered =
+      (view->source_width * view->pixel_multiplier >= render_width
+       && view->source_height * view->pixel_multiplier >= render_height);
+  const ge_coord_t shift = ge_coord_sub(view->subpx_coord, view->rendered_subpx_coord);
+  if (is_current && is_covered && (size_t) pd_abs(shift.x) < render_width
+      && (size_t) pd_abs(shift.y) < render_height) {
+    ge_sc_view_shift_render_grid(view, shift);
+  }
+  else {
+    // Anything outside of the source grid is left blank
+    if (!is_covered) {
+      ge_grid_clear_pixel_arr(view->render_grid);
+    }
+    ge_sc_view_blit_render_rect(view, render_rect);
+  }
+}
+
+static void ge_sc_view_blit_render_rect(ge_sc_view_t* view, ge_rect_t render_rect)
+{
+  // Start the blit part way into the first source pixel. The blit may go a little past the rect,
+  // but those pixels get the values they should have anyway.
+  const ptrdiff_t pixel_multiplier = view->pixel_multiplier;
+  const ge_coord_t subpx_min_coord = ge_coord_add(view->subpx_coord, render_rect.min_coord);
+  const ge_coord_t subpx_max_coord = ge_coord_add(view->subpx_coord, render_rect.max_coord);
+  const ge_coord_t subpx_offset = {subpx_min_coord.x % pixel_multiplier,
+                                   subpx_min_coord.y % pixel_multiplier};
+  const ge_coord_t round_up = {pixel_multiplier - 1, pixel_multiplier - 1};
+  const ge_rect_t blit_rect = {
+      ge_coord_div(subpx_min_coord, pixel_multiplier),
+      ge_coord_div(ge_coord_add(subpx_max_coord, round_up), pixel_multiplier),
+  };
+  const ge_rect_t source_rect = ge_rect_from_wh(view->source_width, view->source_height);
+  const ge_rect_t overlap_rect = ge_rect_overlap(source_rect, blit_rect);
+  const ge_coord_t coord = ge_coord_sub(render_rect.min_coord, subpx_offset);
+  if (view->tl_source_grid != NULL) {
+    // Page in the tiles under the rect, then blit from the copy
+    ge_tl_grid_copy_rect(view->tl_source_grid, overlap_rect, view->window_grid, (ge_coord_t){0, 0});
+    ge_grid_scale_blit_rect(view->render_grid, view->window_grid,
+                            ge_rect_sub(overlap_rect, overlap_rect.min_coord), coord,
+                            pixel_multiplier);
+  }
+  else {
+    ge_grid_scale_blit_rect(view->render_grid, view->source_grid, overlap_rect, coord,
+                            pixel_multiplier);
+  }
+}
+
+static void ge_sc_view_shift_render_grid(ge_sc_view_t* view, ge_coord_t shift)
+{
+  // Move the pixels which are still in view, then draw the strips which were exposed
+  const size_t render_width = ge_grid_get_width(view->render_grid);
+  const size_t render_height = ge_grid_get_height(view->render_grid);
+  const size_t shift_x = pd_abs(shift.x);
+  const size_t shift_y = pd_abs(shift.y);
+  const size_t move_width = render_width - shift_x;
+  const size_t move_height = render_height - shift_y;
+  const size_t src_x = (shift.x > 0 ? shift_x : 0);
+  const size_t src_y = (shift.y > 0 ? shift_y : 0);
+  const size_t dest_x = (shift.x < 0 ? shift_x : 0);
+  const size_t dest_y = (shift.y < 0 ? shift_y : 0);
+  uint8_t* const pixel_arr = ge_grid_get_pixel_arr_mut(view->render_grid);
+  for (size_t jj = 0; jj < move_height; ++jj) {
+    // Moving down, the bottom rows must be moved first so they aren't overwritten
+    const size_t row = (shift.y < 0 ? move_height - 1 - jj : jj);
+    memmove(pixel_arr + render_width * (dest_y + row) + dest_x,
+            pixel_arr + render_width * (src_y + row) + src_x, move_width);
+  }
+  if (shift_x != 0) {
+    const ge_coord_t strip_coord = {shift.x > 0 ? move_width : 0, 0};
+    ge_sc_view_blit_render_rect(view, ge_rect_from_coord_wh(strip_coord, shift_x, render_height));
+  }
+  if (shift_y != 0) {
+    const ge_coord_t strip_coord = {0, shift.y > 0 ? move_height : 0};
+    ge_sc_view_blit_render_rect(view, ge_rect_from_coord_wh(strip_coord, render_width, shift_y));
+  }
+}
+
+static void ge_sc_view_resample(ge_sc_view_t* view)
+{
+  // Zoomed out, sample the mipmap level where pixels are closest to the size of render pixels
+  const ge_grid_t* grid = view->source_grid;
+  size_t level = 0;
+  if (view->zoom < 1.0 && view->mipmap == NULL && view->source_grid != NULL) {
+    view->mipmap = ge_mipmap_create(view->source_grid, view->mipmap_mode);
+    if (view->mipmap == NULL) {
+      GE_LOG_ERROR("Failed to create mipmap, so sampling the source grid instead");
+    }
+  }
+  if (view->zoom < 1.0 && view->mipmap != NULL) {
+    ge_mipmap_update(view->mipmap);
+    const size_t num_levels = ge_mipmap_get_num_levels(view->mipmap);
+    while (level + 1 < num_levels && ((size_t) 2 << level) * view->zoom <= 1.0) {
+      ++level;
+    }
+    grid = ge_mipmap_get_level(view->mipmap, level);
+  }
+  // Find the pixel to sample for each column and row, or `SIZE_MAX` if it's past the edge
+  const size_t level_width = (grid != NULL ? ge_grid_get_width(grid) : view->source_width);
+  const size_t level_height = (grid != NULL ? ge_grid_get_height(grid) : view->source_height);
+  const size_t render_width = ge_grid_get_width(view->render_grid);
+  const size_t render_height = ge_grid_get_height(view->render_grid);
+  const double level_scale = view->zoom * ((size_t) 1 << level);
+  size_t* const sample_x_arr = view->sample_arr;
+  size_t* const sample_y_arr = view->sample_arr + render_width;
+  for (size_t ii = 0; ii < render_width; ++ii) {
+    const size_t x = (view->subpx_coord.x + ii + 0.5) / level_scale;
+    sample_x_arr[ii] = (x < level_width ? x : SIZE_MAX);
+  }
+  for (size_t jj = 0; jj < render_height; ++jj) {
+    const size_t y = (view->subpx_coord.y + jj + 0.5) / level_scale;
+    sample_y_arr[jj] = (y < level_height ? y : SIZE_MAX);
+  }
+  const uint8_t* const level_pixel_arr = (grid != NULL ? ge_grid_get_pixel_arr(grid) : NULL);
+  uint8_t* const pixel_arr = ge_grid_get_pixel_arr_mut(view->render_grid);
+  for (size_t jj = 0; jj < render_height; ++jj) {
+    uint8_t* const dest_pixel_row = pixel_arr + render_width * jj;
+    if (sample_y_arr[jj] == SIZE_MAX) {
+      memset(dest_pixel_row, 0, render_width);
+      continue;
+    }
+    if (level_pixel_arr == NULL) {
+      // Tiled sources have no mipmap, so each pixel is sampled from its tile
+      for (size_t ii = 0; ii < render_width; ++ii) {
+        if (sample_x_arr[ii] == SIZE_MAX) {
+          dest_pixel_row[ii] = 0;
+          continue;
+        }
+        const ge_coord_t sample_coord = {sample_x_arr[ii], sample_y_arr[jj]};
+        dest_pixel_row[ii] = ge_tl_grid_get_coord(view->tl_source_grid, sample_coord);
+      }
+      continue;
+    }
+    const uint8_t* const src_pixel_row = level_pixel_arr + level_width * sample_y_arr[jj];
+    for (size_t ii = 0; ii < render_width; ++ii) {
+      dest_pixel_row[ii] = (sample_x_arr[ii] != SIZE_MAX ? src_pixel_row[sample_x_arr[ii]] : 0);
+    }
+  }
+}
+
+static void ge_sc_view_prefetch(ge_sc_view_t* view, ge_coord_t shift)
+{
+  // Load the tiles just past the edge of the view, in the direction it's scrolling
+  const ptrdiff_t tile_size = ge_tl_grid_get_tile_size(view->tl_source_grid);
+  ge_rect_t prefetch_rect = view->sc_rect;
+  prefetch_rect.max_coord = ge_coord_add(prefetch_rect.max_coord, (ge_coord_t){1, 1});
+  if (shift.x > 0) {
+    prefetch_rect.max_coord.x += tile_size;
+  }
+  else if (shift.x < 0) {
+    prefetch_rect.min_coord.x -= tile_size;
+  }
+  if (shift.y > 0) {
+    prefetch_rect.max_coord.y += tile_size;
+  }
+  else if (shift.y < 0) {
+    prefetch_rect.min_coord.y -= tile_size;
+  }
+  if (shift.x != 0 || shift.y != 0) {
+    ge_tl_grid_prefetch_rect(view->tl_source_grid, prefetch_rect);
+  }
+}
+
+static void abort_on_invalid_zoom(double zoom)
+{
+  if (!(zoom > 0.0)) {
+    GE_LOG_ERROR("Zoom must be greater than zero! %f", zoom);
+    abort();
+  }
+}
+
+static ptrdiff_t pd_abs(ptrdiff_t v)
+{
+  return (v > 0 ? v : -v);
 }
@@ -0,0 +1,760 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/sp_bitset.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_engine/log.h"
+
+// Each chunk covers 2^16 bits, so the low bits of an index always fit in a uint16_t
+#define GE_SP_CHUNK_BITS 16
+#define GE_SP_CHUNK_SIZE (UINT32_C(1) << GE_SP_CHUNK_BITS)
+#define GE_SP_CHUNK_NUM_VALUES (GE_SP_CHUNK_SIZE / 64)
+
+// Above this many bits an array takes more memory than a bitmap (8 KiB either way)
+#define GE_SP_ARRAY_MAX_SIZE 4096
+
+#define GE_SP_ARRAY_MIN_CAPACITY 4
+
+// Used for searches within a chunk, since valid positions are always less than 2^16
+#define GE_SP_NO_POS UINT32_MAX
+
+typedef enum ge_sp_kind {
+  GE_SP_KIND_ARRAY = 0,
+  GE_SP_KIND_BITMAP,
+  GE_SP_KIND_RUN,
+} ge_sp_kind_t;
+
+// An inclusive range of bits
+typedef struct ge_sp_run {
+  uint16_t first;
+  uint16_t last;
+} ge_sp_run_t;
+
+typedef struct ge_sp_chunk {
+  size_t key;
+  ge_sp_kind_t kind;
+  size_t num_set;
+  size_t num_items;  // Number of array entries or runs, unused for bitmaps
+  size_t capacity;   // Allocated array entries or runs, unused for bitmaps
+  union {
+    uint16_t* array;
+    uint64_t* bitmap;
+    ge_sp_run_t* runs;
+  };
+} ge_sp_chunk_t;
+
+typedef struct ge_sp_bitset {
+  size_t size;
+  size_t num_set;
+  size_t num_chunks;
+  size_t capacity;
+  ge_sp_chunk_t* chunks;
+} ge_sp_bitset_t;
+
+static size_t ge_sp_bitset_find_chunk(const ge_sp_bitset_t* bitset, size_t key);
+static ge_sp_chunk_t* ge_sp_bitset_insert_chunk(ge_sp_bitset_t* bitset, size_t chunk_index,
+                                                size_t key);
+static void ge_sp_bitset_remove_chunk(ge_sp_bitset_t* bitset, size_t chunk_index);
+static void ge_sp_chunk_free_data(ge_sp_chunk_t* chunk);
+static bool ge_sp_chunk_get(const ge_sp_chunk_t* chunk, uint16_t low);
+static bool ge_sp_chunk_set(ge_sp_chunk_t* chunk, uint16_t low, bool value, bool* changed);
+static uint32_t ge_sp_chunk_search(const ge_sp_chunk_t* chunk, uint32_t low);
+static uint64_t ge_sp_chunk_get_value(const ge_sp_chunk_t* chunk, size_t value_index);
+static bool ge_sp_chunk_or(ge_sp_chunk_t* chunk, const ge_sp_chunk_t* other);
+static bool ge_sp_chunk_copy(ge_sp_chunk_t* chunk, const ge_sp_chunk_t* other);
+static bool ge_sp_chunk_to_bitmap(ge_sp_chunk_t* chunk);
+static bool ge_sp_chunk_to_array(ge_sp_chunk_t* chunk);
+static bool ge_sp_chunk_to_runs(ge_sp_chunk_t* chunk, size_t num_runs);
+static bool ge_sp_chunk_unpack_runs(ge_sp_chunk_t* chunk);
+static size_t ge_sp_chunk_count_runs(const ge_sp_chunk_t* chunk);
+static size_t ge_sp_chunk_get_mem_usage(const ge_sp_chunk_t* chunk);
+static size_t lower_bound_u16(const uint16_t* array, size_t size, uint16_t value);
+static size_t lower_bound_runs(const ge_sp_run_t* runs, size_t size, uint16_t value);
+static void abort_on_out_of_bounds(const ge_sp_bitset_t* bitset, size_t index);
+static size_t get_first_bit_index(uint64_t value);
+static size_t get_num_bits(uint64_t value);
+
+ge_sp_bitset_t* ge_sp_bitset_create(size_t size)
+{
+  ge_sp_bitset_t* bitset = calloc(1, sizeof(ge_sp_bitset_t));
+  if (bitset == NULL) {
+    return NULL;
+  }
+  // Chunks are only allocated once they have a set bit
+  bitset->size = size;
+  bitset->num_set = 0;
+  bitset->num_chunks = 0;
+  bitset->capacity = 0;
+  bitset->chunks = NULL;
+  return bitset;
+}
+
+void ge_sp_bitset_free(ge_sp_bitset_t* bitset)
+{
+  if (bitset == NULL) {
+    return;
+  }
+  for (size_t ii = 0; ii < bitset->num_chunks; ++ii) {
+    ge_sp_chunk_free_data(&bitset->chunks[ii]);
+  }
+  free(bitset->chunks);
+  free(bitset);
+}
+
+bool ge_sp_bitset_set(ge_sp_bitset_t* bitset, size_t index, bool value)
+{
+  abort_on_out_of_bounds(bitset, index);
+  const size_t key = index >> GE_SP_CHUNK_BITS;
+  const uint16_t low = index & (GE_SP_CHUNK_SIZE - 1);
+  const size_t chunk_index = ge_sp_bitset_find_chunk(bitset, key);
+  const bool has_chunk =
+      (chunk_index < bitset->num_chunks && bitset->chunks[chunk_index].key == key);
+  if (!has_chunk && !value) {
+    return true;
+  }
+  ge_sp_chunk_t* const chunk =
+      (has_chunk ? &bitset->chunks[chunk_index]
+                 : ge_sp_bitset_insert_chunk(bitset, chunk_index, key));
+  if (chunk == NULL) {
+    return false;
+  }
+  bool changed = false;
+  const bool success = ge_sp_chunk_set(chunk, low, value, &changed);
+  if (changed) {
+    bitset->num_set = (value ? bitset->num_set + 1 : bitset->num_set - 1);
+  }
+  // Don't keep empty chunks around
+  if (chunk->num_set == 0) {
+    ge_sp_bitset_remove_chunk(bitset, chunk_index);
+  }
+  return success;
+}
+
+bool ge_sp_bitset_get(const ge_sp_bitset_t* bitset, size_t index)
+{
+  abort_on_out_of_bounds(bitset, index);
+  const size_t key = index >> GE_SP_CHUNK_BITS;
+  const size_t chunk_index = ge_sp_bitset_find_chunk(bitset, key);
+  if (chunk_index == bitset->num_chunks || bitset->chunks[chunk_index].key != key) {
+    return false;
+  }
+  return ge_sp_chunk_get(&bitset->chunks[chunk_index], index & (GE_SP_CHUNK_SIZE - 1));
+}
+
+size_t ge_sp_bitset_search(const ge_sp_bitset_t* bitset, size_t start_index)
+{
+  if (start_index != GE_BITSET_SEARCH_INIT) {
+    abort_on_out_of_bounds(bitset, start_index);
+  }
+  start_index = (start_index != GE_BITSET_SEARCH_INIT ? start_index + 1 : 0);
+  if (start_index >= bitset->size) {
+    return GE_BITSET_SEARCH_INIT;
+  }
+  // Only the first chunk can start part way through, the rest search from their first bit
+  const size_t start_key = start_index >> GE_SP_CHUNK_BITS;
+  for (size_t ii = ge_sp_bitset_find_chunk(bitset, start_key); ii < bitset->num_chunks; ++ii) {
+    const ge_sp_chunk_t* const chunk = &bitset->chunks[ii];
+    const uint32_t low = (chunk->key == start_key ? start_index & (GE_SP_CHUNK_SIZE - 1) : 0);
+    const uint32_t pos = ge_sp_chunk_search(chunk, low);
+    if (pos != GE_SP_NO_POS) {
+      return (chunk->key << GE_SP_CHUNK_BITS) | pos;
+    }
+  }
+  return GE_BITSET_SEARCH_INIT;
+}
+
+bool ge_sp_bitset_has_none(const ge_sp_bitset_t* bitset)
+{
+  return (bitset->num_set == 0);
+}
+
+bool ge_sp_bitset_has_any(const ge_sp_bitset_t* bitset)
+{
+  return !ge_sp_bitset_has_none(bitset);
+}
+
+bool ge_sp_bitset_has_all(const ge_sp_bitset_t* bitset)
+{
+  return (bitset->num_set == bitset->size);
+}
+
+size_t ge_sp_bitset_get_size(const ge_sp_bitset_t* bitset)
+{
+  return bitset->size;
+}
+
+size_t ge_sp_bitset_count(const ge_sp_bitset_t* bitset)
+{
+  return bitset->num_set;
+}
+
+size_t ge_sp_bitset_get_mem_usage(const ge_sp_bitset_t* bitset)
+{
+  size_t mem_usage = sizeof(ge_sp_bitset_t) + bitset->capacity * sizeof(ge_sp_chunk_t);
+  for (size_t ii = 0; ii < bitset->num_chunks; ++ii) {
+    mem_usage += ge_sp_chunk_get_mem_usage(&bitset->chunks[ii]);
+  }
+  return mem_usage;
+}
+
+bool ge_sp_bitset_or(ge_sp_bitset_t* bitset, const ge_sp_bitset_t* other)
+{
+  if (bitset->size != other->size) {
+    GE_LOG_ERROR("Bitsets are not the same size! (%zu / %zu)", bitset->size, other->size);
+    abort();
+  }
+  if (bitset == other) {
+    return true;
+  }
+  // Merge the chunks, copying any chunks we don't already have
+  size_t chunk_index = 0;
+  for (size_t ii = 0; ii < other->num_chunks; ++ii) {
+    const ge_sp_chunk_t* const other_chunk = &other->chunks[ii];
+    while (chunk_index < bitset->num_chunks && bitset->chunks[chunk_index].key < other_chunk->key) {
+      ++chunk_index;
+    }
+    bool success = false;
+    if (chunk_index < bitset->num_chunks && bitset->chunks[chunk_index].key == other_chunk->key) {
+      ge_sp_chunk_t* const chunk = &bitset->chunks[chunk_index];
+      bitset->num_set -= chunk->num_set;
+      success = ge_sp_chunk_or(chunk, other_chunk);
+      bitset->num_set += chunk->num_set;
+    }
+    else {
+      ge_sp_chunk_t* const chunk = ge_sp_bitset_insert_chunk(bitset, chunk_index, other_chunk->key);
+      success = (chunk != NULL && ge_sp_chunk_copy(chunk, other_chunk));
+      if (chunk != NULL) {
+        if (!success) {
+          ge_sp_bitset_remove_chunk(bitset, chunk_index);
+        }
+        bitset->num_set += (success ? chunk->num_set : 0);
+      }
+    }
+    if (!success) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ge_sp_bitset_optimize(ge_sp_bitset_t* bitset)
+{
+  for (size_t ii = 0; ii < bitset->num_chunks; ++ii) {
+    ge_sp_chunk_t* const chunk = &bitset->chunks[ii];
+    if (chunk->kind == GE_SP_KIND_RUN) {
+      continue;
+    }
+    // Runs take 4 bytes each, compared to 2 bytes per bit in an array, or 8 KiB for a bitmap
+    const size_t num_runs = ge_sp_chunk_count_runs(chunk);
+    if (num_runs * sizeof(ge_sp_run_t) < ge_sp_chunk_get_mem_usage(chunk)) {
+      // If this fails, the chunk is left as it was
+      ge_sp_chunk_to_runs(chunk, num_runs);
+    }
+  }
+}
+
+bool ge_sp_bitset_next_value(const ge_sp_bitset_t* bitset, ge_bitset_value_t* bitset_value)
+{
+  // Find the next set bit at or after the next value, then build the value containing it
+  const size_t start_index =
+      (bitset_value->base_index != GE_BITSET_SEARCH_INIT ? bitset_value->base_index + 64 : 0);
+  const size_t index =
+      (start_index == 0
+           ? ge_sp_bitset_search(bitset, GE_BITSET_SEARCH_INIT)
+           : (start_index < bitset->size ? ge_sp_bitset_search(bitset, start_index - 1)
+                                         : GE_BITSET_SEARCH_INIT));
+  if (index == GE_BITSET_SEARCH_INIT) {
+    bitset_value->base_index = GE_BITSET_SEARCH_INIT;
+    bitset_value->value = 0;
+    return false;
+  }
+  const size_t key = index >> GE_SP_CHUNK_BITS;
+  const ge_sp_chunk_t* const chunk = &bitset->chunks[ge_sp_bitset_find_chunk(bitset, key)];
+  bitset_value->base_index = index & ~(size_t) 63;
+  bitset_value->value = ge_sp_chunk_get_value(chunk, (index & (GE_SP_CHUNK_SIZE - 1)) / 64);
+  return true;
+}
+
+ge_sp_bitset_t* ge_sp_bitset_from_bitset(const ge_bitset_t* dense_bitset)
+{
+  ge_sp_bitset_t* const bitset = ge_sp_bitset_create(ge_bitset_get_size(dense_bitset));
+  if (bitset == NULL) {
+    return NULL;
+  }
+  GE_FOR_BITSET_VALUES (bitset_value, dense_bitset) {
+    uint64_t value = bitset_value.value;
+    for (; value != 0; value &= value - 1) {
+      const size_t index = bitset_value.base_index + get_first_bit_index(value);
+      if (!ge_sp_bitset_set(bitset, index, true)) {
+        ge_sp_bitset_free(bitset);
+        return NULL;
+      }
+    }
+  }
+  return bitset;
+}
+
+ge_bitset_t* ge_sp_bitset_to_bitset(const ge_sp_bitset_t* bitset)
+{
+  ge_bitset_t* const dense_bitset = ge_bitset_create(bitset->size);
+  if (dense_bitset == NULL) {
+    return NULL;
+  }
+  GE_FOR_SP_BITSET_VALUES (bitset_value, bitset) {
+    uint64_t value = bitset_value.value;
+    for (; value != 0; value &= value - 1) {
+      ge_bitset_set(dense_bitset, bitset_value.base_index + get_first_bit_index(value), true);
+    }
+  }
+  return dense_bitset;
+}
+
+static size_t ge_sp_bitset_find_chunk(const ge_sp_bitset_t* bitset, size_t key)
+{
+  // Binary search for the first chunk with a key not less than the given key
+  size_t lo = 0;
+  size_t hi = bitset->num_chunks;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (bitset->chunks[mid].key < key) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static ge_sp_chunk_t* ge_sp_bitset_insert_chunk(ge_sp_bitset_t* bitset, size_t chunk_index,
+                                                size_t key)
+{
+  if (bitset->num_chunks == bitset->capacity) {
+    const size_t capacity = (bitset->capacity != 0 ? 2 * bitset->capacity : 4);
+    ge_sp_chunk_t* const chunks = realloc(bitset->chunks, capacity * sizeof(ge_sp_chunk_t));
+    if (chunks == NULL) {
+      return NULL;
+    }
+    bitset->capacity = capacity;
+    bitset->chunks = chunks;
+  }
+  // New chunks start out as empty arrays
+  uint16_t* const array = malloc(GE_SP_ARRAY_MIN_CAPACITY * sizeof(uint16_t));
+  if (array == NULL) {
+    return NULL;
+  }
+  memmove(bitset->chunks + chunk_index + 1, bitset->chunks + chunk_index,
+          (bitset->num_chunks - chunk_index) * sizeof(ge_sp_chunk_t));
+  ++bitset->num_chunks;
+  ge_sp_chunk_t* const chunk = &bitset->chunks[chunk_index];
+  chunk->key = key;
+  chunk->kind = GE_SP_KIND_ARRAY;
+  chunk->num_set = 0;
+  chunk->num_items = 0;
+  chunk->capacity = GE_SP_ARRAY_MIN_CAPACITY;
+  chunk->array = array;
+  return chunk;
+}
+
+static void ge_sp_bitset_remove_chunk(ge_sp_bitset_t* bitset, size_t chunk_index)
+{
+  ge_sp_chunk_free_data(&bitset->chunks[chunk_index]);
+  memmove(bitset->chunks + chunk_index, bitset->chunks + chunk_index + 1,
+          (bitset->num_chunks - chunk_index - 1) * sizeof(ge_sp_chunk_t));
+  --bitset->num_chunks;
+}
+
+static void ge_sp_chunk_free_data(ge_sp_chunk_t* chunk)
+{
+  // All the union members are allocated the same way
+  free(chunk->bitmap);
+  chunk->bitmap = NULL;
+}
+
+static bool ge_sp_chunk_get(const ge_sp_chunk_t* chunk, uint16_t low)
+{
+  switch (chunk->kind) {
+  case GE_SP_KIND_ARRAY: {
+    const size_t pos = lower_bound_u16(chunk->array, chunk->num_items, low);
+    return (pos < chunk->num_items && chunk->array[pos] == low);
+  }
+  case GE_SP_KIND_BITMAP:
+    return ((chunk->bitmap[low / 64] & (UINT64_C(1) << (low % 64))) != 0);
+  case GE_SP_KIND_RUN: {
+    const size_t pos = lower_bound_runs(chunk->runs, chunk->num_items, low);
+    return (pos < chunk->num_items && chunk->runs[pos].first <= low);
+  }
+  }
+  return false;
+}
+
+static bool ge_sp_chunk_set(ge_sp_chunk_t* chunk, uint16_t low, bool value, bool* changed)
+{
+  *changed = false;
+  if (ge_sp_chunk_get(chunk, low) == value) {
+    return true;
+  }
+  // Runs are only built by optimizing, so go back to an array or bitmap to modify them
+  if (chunk->kind == GE_SP_KIND_RUN && !ge_sp_chunk_unpack_runs(chunk)) {
+    return false;
+  }
+  if (chunk->kind == GE_SP_KIND_ARRAY && value && chunk->num_set == GE_SP_ARRAY_MAX_SIZE) {
+    if (!ge_sp_chunk_to_bitmap(chunk)) {
+      return false;
+    }
+  }
+  if (chunk->kind == GE_SP_KIND_ARRAY) {
+    const size_t pos = lower_bound_u16(chunk->array, chunk->num_items, low);
+    if (value) {
+      if (chunk->num_items == chunk->capacity) {
+        const size_t capacity = 2 * chunk->capacity;
+        uint16_t* const array = realloc(chunk->array, capacity * sizeof(uint16_t));
+        if (array == NULL) {
+          return false;
+        }
+        chunk->capacity = capacity;
+        chunk->array = array;
+      }
+      memmove(chunk->array + pos + 1, chunk->array + pos,
+              (chunk->num_items - pos) * sizeof(uint16_t));
+      chunk->array[pos] = low;
+      ++chunk->num_items;
+    }
+    else {
+      memmove(chunk->array + pos, chunk->array + pos + 1,
+              (chunk->num_items - pos - 1) * sizeof(uint16_t));
+      --chunk->num_items;
+    }
+    chunk->num_set = chunk->num_items;
+  }
+  else {
+    const uint64_t bit_mask = UINT64_C(1) << (low % 64);
+    chunk->bitmap[low / 64] =
+        (value ? chunk->bitmap[low / 64] | bit_mask : chunk->bitmap[low / 64] & ~bit_mask);
+    chunk->num_set = (value ? chunk->num_set + 1 : chunk->num_set - 1);
+    // Shrink back down to an array when it gets small enough, but it's ok if that fails
+    if (chunk->num_set <= GE_SP_ARRAY_MAX_SIZE / 2) {
+      ge_sp_chunk_to_array(chunk);
+    }
+  }
+  *changed = true;
+  return true;
+}
+
+static uint32_t ge_sp_chunk_search(const ge_sp_chunk_t* chunk, uint32_t low)
+{
+  if (low >= GE_SP_CHUNK_SIZE) {
+    return GE_SP_NO_POS;
+  }
+  switch (chunk->kind) {
+  case GE_SP_KIND_ARRAY: {
+    const size_t pos = lower_bound_u16(chunk->array, chunk->num_items, low);
+    return (pos < chunk->num_items ? chunk->array[pos] : GE_SP_NO_POS);
+  }
+  case GE_SP_KIND_BITMAP: {
+    size_t value_index = low / 64;
+    uint64_t value = chunk->bitmap[value_index] & (0xFFFFFFFFFFFFFFFF << (low % 64));
+    while (value == 0 && ++value_index < GE_SP_CHUNK_NUM_VALUES) {
+      value = chunk->bitmap[value_index];
+    }
+    return (value != 0 ? 64 * value_index + get_first_bit_index(value) : GE_SP_NO_POS);
+  }
+  case GE_SP_KIND_RUN: {
+    const size_t pos = lower_bound_runs(chunk->runs, chunk->num_items, low);
+    if (pos == chunk->num_items) {
+      return GE_SP_NO_POS;
+    }
+    return (chunk->runs[pos].first > low ? chunk->runs[pos].first : low);
+  }
+  }
+  return GE_SP_NO_POS;
+}
+
+static uint64_t ge_sp_chunk_get_value(const ge_sp_chunk_t* chunk, size_t value_index)
+{
+  const uint32_t first_low = 64 * value_index;
+  const uint32_t last_low = first_low + 63;
+  uint64_t value = 0;
+  switch (chunk->kind) {
+  case GE_SP_KIND_ARRAY: {
+    size_t pos = lower_bound_u16(chunk->array, chunk->num_items, first_low);
+    for (; pos < chunk->num_items && chunk->array[pos] <= last_low; ++pos) {
+      value |= UINT64_C(1) << (chunk->array[pos] - first_low);
+    }
+    break;
+  }
+  case GE_SP_KIND_BITMAP:
+    value = chunk->bitmap[value_index];
+    break;
+  case GE_SP_KIND_RUN: {
+    size_t pos = lower_bound_runs(chunk->runs, chunk->num_items, first_low);
+    for (; pos < chunk->num_items && chunk->runs[pos].first <= last_low; ++pos) {
+      const uint32_t first = (chunk->runs[pos].first > first_low ? chunk->runs[pos].first
+                                                                  : first_low);
+      const uint32_t last = (chunk->runs[pos].last < last_low ? chunk->runs[pos].last : last_low);
+      const uint64_t upper_mask = 0xFFFFFFFFFFFFFFFF >> (63 - (last - first_low));
+      value |= upper_mask & (0xFFFFFFFFFFFFFFFF << (first - first_low));
+    }
+    break;
+  }
+  }
+  return value;
+}
+
+static bool ge_sp_chunk_or(ge_sp_chunk_t* chunk, const ge_sp_chunk_t* other)
+{
+  // Small arrays can be merged directly, everything else is merged as a bitmap
+  if (chunk->kind == GE_SP_KIND_ARRAY && other->kind == GE_SP_KIND_ARRAY
+      && chunk->num_items + other->num_items <= GE_SP_ARRAY_MAX_SIZE) {
+    const size_t capacity = chunk->num_items + other->num_items;
+    uint16_t* const array = malloc((capacity > 0 ? capacity : 1) * sizeof(uint16_t));
+    if (array == NULL) {
+      return false;
+    }
+    size_t ii = 0;
+    size_t jj = 0;
+    size_t num_items = 0;
+    while (ii < chunk->num_items || jj < other->num_items) {
+      if (jj == other->num_items
+          || (ii < chunk->num_items && chunk->array[ii] < other->array[jj])) {
+        array[num_items++] = chunk->array[ii++];
+      }
+      else if (ii == chunk->num_items || other->array[jj] < chunk->array[ii]) {
+        array[num_items++] = other->array[jj++];
+      }
+      else {
+        array[num_items++] = chunk->array[ii++];
+        ++jj;
+      }
+    }
+    free(chunk->array);
+    chunk->array = array;
+    chunk->capacity = capacity;
+    chunk->num_items = num_items;
+    chunk->num_set = num_items;
+    return true;
+  }
+  if (chunk->kind != GE_SP_KIND_BITMAP && !ge_sp_chunk_to_bitmap(chunk)) {
+    return false;
+  }
+  size_t num_set = 0;
+  for (size_t ii = 0; ii < GE_SP_CHUNK_NUM_VALUES; ++ii) {
+    chunk->bitmap[ii] |= ge_sp_chunk_get_value(other, ii);
+    num_set += get_num_bits(chunk->bitmap[ii]);
+  }
+  chunk->num_set = num_set;
+  return true;
+}
+
+static bool ge_sp_chunk_copy(ge_sp_chunk_t* chunk, const ge_sp_chunk_t* other)
+{
+  size_t data_size = 0;
+  switch (other->kind) {
+  case GE_SP_KIND_ARRAY:
+    data_size = other->capacity * sizeof(uint16_t);
+    break;
+  case GE_SP_KIND_BITMAP:
+    data_size = GE_SP_CHUNK_NUM_VALUES * sizeof(uint64_t);
+    break;
+  case GE_SP_KIND_RUN:
+    data_size = other->capacity * sizeof(ge_sp_run_t);
+    break;
+  }
+  void* const data = malloc(data_size);
+  if (data == NULL) {
+    return false;
+  }
+  memcpy(data, other->bitmap, data_size);
+  ge_sp_chunk_free_data(chunk);
+  const size_t key = chunk->key;
+  *chunk = *other;
+  chunk->key = key;
+  chunk->bitmap = data;
+  return true;
+}
+
+static bool ge_sp_chunk_to_bitmap(ge_sp_chunk_t* chunk)
+{
+  uint64_t* const bitmap = calloc(GE_SP_CHUNK_NUM_VALUES, sizeof(uint64_t));
+  if (bitmap == NULL) {
+    return false;
+  }
+  for (size_t ii = 0; ii < GE_SP_CHUNK_NUM_VALUES; ++ii) {
+    bitmap[ii] = ge_sp_chunk_get_value(chunk, ii);
+  }
+  ge_sp_chunk_free_data(chunk);
+  chunk->kind = GE_SP_KIND_BITMAP;
+  chunk->num_items = 0;
+  chunk->capacity = 0;
+  chunk->bitmap = bitmap;
+  return true;
+}
+
+static bool ge_sp_chunk_to_array(ge_sp_chunk_t* chunk)
+{
+  const size_t capacity =
+      (chunk->num_set > GE_SP_ARRAY_MIN_CAPACITY ? chunk->num_set : GE_SP_ARRAY_MIN_CAPACITY);
+  uint16_t* const array = malloc(capacity * sizeof(uint16_t));
+  if (array == NULL) {
+    return false;
+  }
+  size_t num_items = 0;
+  for (size_t ii = 0; ii < GE_SP_CHUNK_NUM_VALUES; ++ii) {
+    uint64_t value = ge_sp_chunk_get_value(chunk, ii);
+    for (; value != 0; value &= value - 1) {
+      array[num_items++] = 64 * ii + get_first_bit_index(value);
+    }
+  }
+  ge_sp_chunk_free_data(chunk);
+  chunk->kind = GE_SP_KIND_ARRAY;
+  chunk->num_items = num_items;
+  chunk->capacity = capacity;
+  chunk->array = array;
+  return true;
+}
+
+static bool ge_sp_chunk_to_runs(ge_sp_chunk_t* chunk, size_t num_runs)
+{
+  ge_sp_run_t* const runs = malloc((num_runs > 0 ? num_runs : 1) * sizeof(ge_sp_run_t));
+  if (runs == NULL) {
+    return false;
+  }
+  // Walk the values looking for the edges of each run, skipping values with no edges
+  size_t num_items = 0;
+  bool in_run = false;
+  uint32_t first = 0;
+  for (size_t ii = 0; ii < GE_SP_CHUNK_NUM_VALUES; ++ii) {
+    const uint64_t value = ge_sp_chunk_get_value(chunk, ii);
+    if (value == (in_run ? 0xFFFFFFFFFFFFFFFF : 0)) {
+      continue;
+    }
+    for (size_t jj = 0; jj < 64; ++jj) {
+      const bool is_set = ((value >> jj) & 1) != 0;
+      if (is_set && !in_run) {
+        first = 64 * ii + jj;
+        in_run = true;
+      }
+      else if (!is_set && in_run) {
+        runs[num_items++] = (ge_sp_run_t){first, 64 * ii + jj - 1};
+        in_run = false;
+      }
+    }
+  }
+  if (in_run) {
+    runs[num_items++] = (ge_sp_run_t){first, GE_SP_CHUNK_SIZE - 1};
+  }
+  ge_sp_chunk_free_data(chunk);
+  chunk->kind = GE_SP_KIND_RUN;
+  chunk->num_items = num_items;
+  chunk->capacity = num_items;
+  chunk->runs = runs;
+  return true;
+}
+
+static bool ge_sp_chunk_unpack_runs(ge_sp_chunk_t* chunk)
+{
+  // Leave room for at least one more bit to be set in an array
+  if (chunk->num_set < GE_SP_ARRAY_MAX_SIZE) {
+    return ge_sp_chunk_to_array(chunk);
+  }
+  return ge_sp_chunk_to_bitmap(chunk);
+}
+
+static size_t ge_sp_chunk_count_runs(const ge_sp_chunk_t* chunk)
+{
+  // Count the rising edges of each value, carrying the last bit of the previous value
+  size_t num_runs = 0;
+  uint64_t carry_bit = 0;
+  for (size_t ii = 0; ii < GE_SP_CHUNK_NUM_VALUES; ++ii) {
+    const uint64_t value = ge_sp_chunk_get_value(chunk, ii);
+    num_runs += get_num_bits(value & ~((value << 1) | carry_bit));
+    carry_bit = value >> 63;
+  }
+  return num_runs;
+}
+
+static size_t ge_sp_chunk_get_mem_usage(const ge_sp_chunk_t* chunk)
+{
+  switch (chunk->kind) {
+  case GE_SP_KIND_ARRAY:
+    return chunk->capacity * sizeof(uint16_t);
+  case GE_SP_KIND_BITMAP:
+    return GE_SP_CHUNK_NUM_VALUES * sizeof(uint64_t);
+  case GE_SP_KIND_RUN:
+    return chunk->capacity * sizeof(ge_sp_run_t);
+  }
+  return 0;
+}
+
+static size_t lower_bound_u16(const uint16_t* array, size_t size, uint16_t value)
+{
+  size_t lo = 0;
+  size_t hi = size;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (array[mid] < value) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static size_t lower_bound_runs(const ge_sp_run_t* runs, size_t size, uint16_t value)
+{
+  // Find the first run which ends at or after the value
+  size_t lo = 0;
+  size_t hi = size;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (runs[mid].last < value) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static void abort_on_out_of_bounds(const ge_sp_bitset_t* bitset, size_t index)
+{
+  if (index >= bitset->size) {
+    GE_LOG_ERROR("Index is out of bounds! (%zu / %zu)", index, bitset->size);
+    abort();
+  }
+}
+
+static size_t get_first_bit_index(uint64_t value)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(value);
+#else
+  size_t first_bit_index = 0;
+  for (; (value & 1) == 0; value >>= 1) {
+    ++first_bit_index;
+  }
+  return first_bit_index;
+#endif
+}
+
+static size_t get_num_bits(uint64_t value)
+{
+#if defined(__GNUC__)
+  return __builtin_popcountll(value);
+#else
+  // See also: https://en.wikipedia.org/wiki/Hamming_weight
+  value = value - ((value >> 1) & 0x5555555555555555);
+  value = (value & 0x3333333333333333) + ((value >> 2) & 0x3333333333333333);
+  value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0F;
+  return (value * 0x0101010101010101) >> 56;
+#endif
+}
@@ -0,0 +1,326 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/stencil.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_engine/log.h"
+
+// Tiles are this many pixels wide, so the rows being summed stay in the L1 cache
+#define GE_STENCIL_TILE_WIDTH 256
+#define GE_STENCIL_PAD_WIDTH (GE_STENCIL_TILE_WIDTH + GE_STENCIL_MAX_SIZE - 1)
+// Bigger shifts would overflow the rounding
+#define GE_STENCIL_MAX_SHIFT 30
+
+typedef struct ge_stencil_task_data {
+  const ge_stencil_t* stencil;
+  const ge_stencil_sep_t* stencil_sep;
+  const uint8_t* source_pixel_arr;
+  uint8_t* dest_pixel_arr;
+  size_t width;
+  size_t height;
+  ge_stencil_edge_t edge;
+  uint8_t edge_value;
+  size_t num_tasks;
+} ge_stencil_task_data_t;
+
+static const size_t GE_STENCIL_MIN_PARALLEL_NUM_PIXELS = 1 << 16;
+
+static void ge_stencil_run(ge_stencil_task_data_t* task_data, const ge_grid_t* source_grid,
+                           ge_pool_t* pool, ge_grid_t* dest_grid);
+static void ge_stencil_task(size_t task_index, void* user_data);
+static void ge_stencil_sep_task(size_t task_index, void* user_data);
+static void ge_stencil_pad_row(const ge_stencil_task_data_t* task_data, ptrdiff_t x, ptrdiff_t y,
+                               size_t pad_width, uint8_t* pad_row);
+static bool ge_stencil_read_coord(const ge_stencil_task_data_t* task_data, ge_coord_t coord,
+                                  ge_coord_t* read_coord);
+static void ge_stencil_store_row(const int32_t* sum_row, size_t width, uint32_t shift,
+                                 int32_t offset, uint8_t* dest_row);
+static uint64_t ge_stencil_sum_abs_weights(const int32_t* weight_arr, size_t num_weights);
+static void abort_on_invalid_size(size_t size);
+static void abort_on_invalid_shift(uint32_t shift);
+static void abort_on_weight_overflow(uint64_t sum_abs_weights);
+static void abort_on_invalid_grids(const ge_grid_t* source_grid, const ge_grid_t* dest_grid);
+
+ge_stencil_sep_t ge_stencil_sep_binomial(size_t size)
+{
+  abort_on_invalid_size(size);
+  ge_stencil_sep_t stencil = {.size = size, .shift = 2 * (size - 1), .offset = 0};
+  // Each weight is a binomial coefficient, and each row of weights sums to a power of two
+  for (size_t ii = 0; ii < size; ++ii) {
+    int32_t weight = 1;
+    for (size_t jj = 0; jj < ii; ++jj) {
+      weight = weight * (size - 1 - jj) / (jj + 1);
+    }
+    stencil.x_weight_arr[ii] = weight;
+    stencil.y_weight_arr[ii] = weight;
+  }
+  return stencil;
+}
+
+void ge_stencil_apply(const ge_stencil_t* stencil, const ge_grid_t* source_grid,
+                      ge_stencil_edge_t edge, uint8_t edge_value, ge_pool_t* pool,
+                      ge_grid_t* dest_grid)
+{
+  abort_on_invalid_size(stencil->width);
+  abort_on_invalid_size(stencil->height);
+  abort_on_invalid_shift(stencil->shift);
+  abort_on_weight_overflow(
+      ge_stencil_sum_abs_weights(stencil->weight_arr, stencil->width * stencil->height));
+  ge_stencil_task_data_t task_data = {
+      .stencil = stencil,
+      .edge = edge,
+      .edge_value = edge_value,
+  };
+  ge_stencil_run(&task_data, source_grid, pool, dest_grid);
+}
+
+void ge_stencil_sep_apply(const ge_stencil_sep_t* stencil, const ge_grid_t* source_grid,
+                          ge_stencil_edge_t edge, uint8_t edge_value, ge_pool_t* pool,
+                          ge_grid_t* dest_grid)
+{
+  abort_on_invalid_size(stencil->size);
+  abort_on_invalid_shift(stencil->shift);
+  const uint64_t sum_abs_x_weights =
+      ge_stencil_sum_abs_weights(stencil->x_weight_arr, stencil->size);
+  const uint64_t sum_abs_y_weights =
+      ge_stencil_sum_abs_weights(stencil->y_weight_arr, stencil->size);
+  abort_on_weight_overflow(sum_abs_x_weights);
+  abort_on_weight_overflow(sum_abs_y_weights);
+  // Each sum is small enough now that the product can't overflow
+  abort_on_weight_overflow(sum_abs_x_weights * sum_abs_y_weights);
+  ge_stencil_task_data_t task_data = {
+      .stencil_sep = stencil,
+      .edge = edge,
+      .edge_value = edge_value,
+  };
+  ge_stencil_run(&task_data, source_grid, pool, dest_grid);
+}
+
+static void ge_stencil_run(ge_stencil_task_data_t* task_data, const ge_grid_t* source_grid,
+                           ge_pool_t* pool, ge_grid_t* dest_grid)
+{
+  abort_on_invalid_grids(source_grid, dest_grid);
+  task_data->source_pixel_arr = ge_grid_get_pixel_arr(source_grid);
+  task_data->dest_pixel_arr = ge_grid_get_pixel_arr_mut(dest_grid);
+  task_data->width = ge_grid_get_width(source_grid);
+  task_data->height = ge_grid_get_height(source_grid);
+  if (task_data->width == 0 || task_data->height == 0) {
+    return;
+  }
+  const size_t num_pixels = task_data->width * task_data->height;
+  const bool is_parallel = (pool != NULL && num_pixels >= GE_STENCIL_MIN_PARALLEL_NUM_PIXELS);
+  task_data->num_tasks = (is_parallel ? 4 * (ge_pool_get_num_workers(pool) + 1) : 1);
+  const ge_pool_func_t func = (task_data->stencil != NULL ? ge_stencil_task : ge_stencil_sep_task);
+  ge_pool_run((is_parallel ? pool : NULL), func, task_data, task_data->num_tasks);
+}
+
+static void ge_stencil_task(size_t task_index, void* user_data)
+{
+  const ge_stencil_task_data_t* const task_data = user_data;
+  const ge_stencil_t* const stencil = task_data->stencil;
+  const size_t width = task_data->width;
+  const size_t height = task_data->height;
+  const size_t begin_y = height * task_index / task_data->num_tasks;
+  const size_t end_y = height * (task_index + 1) / task_data->num_tasks;
+  const ptrdiff_t radius_x = stencil->width / 2;
+  const ptrdiff_t radius_y = stencil->height / 2;
+  // The padded source rows are kept in a ring, so each source row is only padded once per tile
+  uint8_t pad_arr[GE_STENCIL_MAX_SIZE][GE_STENCIL_PAD_WIDTH];
+  int32_t sum_row[GE_STENCIL_TILE_WIDTH];
+  for (size_t tile_x = 0; tile_x < width; tile_x += GE_STENCIL_TILE_WIDTH) {
+    const size_t tile_width =
+        (width - tile_x < GE_STENCIL_TILE_WIDTH ? width - tile_x : GE_STENCIL_TILE_WIDTH);
+    const size_t pad_width = tile_width + stencil->width - 1;
+    for (size_t jj = begin_y; jj < end_y; ++jj) {
+      // The first row of the tile needs every row in the ring, after that only the newest row
+      const size_t first_ky = (jj == begin_y ? 0 : stencil->height - 1);
+      for (size_t ky = first_ky; ky < stencil->height; ++ky) {
+        const size_t ring_index = (jj - begin_y + ky) % stencil->height;
+        ge_stencil_pad_row(task_data, tile_x - radius_x, jj + ky - radius_y, pad_width,
+                           pad_arr[ring_index]);
+      }
+      memset(sum_row, 0, tile_width * sizeof(int32_t));
+      for (size_t ky = 0; ky < stencil->height; ++ky) {
+        const uint8_t* const pad_row = pad_arr[(jj - begin_y + ky) % stencil->height];
+        for (size_t kx = 0; kx < stencil->width; ++kx) {
+          const int32_t weight = stencil->weight_arr[stencil->width * ky + kx];
+          if (weight == 0) {
+            continue;
+          }
+          // This loop has no edges or branches, so it can be vectorized
+          for (size_t ii = 0; ii < tile_width; ++ii) {
+            sum_row[ii] += weight * pad_row[ii + kx];
+          }
+        }
+      }
+      ge_stencil_store_row(sum_row, tile_width, stencil->shift, stencil->offset,
+                           task_data->dest_pixel_arr + width * jj + tile_x);
+    }
+  }
+}
+
+static void ge_stencil_sep_task(size_t task_index, void* user_data)
+{
+  const ge_stencil_task_data_t* const task_data = user_data;
+  const ge_stencil_sep_t* const stencil = task_data->stencil_sep;
+  const size_t size = stencil->size;
+  const size_t width = task_data->width;
+  const size_t height = task_data->height;
+  const size_t begin_y = height * task_index / task_data->num_tasks;
+  const size_t end_y = height * (task_index + 1) / task_data->num_tasks;
+  const ptrdiff_t radius = size / 2;
+  // The rows are summed horizontally as they're padded, and the sums are kept in a ring
+  uint8_t pad_row[GE_STENCIL_PAD_WIDTH];
+  int32_t x_sum_arr[GE_STENCIL_MAX_SIZE][GE_STENCIL_TILE_WIDTH];
+  int32_t sum_row[GE_STENCIL_TILE_WIDTH];
+  for (size_t tile_x = 0; tile_x < width; tile_x += GE_STENCIL_TILE_WIDTH) {
+    const size_t tile_width =
+        (width - tile_x < GE_STENCIL_TILE_WIDTH ? width - tile_x : GE_STENCIL_TILE_WIDTH);
+    for (size_t jj = begin_y; jj < end_y; ++jj) {
+      const size_t first_ky = (jj == begin_y ? 0 : size - 1);
+      for (size_t ky = first_ky; ky < size; ++ky) {
+        ge_stencil_pad_row(task_data, tile_x - radius, jj + ky - radius, tile_width + size - 1,
+                           pad_row);
+        int32_t* const x_sum_row = x_sum_arr[(jj - begin_y + ky) % size];
+        memset(x_sum_row, 0, tile_width * sizeof(int32_t));
+        for (size_t kx = 0; kx < size; ++kx) {
+          const int32_t weight = stencil->x_weight_arr[kx];
+          for (size_t ii = 0; ii < tile_width; ++ii) {
+            x_sum_row[ii] += weight * pad_row[ii + kx];
+          }
+        }
+      }
+      memset(sum_row, 0, tile_width * sizeof(int32_t));
+      for (size_t ky = 0; ky < size; ++ky) {
+        const int32_t weight = stencil->y_weight_arr[ky];
+        const int32_t* const x_sum_row = x_sum_arr[(jj - begin_y + ky) % size];
+        for (size_t ii = 0; ii < tile_width; ++ii) {
+          sum_row[ii] += weight * x_sum_row[ii];
+        }
+      }
+      ge_stencil_store_row(sum_row, tile_width, stencil->shift, stencil->offset,
+                           task_data->dest_pixel_arr + width * jj + tile_x);
+    }
+  }
+}
+
+static void ge_stencil_pad_row(const ge_stencil_task_data_t* task_data, ptrdiff_t x, ptrdiff_t y,
+                               size_t pad_width, uint8_t* pad_row)
+{
+  const ptrdiff_t width = task_data->width;
+  const ptrdiff_t end_x = x + pad_width;
+  const ptrdiff_t inside_begin_x = (x > 0 ? x : 0);
+  const ptrdiff_t inside_end_x = (end_x < width ? end_x : width);
+  // Most of the row is inside the grid, and can be copied all at once
+  ge_coord_t read_coord;
+  if (inside_begin_x < inside_end_x) {
+    uint8_t* const inside_row = pad_row + (inside_begin_x - x);
+    const size_t inside_width = inside_end_x - inside_begin_x;
+    if (ge_stencil_read_coord(task_data, (ge_coord_t){inside_begin_x, y}, &read_coord)) {
+      memcpy(inside_row, task_data->source_pixel_arr + width * read_coord.y + inside_begin_x,
+             inside_width);
+    }
+    else {
+      memset(inside_row, task_data->edge_value, inside_width);
+    }
+  }
+  // Only the pixels past the left and right edges are read one at a time
+  for (ptrdiff_t ii = x; ii < end_x; ++ii) {
+    if (ii == inside_begin_x) {
+      ii = (inside_end_x > ii ? inside_end_x : ii);
+      if (ii == end_x) {
+        break;
+      }
+    }
+    if (ge_stencil_read_coord(task_data, (ge_coord_t){ii, y}, &read_coord)) {
+      pad_row[ii - x] = task_data->source_pixel_arr[width * read_coord.y + read_coord.x];
+    }
+    else {
+      pad_row[ii - x] = task_data->edge_value;
+    }
+  }
+}
+
+static bool ge_stencil_read_coord(const ge_stencil_task_data_t* task_data, ge_coord_t coord,
+                                  ge_coord_t* read_coord)
+{
+  const size_t width = task_data->width;
+  const size_t height = task_data->height;
+  if (task_data->edge == GE_STENCIL_EDGE_CLAMP) {
+    *read_coord = ge_coord_clamp(coord, width, height);
+    return true;
+  }
+  else if (task_data->edge == GE_STENCIL_EDGE_WRAP) {
+    *read_coord = ge_coord_wrap(coord, width, height);
+    return true;
+  }
+  else {
+    *read_coord = coord;
+    return ge_coord_within(coord, width, height);
+  }
+}
+
+static void ge_stencil_store_row(const int32_t* sum_row, size_t width, uint32_t shift,
+                                 int32_t offset, uint8_t* dest_row)
+{
+  // Adding the offset before the shift gives the same result, and keeps the shift non-negative
+  const int64_t round = (shift > 0 ? (int64_t) 1 << (shift - 1) : 0);
+  const int64_t bias = round + (int64_t) offset * ((int64_t) 1 << shift);
+  for (size_t ii = 0; ii < width; ++ii) {
+    int64_t value = sum_row[ii] + bias;
+    value = (value > 0 ? value : 0) >> shift;
+    dest_row[ii] = (value < 255 ? value : 255);
+  }
+}
+
+static uint64_t ge_stencil_sum_abs_weights(const int32_t* weight_arr, size_t num_weights)
+{
+  uint64_t sum = 0;
+  for (size_t ii = 0; ii < num_weights; ++ii) {
+    sum += (weight_arr[ii] < 0 ? -(int64_t) weight_arr[ii] : weight_arr[ii]);
+  }
+  return sum;
+}
+
+static void abort_on_invalid_size(size_t size)
+{
+  if (size % 2 == 0 || size > GE_STENCIL_MAX_SIZE) {
+    GE_LOG_ERROR("Stencil size is invalid! %zu", size);
+    abort();
+  }
+}
+
+static void abort_on_invalid_shift(uint32_t shift)
+{
+  if (shift > GE_STENCIL_MAX_SHIFT) {
+    GE_LOG_ERROR("Stencil shift is too big! %u", (unsigned int) shift);
+    abort();
+  }
+}
+
+static void abort_on_weight_overflow(uint64_t sum_abs_weights)
+{
+  if (sum_abs_weights > INT32_MAX / 255) {
+    GE_LOG_ERROR("Stencil weights are too big! %llu", (unsigned long long) sum_abs_weights);
+    abort();
+  }
+}
+
+static void abort_on_invalid_grids(const ge_grid_t* source_grid, const ge_grid_t* dest_grid)
+{
+  if (source_grid == dest_grid) {
+    GE_LOG_ERROR("Stencil source and destination grids are the same!");
+    abort();
+  }
+  if (ge_grid_get_width(source_grid) != ge_grid_get_width(dest_grid)
+      || ge_grid_get_height(source_grid) != ge_grid_get_height(dest_grid)) {
+    GE_LOG_ERROR("Stencil source and destination grids are different sizes!");
+    abort();
+  }
+}
@@ -0,0 +1,276 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/text.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_engine/glyphs.h"
+#include "grid_engine/log.h"
+
+#define GE_TEXT_GLYPH_SIZE 8
+#define GE_TEXT_ADVANCE 9
+// Longer strings are drawn without the cache, including the null terminator
+#define GE_TEXT_CACHE_MAX_STR_SIZE 64
+
+typedef struct ge_text_cache_entry {
+  bool is_used;
+  uint64_t hash;
+  char str[GE_TEXT_CACHE_MAX_STR_SIZE];
+  ge_grid_t* mask_grid;  // Lit pixels are one, everything else is zero
+  size_t prev_entry_index;
+  size_t next_entry_index;
+} ge_text_cache_entry_t;
+
+typedef struct ge_text_cache {
+  size_t num_entries;
+  ge_text_cache_entry_t* entry_arr;
+  // Entries are linked from the most to the least recently drawn
+  size_t head_entry_index;
+  size_t tail_entry_index;
+} ge_text_cache_t;
+
+static void ge_text_draw_glyph(uint8_t* pixel_arr, size_t width, size_t height, uint64_t bitmap,
+                               ge_coord_t coord, uint8_t value);
+static bool ge_text_cache_render_entry(ge_text_cache_entry_t* entry, const char* str,
+                                       uint64_t hash);
+static void ge_text_cache_touch_entry(ge_text_cache_t* cache, size_t entry_index);
+static void ge_text_blit_mask(ge_grid_t* grid, const ge_grid_t* mask_grid, ge_coord_t coord,
+                              uint8_t value);
+static uint64_t ge_text_hash(const char* str);
+static void abort_on_zero_size(size_t size, const char* name);
+
+void ge_text_draw(ge_grid_t* grid, const char* str, ge_coord_t coord, uint8_t value)
+{
+  const size_t width = ge_grid_get_width(grid);
+  const size_t height = ge_grid_get_height(grid);
+  uint8_t* const pixel_arr = ge_grid_get_pixel_arr_mut(grid);
+  ge_coord_t glyph_coord = coord;
+  for (const char* ch = str; *ch != '\0'; ++ch) {
+    if (*ch == '\n') {
+      glyph_coord = (ge_coord_t){coord.x, glyph_coord.y + GE_TEXT_ADVANCE};
+      continue;
+    }
+    const uint64_t bitmap = ge_glyph_get_bitmap(*ch);
+    if (bitmap != 0) {
+      ge_text_draw_glyph(pixel_arr, width, height, bitmap, glyph_coord, value);
+    }
+    glyph_coord.x += GE_TEXT_ADVANCE;
+  }
+}
+
+ge_rect_t ge_text_get_rect(const char* str, ge_coord_t coord)
+{
+  size_t num_lines = 1;
+  size_t max_num_glyphs = 0;
+  size_t num_glyphs = 0;
+  for (const char* ch = str; *ch != '\0'; ++ch) {
+    if (*ch == '\n') {
+      ++num_lines;
+      num_glyphs = 0;
+      continue;
+    }
+    ++num_glyphs;
+    max_num_glyphs = (num_glyphs > max_num_glyphs ? num_glyphs : max_num_glyphs);
+  }
+  // There is no space after the last glyph, or below the last line
+  const size_t width = (max_num_glyphs != 0 ? GE_TEXT_ADVANCE * max_num_glyphs - 1 : 0);
+  const size_t height = GE_TEXT_ADVANCE * num_lines - 1;
+  return ge_rect_from_coord_wh(coord, width, height);
+}
+
+ge_text_cache_t* ge_text_cache_create(size_t num_entries)
+{
+  abort_on_zero_size(num_entries, "Number of text cache entries");
+  ge_text_cache_t* cache = calloc(1, sizeof(ge_text_cache_t));
+  if (cache == NULL) {
+    return NULL;
+  }
+  cache->entry_arr = calloc(num_entries, sizeof(ge_text_cache_entry_t));
+  if (cache->entry_arr == NULL) {
+    ge_text_cache_free(cache);
+    return NULL;
+  }
+  cache->num_entries = num_entries;
+  // All the entries start unused, linked in order
+  for (size_t ii = 0; ii < num_entries; ++ii) {
+    cache->entry_arr[ii].prev_entry_index = (ii != 0 ? ii - 1 : SIZE_MAX);
+    cache->entry_arr[ii].next_entry_index = (ii + 1 != num_entries ? ii + 1 : SIZE_MAX);
+  }
+  cache->head_entry_index = 0;
+  cache->tail_entry_index = num_entries - 1;
+  return cache;
+}
+
+void ge_text_cache_free(ge_text_cache_t* cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+  for (size_t ii = 0; ii < cache->num_entries; ++ii) {
+    ge_grid_free(cache->entry_arr[ii].mask_grid);
+  }
+  free(cache->entry_arr);
+  free(cache);
+}
+
+size_t ge_text_cache_get_num_entries(const ge_text_cache_t* cache)
+{
+  return cache->num_entries;
+}
+
+void ge_text_cache_draw(ge_text_cache_t* cache, ge_grid_t* grid, const char* str,
+                        ge_coord_t coord, uint8_t value)
+{
+  if (strlen(str) >= GE_TEXT_CACHE_MAX_STR_SIZE) {
+    ge_text_draw(grid, str, coord, value);
+    return;
+  }
+  // The cache is small, so a linear search is fast enough
+  const uint64_t hash = ge_text_hash(str);
+  size_t entry_index = SIZE_MAX;
+  for (size_t ii = 0; ii < cache->num_entries && entry_index == SIZE_MAX; ++ii) {
+    const ge_text_cache_entry_t* const entry = &cache->entry_arr[ii];
+    if (entry->is_used && entry->hash == hash && strcmp(entry->str, str) == 0) {
+      entry_index = ii;
+    }
+  }
+  if (entry_index == SIZE_MAX) {
+    // Replace the least recently drawn entry
+    entry_index = cache->tail_entry_index;
+    if (!ge_text_cache_render_entry(&cache->entry_arr[entry_index], str, hash)) {
+      ge_text_draw(grid, str, coord, value);
+      return;
+    }
+  }
+  ge_text_cache_touch_entry(cache, entry_index);
+  const ge_grid_t* const mask_grid = cache->entry_arr[entry_index].mask_grid;
+  if (mask_grid != NULL) {
+    ge_text_blit_mask(grid, mask_grid, coord, value);
+  }
+}
+
+static void ge_text_draw_glyph(uint8_t* pixel_arr, size_t width, size_t height, uint64_t bitmap,
+                               ge_coord_t coord, uint8_t value)
+{
+  // Clip the glyph to the grid first, so the loops don't need to check every pixel
+  const ptrdiff_t min_x = (coord.x < 0 ? -coord.x : 0);
+  const ptrdiff_t min_y = (coord.y < 0 ? -coord.y : 0);
+  const ptrdiff_t max_x = (coord.x + GE_TEXT_GLYPH_SIZE > (ptrdiff_t) width
+                               ? (ptrdiff_t) width - coord.x
+                               : GE_TEXT_GLYPH_SIZE);
+  const ptrdiff_t max_y = (coord.y + GE_TEXT_GLYPH_SIZE > (ptrdiff_t) height
+                               ? (ptrdiff_t) height - coord.y
+                               : GE_TEXT_GLYPH_SIZE);
+  for (ptrdiff_t jj = min_y; jj < max_y; ++jj) {
+    const uint8_t glyph_row = bitmap >> (GE_TEXT_GLYPH_SIZE * jj);
+    if (glyph_row == 0) {
+      continue;
+    }
+    const size_t row_index = width * (coord.y + jj);
+    for (ptrdiff_t ii = min_x; ii < max_x; ++ii) {
+      if ((glyph_row >> ii) & 1) {
+        pixel_arr[row_index + coord.x + ii] = value;
+      }
+    }
+  }
+}
+
+static bool ge_text_cache_render_entry(ge_text_cache_entry_t* entry, const char* str,
+                                       uint64_t hash)
+{
+  const ge_rect_t rect = ge_text_get_rect(str, (ge_coord_t){0, 0});
+  const size_t width = rect.max_coord.x;
+  const size_t height = rect.max_coord.y;
+  entry->is_used = false;
+  if (width == 0) {
+    // Nothing is drawn, so there's no mask
+    ge_grid_free(entry->mask_grid);
+    entry->mask_grid = NULL;
+  }
+  else if (entry->mask_grid != NULL && ge_grid_get_width(entry->mask_grid) == width
+           && ge_grid_get_height(entry->mask_grid) == height) {
+    ge_grid_clear_pixel_arr(entry->mask_grid);
+  }
+  else {
+    ge_grid_free(entry->mask_grid);
+    entry->mask_grid = ge_grid_create(width, height);
+    if (entry->mask_grid == NULL) {
+      return false;
+    }
+  }
+  if (entry->mask_grid != NULL) {
+    ge_text_draw(entry->mask_grid, str, (ge_coord_t){0, 0}, 1);
+  }
+  entry->is_used = true;
+  entry->hash = hash;
+  strcpy(entry->str, str);
+  return true;
+}
+
+static void ge_text_cache_touch_entry(ge_text_cache_t* cache, size_t entry_index)
+{
+  if (entry_index == cache->head_entry_index) {
+    return;
+  }
+  // Unlink the entry, which has a previous entry since it isn't the head
+  ge_text_cache_entry_t* const entry = &cache->entry_arr[entry_index];
+  cache->entry_arr[entry->prev_entry_index].next_entry_index = entry->next_entry_index;
+  if (entry->next_entry_index != SIZE_MAX) {
+    cache->entry_arr[entry->next_entry_index].prev_entry_index = entry->prev_entry_index;
+  }
+  else {
+    cache->tail_entry_index = entry->prev_entry_index;
+  }
+  // Then link it back in as the head
+  entry->prev_entry_index = SIZE_MAX;
+  entry->next_entry_index = cache->head_entry_index;
+  cache->entry_arr[cache->head_entry_index].prev_entry_index = entry_index;
+  cache->head_entry_index = entry_index;
+}
+
+static void ge_text_blit_mask(ge_grid_t* grid, const ge_grid_t* mask_grid, ge_coord_t coord,
+                              uint8_t value)
+{
+  const size_t mask_width = ge_grid_get_width(mask_grid);
+  const ge_rect_t rect =
+      ge_rect_overlap(ge_grid_get_rect(grid),
+                      ge_rect_from_coord_wh(coord, mask_width, ge_grid_get_height(mask_grid)));
+  if (rect.min_coord.x >= rect.max_coord.x || rect.min_coord.y >= rect.max_coord.y) {
+    return;
+  }
+  const size_t width = ge_grid_get_width(grid);
+  uint8_t* const pixel_arr = ge_grid_get_pixel_arr_mut(grid);
+  const uint8_t* const mask_pixel_arr = ge_grid_get_pixel_arr(mask_grid);
+  for (ptrdiff_t jj = rect.min_coord.y; jj < rect.max_coord.y; ++jj) {
+    const size_t row_index = width * jj;
+    const size_t mask_row_index = mask_width * (jj - coord.y) - coord.x;
+    // No branches, so compilers can vectorize the loop
+    for (ptrdiff_t ii = rect.min_coord.x; ii < rect.max_coord.x; ++ii) {
+      const uint8_t pixel = pixel_arr[row_index + ii];
+      pixel_arr[row_index + ii] = (mask_pixel_arr[mask_row_index + ii] != 0 ? value : pixel);
+    }
+  }
+}
+
+static uint64_t ge_text_hash(const char* str)
+{
+  // FNV-1a
+  uint64_t hash = 14695981039346656037u;
+  for (const char* ch = str; *ch != '\0'; ++ch) {
+    hash = (hash ^ (unsigned char) *ch) * 1099511628211u;
+  }
+  return hash;
+}
+
+static void abort_on_zero_size(size_t size, const char* name)
+{
+  if (size == 0) {
+    GE_LOG_ERROR("%s must be greater than zero!", name);
+    abort();
+  }
+}
@@ -0,0 +1,427 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/tl_grid.h"
+
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_engine/log.h"
+
+// The magic bytes, then the width, height, and tile size as little endian 64-bit integers
+#define GE_TL_GRID_HEADER_SIZE 32
+
+typedef struct ge_tl_grid_slot {
+  size_t tile_index;  // `SIZE_MAX` if the slot is empty
+  bool is_dirty;
+  // Slots are linked from the most recently used to the least recently used
+  size_t prev_slot_index;
+  size_t next_slot_index;
+} ge_tl_grid_slot_t;
+
+typedef struct ge_tl_grid {
+  SDL_RWops* rw;
+  size_t width;
+  size_t height;
+  size_t tile_size;
+  size_t num_tiles_x;
+  size_t num_tiles_y;
+  uint64_t generation;
+  size_t num_slots;
+  ge_tl_grid_slot_t* slot_arr;
+  uint8_t* slot_pixel_arr;  // The pixels of each slot, one tile after another
+  size_t* tile_slot_arr;    // The slot of each tile, or `SIZE_MAX` if it isn't cached
+  size_t head_slot_index;
+  size_t tail_slot_index;
+} ge_tl_grid_t;
+
+static const uint8_t GE_TL_GRID_MAGIC[8] = {'G', 'E', 'T', 'L', 'G', 'R', 'I', 'D'};
+
+static ge_tl_grid_t* ge_tl_grid_create_impl(SDL_RWops* rw, size_t width, size_t height,
+                                            size_t tile_size, size_t num_cached_tiles);
+static uint8_t* ge_tl_grid_get_tile(ge_tl_grid_t* tl_grid, size_t tile_index, bool is_write);
+static void ge_tl_grid_touch_slot(ge_tl_grid_t* tl_grid, size_t slot_index);
+static void ge_tl_grid_read_slot(ge_tl_grid_t* tl_grid, size_t slot_index, size_t tile_index);
+static bool ge_tl_grid_write_slot(ge_tl_grid_t* tl_grid, size_t slot_index);
+static void ge_tl_grid_copy_tiles(ge_tl_grid_t* tl_grid, ge_rect_t rect, uint8_t* pixel_arr,
+                                  size_t stride, bool is_write);
+static void write_u64_le(uint8_t* bytes, uint64_t value);
+static uint64_t read_u64_le(const uint8_t* bytes);
+static void abort_on_zero_size(size_t size, const char* name);
+static void abort_on_coord_out_of_bounds(const ge_tl_grid_t* tl_grid, ge_coord_t coord);
+static void abort_on_rect_out_of_bounds(ge_rect_t outer_rect, ge_rect_t rect);
+
+ge_tl_grid_t* ge_tl_grid_create(const char* filename, size_t width, size_t height,
+                                size_t tile_size, size_t num_cached_tiles)
+{
+  abort_on_zero_size(tile_size, "Tile size");
+  abort_on_zero_size(num_cached_tiles, "Number of cached tiles");
+  SDL_RWops* const rw = SDL_RWFromFile(filename, "w+b");
+  if (rw == NULL) {
+    GE_LOG_ERROR("Failed to create tiled grid file! %s", SDL_GetError());
+    return NULL;
+  }
+  // Only the header is written, since the tiles read as zero until they are written
+  uint8_t header[GE_TL_GRID_HEADER_SIZE];
+  memcpy(header, GE_TL_GRID_MAGIC, sizeof(GE_TL_GRID_MAGIC));
+  write_u64_le(header + 8, width);
+  write_u64_le(header + 16, height);
+  write_u64_le(header + 24, tile_size);
+  if (SDL_RWwrite(rw, header, 1, sizeof(header)) != sizeof(header)) {
+    GE_LOG_ERROR("Failed to write tiled grid header! %s", SDL_GetError());
+    SDL_RWclose(rw);
+    return NULL;
+  }
+  return ge_tl_grid_create_impl(rw, width, height, tile_size, num_cached_tiles);
+}
+
+ge_tl_grid_t* ge_tl_grid_open(const char* filename, size_t num_cached_tiles)
+{
+  abort_on_zero_size(num_cached_tiles, "Number of cached tiles");
+  SDL_RWops* const rw = SDL_RWFromFile(filename, "r+b");
+  if (rw == NULL) {
+    GE_LOG_ERROR("Failed to open tiled grid file! %s", SDL_GetError());
+    return NULL;
+  }
+  uint8_t header[GE_TL_GRID_HEADER_SIZE];
+  if (SDL_RWread(rw, header, 1, sizeof(header)) != sizeof(header)
+      || memcmp(header, GE_TL_GRID_MAGIC, sizeof(GE_TL_GRID_MAGIC)) != 0
+      || read_u64_le(header + 24) == 0) {
+    GE_LOG_ERROR("Tiled grid file has an invalid header!");
+    SDL_RWclose(rw);
+    return NULL;
+  }
+  return ge_tl_grid_create_impl(rw, read_u64_le(header + 8), read_u64_le(header + 16),
+                                read_u64_le(header + 24), num_cached_tiles);
+}
+
+void ge_tl_grid_free(ge_tl_grid_t* tl_grid)
+{
+  if (tl_grid == NULL) {
+    return;
+  }
+  if (!ge_tl_grid_flush(tl_grid)) {
+    GE_LOG_ERROR("Failed to write back tiles before freeing tiled grid!");
+  }
+  SDL_RWclose(tl_grid->rw);
+  free(tl_grid->slot_arr);
+  free(tl_grid->slot_pixel_arr);
+  free(tl_grid->tile_slot_arr);
+  free(tl_grid);
+}
+
+bool ge_tl_grid_flush(ge_tl_grid_t* tl_grid)
+{
+  bool is_ok = true;
+  for (size_t ii = 0; ii < tl_grid->num_slots; ++ii) {
+    if (tl_grid->slot_arr[ii].is_dirty) {
+      is_ok = ge_tl_grid_write_slot(tl_grid, ii) && is_ok;
+    }
+  }
+  return is_ok;
+}
+
+size_t ge_tl_grid_get_width(const ge_tl_grid_t* tl_grid)
+{
+  return tl_grid->width;
+}
+
+size_t ge_tl_grid_get_height(const ge_tl_grid_t* tl_grid)
+{
+  return tl_grid->height;
+}
+
+ge_rect_t ge_tl_grid_get_rect(const ge_tl_grid_t* tl_grid)
+{
+  return ge_rect_from_wh(tl_grid->width, tl_grid->height);
+}
+
+size_t ge_tl_grid_get_tile_size(const ge_tl_grid_t* tl_grid)
+{
+  return tl_grid->tile_size;
+}
+
+size_t ge_tl_grid_get_num_cached_tiles(const ge_tl_grid_t* tl_grid)
+{
+  return tl_grid->num_slots;
+}
+
+uint64_t ge_tl_grid_get_generation(const ge_tl_grid_t* tl_grid)
+{
+  return tl_grid->generation;
+}
+
+bool ge_tl_grid_has_coord(const ge_tl_grid_t* tl_grid, ge_coord_t coord)
+{
+  return ge_coord_within(coord, tl_grid->width, tl_grid->height);
+}
+
+uint8_t ge_tl_grid_get_coord(ge_tl_grid_t* tl_grid, ge_coord_t coord)
+{
+  abort_on_coord_out_of_bounds(tl_grid, coord);
+  const size_t tile_size = tl_grid->tile_size;
+  const size_t tile_index = tl_grid->num_tiles_x * (coord.y / tile_size) + coord.x / tile_size;
+  const uint8_t* const tile_pixel_arr = ge_tl_grid_get_tile(tl_grid, tile_index, false);
+  return tile_pixel_arr[tile_size * (coord.y % tile_size) + coord.x % tile_size];
+}
+
+void ge_tl_grid_set_coord(ge_tl_grid_t* tl_grid, ge_coord_t coord, uint8_t value)
+{
+  abort_on_coord_out_of_bounds(tl_grid, coord);
+  const size_t tile_size = tl_grid->tile_size;
+  const size_t tile_index = tl_grid->num_tiles_x * (coord.y / tile_size) + coord.x / tile_size;
+  uint8_t* const tile_pixel_arr = ge_tl_grid_get_tile(tl_grid, tile_index, true);
+  tile_pixel_arr[tile_size * (coord.y % tile_size) + coord.x % tile_size] = value;
+  ++tl_grid->generation;
+}
+
+void ge_tl_grid_copy_rect(ge_tl_grid_t* tl_grid, ge_rect_t rect, ge_grid_t* grid,
+                          ge_coord_t coord)
+{
+  abort_on_rect_out_of_bounds(ge_tl_grid_get_rect(tl_grid), rect);
+  // Only copy the part of the rect which lands in the grid
+  const ge_rect_t shift_rect = ge_rect_add(ge_rect_sub(rect, rect.min_coord), coord);
+  const ge_rect_t overlap_rect = ge_rect_overlap(ge_grid_get_rect(grid), shift_rect);
+  if (overlap_rect.min_coord.x >= overlap_rect.max_coord.x
+      || overlap_rect.min_coord.y >= overlap_rect.max_coord.y) {
+    return;
+  }
+  const size_t width = ge_grid_get_width(grid);
+  uint8_t* const pixel_arr = ge_grid_get_pixel_arr_mut(grid)
+                             + (width * overlap_rect.min_coord.y + overlap_rect.min_coord.x);
+  const ge_rect_t tl_rect = ge_rect_add(ge_rect_sub(overlap_rect, coord), rect.min_coord);
+  ge_tl_grid_copy_tiles(tl_grid, tl_rect, pixel_arr, width, false);
+}
+
+void ge_tl_grid_blit_rect(ge_tl_grid_t* tl_grid, const ge_grid_t* blit_grid, ge_rect_t blit_rect,
+                          ge_coord_t coord)
+{
+  abort_on_rect_out_of_bounds(ge_grid_get_rect(blit_grid), blit_rect);
+  // Only blit the part of the rect which lands in the tiled grid
+  const ge_rect_t shift_rect = ge_rect_add(ge_rect_sub(blit_rect, blit_rect.min_coord), coord);
+  const ge_rect_t overlap_rect = ge_rect_overlap(ge_tl_grid_get_rect(tl_grid), shift_rect);
+  if (overlap_rect.min_coord.x >= overlap_rect.max_coord.x
+      || overlap_rect.min_coord.y >= overlap_rect.max_coord.y) {
+    return;
+  }
+  const size_t blit_width = ge_grid_get_width(blit_grid);
+  const ge_coord_t blit_corner =
+      ge_coord_add(ge_coord_sub(overlap_rect.min_coord, coord), blit_rect.min_coord);
+  // The pixels are only read, the cast just lets the copy share code with `ge_tl_grid_copy_rect`
+  uint8_t* const blit_pixel_arr = (uint8_t*) ge_grid_get_pixel_arr(blit_grid)
+                                  + (blit_width * blit_corner.y + blit_corner.x);
+  ge_tl_grid_copy_tiles(tl_grid, overlap_rect, blit_pixel_arr, blit_width, true);
+  ++tl_grid->generation;
+}
+
+void ge_tl_grid_prefetch_rect(ge_tl_grid_t* tl_grid, ge_rect_t rect)
+{
+  const ge_rect_t overlap_rect = ge_rect_overlap(ge_tl_grid_get_rect(tl_grid), rect);
+  if (overlap_rect.min_coord.x >= overlap_rect.max_coord.x
+      || overlap_rect.min_coord.y >= overlap_rect.max_coord.y) {
+    return;
+  }
+  const size_t tile_size = tl_grid->tile_size;
+  const size_t min_tile_x = overlap_rect.min_coord.x / tile_size;
+  const size_t min_tile_y = overlap_rect.min_coord.y / tile_size;
+  const size_t max_tile_x = (overlap_rect.max_coord.x - 1) / tile_size;
+  const size_t max_tile_y = (overlap_rect.max_coord.y - 1) / tile_size;
+  if ((max_tile_x - min_tile_x + 1) * (max_tile_y - min_tile_y + 1) > tl_grid->num_slots) {
+    return;
+  }
+  for (size_t jj = min_tile_y; jj <= max_tile_y; ++jj) {
+    for (size_t ii = min_tile_x; ii <= max_tile_x; ++ii) {
+      ge_tl_grid_get_tile(tl_grid, tl_grid->num_tiles_x * jj + ii, false);
+    }
+  }
+}
+
+static ge_tl_grid_t* ge_tl_grid_create_impl(SDL_RWops* rw, size_t width, size_t height,
+                                            size_t tile_size, size_t num_cached_tiles)
+{
+  ge_tl_grid_t* tl_grid = calloc(1, sizeof(ge_tl_grid_t));
+  if (tl_grid == NULL) {
+    SDL_RWclose(rw);
+    return NULL;
+  }
+  tl_grid->rw = rw;
+  tl_grid->width = width;
+  tl_grid->height = height;
+  tl_grid->tile_size = tile_size;
+  tl_grid->num_tiles_x = (width + tile_size - 1) / tile_size;
+  tl_grid->num_tiles_y = (height + tile_size - 1) / tile_size;
+  const size_t num_tiles = tl_grid->num_tiles_x * tl_grid->num_tiles_y;
+  tl_grid->slot_arr = calloc(num_cached_tiles, sizeof(ge_tl_grid_slot_t));
+  tl_grid->slot_pixel_arr = calloc(num_cached_tiles * tile_size * tile_size, sizeof(uint8_t));
+  tl_grid->tile_slot_arr = malloc((num_tiles != 0 ? num_tiles : 1) * sizeof(size_t));
+  if (tl_grid->slot_arr == NULL || tl_grid->slot_pixel_arr == NULL
+      || tl_grid->tile_slot_arr == NULL) {
+    ge_tl_grid_free(tl_grid);
+    return NULL;
+  }
+  tl_grid->num_slots = num_cached_tiles;
+  for (size_t ii = 0; ii < num_tiles; ++ii) {
+    tl_grid->tile_slot_arr[ii] = SIZE_MAX;
+  }
+  // All the slots start empty, linked in order
+  for (size_t ii = 0; ii < num_cached_tiles; ++ii) {
+    tl_grid->slot_arr[ii].tile_index = SIZE_MAX;
+    tl_grid->slot_arr[ii].prev_slot_index = (ii != 0 ? ii - 1 : SIZE_MAX);
+    tl_grid->slot_arr[ii].next_slot_index = (ii + 1 != num_cached_tiles ? ii + 1 : SIZE_MAX);
+  }
+  tl_grid->head_slot_index = 0;
+  tl_grid->tail_slot_index = num_cached_tiles - 1;
+  return tl_grid;
+}
+
+static uint8_t* ge_tl_grid_get_tile(ge_tl_grid_t* tl_grid, size_t tile_index, bool is_write)
+{
+  size_t slot_index = tl_grid->tile_slot_arr[tile_index];
+  if (slot_index == SIZE_MAX) {
+    // Evict the least recently used tile to make room
+    slot_index = tl_grid->tail_slot_index;
+    ge_tl_grid_slot_t* const slot = &tl_grid->slot_arr[slot_index];
+    if (slot->tile_index != SIZE_MAX) {
+      if (slot->is_dirty && !ge_tl_grid_write_slot(tl_grid, slot_index)) {
+        GE_LOG_ERROR("Failed to write tile! %zu: %s", slot->tile_index, SDL_GetError());
+        abort();
+      }
+      tl_grid->tile_slot_arr[slot->tile_index] = SIZE_MAX;
+    }
+    ge_tl_grid_read_slot(tl_grid, slot_index, tile_index);
+  }
+  ge_tl_grid_touch_slot(tl_grid, slot_index);
+  tl_grid->slot_arr[slot_index].is_dirty |= is_write;
+  return tl_grid->slot_pixel_arr + tl_grid->tile_size * tl_grid->tile_size * slot_index;
+}
+
+static void ge_tl_grid_touch_slot(ge_tl_grid_t* tl_grid, size_t slot_index)
+{
+  if (slot_index == tl_grid->head_slot_index) {
+    return;
+  }
+  // Unlink the slot, which has a previous slot since it isn't the head
+  ge_tl_grid_slot_t* const slot = &tl_grid->slot_arr[slot_index];
+  tl_grid->slot_arr[slot->prev_slot_index].next_slot_index = slot->next_slot_index;
+  if (slot->next_slot_index != SIZE_MAX) {
+    tl_grid->slot_arr[slot->next_slot_index].prev_slot_index = slot->prev_slot_index;
+  }
+  else {
+    tl_grid->tail_slot_index = slot->prev_slot_index;
+  }
+  // Link it back in as the head
+  slot->prev_slot_index = SIZE_MAX;
+  slot->next_slot_index = tl_grid->head_slot_index;
+  tl_grid->slot_arr[tl_grid->head_slot_index].prev_slot_index = slot_index;
+  tl_grid->head_slot_index = slot_index;
+}
+
+static void ge_tl_grid_read_slot(ge_tl_grid_t* tl_grid, size_t slot_index, size_t tile_index)
+{
+  const size_t tile_num_bytes = tl_grid->tile_size * tl_grid->tile_size;
+  uint8_t* const tile_pixel_arr = tl_grid->slot_pixel_arr + tile_num_bytes * slot_index;
+  const Sint64 offset = GE_TL_GRID_HEADER_SIZE + (Sint64) tile_num_bytes * tile_index;
+  if (SDL_RWseek(tl_grid->rw, offset, RW_SEEK_SET) < 0) {
+    GE_LOG_ERROR("Failed to read tile! %zu: %s", tile_index, SDL_GetError());
+    abort();
+  }
+  // The file may end early, if the last tiles were never written
+  const size_t num_bytes_read = SDL_RWread(tl_grid->rw, tile_pixel_arr, 1, tile_num_bytes);
+  memset(tile_pixel_arr + num_bytes_read, 0, tile_num_bytes - num_bytes_read);
+  tl_grid->slot_arr[slot_index].tile_index = tile_index;
+  tl_grid->slot_arr[slot_index].is_dirty = false;
+  tl_grid->tile_slot_arr[tile_index] = slot_index;
+}
+
+static bool ge_tl_grid_write_slot(ge_tl_grid_t* tl_grid, size_t slot_index)
+{
+  const size_t tile_num_bytes = tl_grid->tile_size * tl_grid->tile_size;
+  const uint8_t* const tile_pixel_arr = tl_grid->slot_pixel_arr + tile_num_bytes * slot_index;
+  const size_t tile_index = tl_grid->slot_arr[slot_index].tile_index;
+  const Sint64 offset = GE_TL_GRID_HEADER_SIZE + (Sint64) tile_num_bytes * tile_index;
+  if (SDL_RWseek(tl_grid->rw, offset, RW_SEEK_SET) < 0
+      || SDL_RWwrite(tl_grid->rw, tile_pixel_arr, 1, tile_num_bytes) != tile_num_bytes) {
+    return false;
+  }
+  tl_grid->slot_arr[slot_index].is_dirty = false;
+  return true;
+}
+
+static void ge_tl_grid_copy_tiles(ge_tl_grid_t* tl_grid, ge_rect_t rect, uint8_t* pixel_arr,
+                                  size_t stride, bool is_write)
+{
+  // Copy each tile's part of the rect in turn, so each tile is only looked up once
+  const size_t tile_size = tl_grid->tile_size;
+  const size_t min_tile_x = rect.min_coord.x / tile_size;
+  const size_t min_tile_y = rect.min_coord.y / tile_size;
+  const size_t max_tile_x = (rect.max_coord.x - 1) / tile_size;
+  const size_t max_tile_y = (rect.max_coord.y - 1) / tile_size;
+  for (size_t jj = min_tile_y; jj <= max_tile_y; ++jj) {
+    for (size_t ii = min_tile_x; ii <= max_tile_x; ++ii) {
+      const ge_coord_t tile_coord = {ii * tile_size, jj * tile_size};
+      const ge_rect_t tile_rect = ge_rect_from_coord_wh(tile_coord, tile_size, tile_size);
+      const ge_rect_t part_rect = ge_rect_overlap(tile_rect, rect);
+      const size_t part_width = ge_rect_get_width(part_rect);
+      const size_t part_height = ge_rect_get_height(part_rect);
+      uint8_t* const tile_pixel_arr =
+          ge_tl_grid_get_tile(tl_grid, tl_grid->num_tiles_x * jj + ii, is_write);
+      const ge_coord_t tile_offset = ge_coord_sub(part_rect.min_coord, tile_coord);
+      const ge_coord_t offset = ge_coord_sub(part_rect.min_coord, rect.min_coord);
+      for (size_t row = 0; row < part_height; ++row) {
+        uint8_t* const tile_pixel_row =
+            tile_pixel_arr + tile_size * (tile_offset.y + row) + tile_offset.x;
+        uint8_t* const pixel_row = pixel_arr + stride * (offset.y + row) + offset.x;
+        if (is_write) {
+          memcpy(tile_pixel_row, pixel_row, part_width);
+        }
+        else {
+          memcpy(pixel_row, tile_pixel_row, part_width);
+        }
+      }
+    }
+  }
+}
+
+static void write_u64_le(uint8_t* bytes, uint64_t value)
+{
+  for (size_t ii = 0; ii < 8; ++ii) {
+    bytes[ii] = (value >> (8 * ii)) & 0xFF;
+  }
+}
+
+static uint64_t read_u64_le(const uint8_t* bytes)
+{
+  uint64_t value = 0;
+  for (size_t ii = 0; ii < 8; ++ii) {
+    value |= (uint64_t) bytes[ii] << (8 * ii);
+  }
+  return value;
+}
+
+static void abort_on_zero_size(size_t size, const char* name)
+{
+  if (size == 0) {
+    GE_LOG_ERROR("%s must be greater than zero!", name);
+    abort();
+  }
+}
+
+static void abort_on_coord_out_of_bounds(const ge_tl_grid_t* tl_grid, ge_coord_t coord)
+{
+  if (!ge_tl_grid_has_coord(tl_grid, coord)) {
+    GE_LOG_ERROR("Coord is out of bounds! (%li, %li)", coord.x, coord.y);
+    abort();
+  }
+}
+
+static void abort_on_rect_out_of_bounds(ge_rect_t outer_rect, ge_rect_t rect)
+{
+  if (!ge_rect_within_rect(outer_rect, rect)) {
+    GE_LOG_ERROR("Rect is out of bounds! [(%li, %li), (%li, %li)]", rect.min_coord.x,
+                 rect.min_coord.y, rect.max_coord.x, rect.max_coord.y);
+    abort();
+  }
+}
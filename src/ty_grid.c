@@ -0,0 +1,438 @@
+// Copyright (c) 2021 Tim Perkins
+
+// Licensed under an MIT style license, see LICENSE.md for details.
+// You are free to copy and modify this code. Happy hacking!
+
+#include "grid_engine/ty_grid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_engine/log.h"
+
+typedef struct ge_ty_grid {
+  size_t width;
+  size_t height;
+  ge_ty_grid_type_t type;
+  size_t num_channels;
+  size_t pixel_size;
+  uint8_t* pixel_arr;
+  uint64_t generation;
+} ge_ty_grid_t;
+
+typedef struct ge_ty_grid_convert_data {
+  const ge_ty_grid_t* grid;
+  size_t channel;
+  // Each value becomes `(value - min_value) * scale + bias`, clamped to 0 through `max_level`
+  float min_value;
+  float scale;
+  float bias;
+  float max_level;
+  uint8_t* dest_pixel_arr;
+  size_t num_tasks;
+} ge_ty_grid_convert_data_t;
+
+static const size_t GE_TY_GRID_MIN_PARALLEL_NUM_PIXELS = 1 << 18;
+
+static void ge_ty_grid_run_convert(ge_ty_grid_convert_data_t* convert_data, ge_pool_t* pool,
+                                   ge_grid_t* dest_grid);
+static void ge_ty_grid_convert_task(size_t task_index, void* user_data);
+static size_t ge_ty_grid_get_value_size(ge_ty_grid_type_t type);
+static double ge_ty_grid_saturate(double value, double max_value);
+static void abort_on_invalid_num_channels(size_t num_channels);
+static void abort_on_channel_out_of_bounds(const ge_ty_grid_t* grid, size_t channel);
+static void abort_on_coord_out_of_bounds(const ge_ty_grid_t* grid, ge_coord_t coord);
+static void abort_on_rect_out_of_bounds(const ge_ty_grid_t* grid, ge_rect_t rect);
+static void abort_on_different_types(const ge_ty_grid_t* grid, const ge_ty_grid_t* other);
+static void abort_on_different_sizes(const ge_ty_grid_t* grid, const ge_grid_t* dest_grid);
+static void abort_on_invalid_num_levels(size_t num_levels);
+
+ge_ty_grid_t* ge_ty_grid_create(size_t width, size_t height, ge_ty_grid_type_t type,
+                                size_t num_channels)
+{
+  abort_on_invalid_num_channels(num_channels);
+  ge_ty_grid_t* grid = calloc(1, sizeof(ge_ty_grid_t));
+  if (grid == NULL) {
+    return NULL;
+  }
+  grid->width = width;
+  grid->height = height;
+  grid->type = type;
+  grid->num_channels = num_channels;
+  grid->pixel_size = ge_ty_grid_get_value_size(type) * num_channels;
+  // Zero bytes are zero for every type, including floats
+  grid->pixel_arr = calloc(grid->width * grid->height, grid->pixel_size);
+  if (grid->pixel_arr == NULL) {
+    free(grid);
+    return NULL;
+  }
+  return grid;
+}
+
+void ge_ty_grid_free(ge_ty_grid_t* grid)
+{
+  if (grid == NULL) {
+    return;
+  }
+  free(grid->pixel_arr);
+  free(grid);
+}
+
+size_t ge_ty_grid_get_width(const ge_ty_grid_t* grid)
+{
+  return grid->width;
+}
+
+size_t ge_ty_grid_get_height(const ge_ty_grid_t* grid)
+{
+  return grid->height;
+}
+
+ge_rect_t ge_ty_grid_get_rect(const ge_ty_grid_t* grid)
+{
+  return ge_rect_from_wh(grid->width, grid->height);
+}
+
+ge_ty_grid_type_t ge_ty_grid_get_type(const ge_ty_grid_t* grid)
+{
+  return grid->type;
+}
+
+size_t ge_ty_grid_get_num_channels(const ge_ty_grid_t* grid)
+{
+  return grid->num_channels;
+}
+
+size_t ge_ty_grid_get_pixel_size(const ge_ty_grid_t* grid)
+{
+  return grid->pixel_size;
+}
+
+const void* ge_ty_grid_get_pixel_arr(const ge_ty_grid_t* grid)
+{
+  return grid->pixel_arr;
+}
+
+void* ge_ty_grid_get_pixel_arr_mut(ge_ty_grid_t* grid)
+{
+  // The caller could change anything
+  ++grid->generation;
+  return grid->pixel_arr;
+}
+
+void ge_ty_grid_clear_pixel_arr(ge_ty_grid_t* grid)
+{
+  memset(grid->pixel_arr, 0, grid->width * grid->height * grid->pixel_size);
+  ++grid->generation;
+}
+
+uint64_t ge_ty_grid_get_generation(const ge_ty_grid_t* grid)
+{
+  return grid->generation;
+}
+
+bool ge_ty_grid_has_coord(const ge_ty_grid_t* grid, ge_coord_t coord)
+{
+  return ge_coord_within(coord, grid->width, grid->height);
+}
+
+double ge_ty_grid_get_coord(const ge_ty_grid_t* grid, ge_coord_t coord, size_t channel)
+{
+  abort_on_coord_out_of_bounds(grid, coord);
+  abort_on_channel_out_of_bounds(grid, channel);
+  const size_t index = grid->num_channels * (grid->width * coord.y + coord.x) + channel;
+  switch (grid->type) {
+  case GE_TY_GRID_TYPE_U8:
+    return grid->pixel_arr[index];
+  case GE_TY_GRID_TYPE_U16:
+    return ((const uint16_t*) grid->pixel_arr)[index];
+  default:
+    return ((const float*) grid->pixel_arr)[index];
+  }
+}
+
+void ge_ty_grid_set_coord(ge_ty_grid_t* grid, ge_coord_t coord, size_t channel, double value)
+{
+  abort_on_coord_out_of_bounds(grid, coord);
+  abort_on_channel_out_of_bounds(grid, channel);
+  const size_t index = grid->num_channels * (grid->width * coord.y + coord.x) + channel;
+  switch (grid->type) {
+  case GE_TY_GRID_TYPE_U8:
+    grid->pixel_arr[index] = ge_ty_grid_saturate(value, UINT8_MAX);
+    break;
+  case GE_TY_GRID_TYPE_U16:
+    ((uint16_t*) grid->pixel_arr)[index] = ge_ty_grid_saturate(value, UINT16_MAX);
+    break;
+  default:
+    ((float*) grid->pixel_arr)[index] = value;
+    break;
+  }
+  ++grid->generation;
+}
+
+ge_ty_grid_t* ge_ty_grid_copy_rect(const ge_ty_grid_t* grid, ge_rect_t rect)
+{
+  abort_on_rect_out_of_bounds(grid, rect);
+  const size_t width = ge_rect_get_width(rect);
+  const size_t height = ge_rect_get_height(rect);
+  ge_ty_grid_t* const copy_grid = ge_ty_grid_create(width, height, grid->type, grid->num_channels);
+  if (copy_grid == NULL) {
+    return NULL;
+  }
+  const size_t pixel_size = grid->pixel_size;
+  for (size_t jj = 0; jj < height; ++jj) {
+    uint8_t* const dest_pixel_row = copy_grid->pixel_arr + pixel_size * (width * jj);
+    const uint8_t* const src_pixel_row =
+        (grid->pixel_arr
+         + pixel_size * (grid->width * (jj + rect.min_coord.y) + rect.min_coord.x));
+    memcpy(dest_pixel_row, src_pixel_row, pixel_size * width);
+  }
+  return copy_grid;
+}
+
+void ge_ty_grid_blit(ge_ty_grid_t* grid, const ge_ty_grid_t* blit_grid, ge_coord_t coord)
+{
+  abort_on_different_types(grid, blit_grid);
+  // Get rect overlapping the grid
+  const ge_rect_t grid_rect = ge_ty_grid_get_rect(grid);
+  const ge_rect_t shift_rect = ge_rect_add(ge_ty_grid_get_rect(blit_grid), coord);
+  const ge_rect_t overlap_rect = ge_rect_overlap(grid_rect, shift_rect);
+  const ge_rect_t blit_rect = ge_rect_sub(overlap_rect, coord);
+  const size_t blit_width = ge_rect_get_width(blit_rect);
+  const size_t blit_height = ge_rect_get_height(blit_rect);
+  const size_t pixel_size = grid->pixel_size;
+  for (size_t jj = 0; jj < blit_height; ++jj) {
+    uint8_t* const dest_pixel_row =
+        (grid->pixel_arr
+         + pixel_size
+               * (grid->width * (jj + overlap_rect.min_coord.y) + overlap_rect.min_coord.x));
+    const uint8_t* const src_pixel_row =
+        (blit_grid->pixel_arr
+         + pixel_size
+               * (blit_grid->width * (jj + blit_rect.min_coord.y) + blit_rect.min_coord.x));
+    memcpy(dest_pixel_row, src_pixel_row, pixel_size * blit_width);
+  }
+  ++grid->generation;
+}
+
+void ge_ty_grid_get_range(const ge_ty_grid_t* grid, size_t channel, double* min_value,
+                          double* max_value)
+{
+  abort_on_channel_out_of_bounds(grid, channel);
+  const size_t num_pixels = grid->width * grid->height;
+  bool is_found = false;
+  double found_min_value = 0.0;
+  double found_max_value = 0.0;
+  for (size_t ii = 0; ii < num_pixels; ++ii) {
+    const size_t index = grid->num_channels * ii + channel;
+    double value;
+    switch (grid->type) {
+    case GE_TY_GRID_TYPE_U8:
+      value = grid->pixel_arr[index];
+      break;
+    case GE_TY_GRID_TYPE_U16:
+      value = ((const uint16_t*) grid->pixel_arr)[index];
+      break;
+    default:
+      value = ((const float*) grid->pixel_arr)[index];
+      break;
+    }
+    // NaN is the only value which isn't equal to itself
+    if (value != value) {
+      continue;
+    }
+    found_min_value = (!is_found || value < found_min_value ? value : found_min_value);
+    found_max_value = (!is_found || value > found_max_value ? value : found_max_value);
+    is_found = true;
+  }
+  *min_value = found_min_value;
+  *max_value = found_max_value;
+}
+
+void ge_ty_grid_normalize(const ge_ty_grid_t* grid, size_t channel, double min_value,
+                          double max_value, ge_pool_t* pool, ge_grid_t* dest_grid)
+{
+  // An empty or backwards range would divide by zero, so everything becomes zero instead
+  const double range = max_value - min_value;
+  ge_ty_grid_convert_data_t convert_data = {
+      .grid = grid,
+      .channel = channel,
+      .min_value = min_value,
+      .scale = (range > 0.0 ? 255.0 / range : 0.0),
+      .bias = 0.5f,
+      .max_level = 255.0f,
+  };
+  ge_ty_grid_run_convert(&convert_data, pool, dest_grid);
+}
+
+void ge_ty_grid_quantize(const ge_ty_grid_t* grid, size_t channel, double min_value,
+                         double max_value, size_t num_levels, ge_pool_t* pool,
+                         ge_grid_t* dest_grid)
+{
+  abort_on_invalid_num_levels(num_levels);
+  const double range = max_value - min_value;
+  ge_ty_grid_convert_data_t convert_data = {
+      .grid = grid,
+      .channel = channel,
+      .min_value = min_value,
+      .scale = (range > 0.0 ? num_levels / range : 0.0),
+      .bias = 0.0f,
+      .max_level = num_levels - 1,
+  };
+  ge_ty_grid_run_convert(&convert_data, pool, dest_grid);
+}
+
+void ge_ty_grid_clamp(const ge_ty_grid_t* grid, size_t channel, ge_pool_t* pool,
+                      ge_grid_t* dest_grid)
+{
+  ge_ty_grid_convert_data_t convert_data = {
+      .grid = grid,
+      .channel = channel,
+      .min_value = 0.0f,
+      .scale = 1.0f,
+      .bias = 0.5f,
+      .max_level = 255.0f,
+  };
+  ge_ty_grid_run_convert(&convert_data, pool, dest_grid);
+}
+
+static void ge_ty_grid_run_convert(ge_ty_grid_convert_data_t* convert_data, ge_pool_t* pool,
+                                   ge_grid_t* dest_grid)
+{
+  const ge_ty_grid_t* const grid = convert_data->grid;
+  abort_on_channel_out_of_bounds(grid, convert_data->channel);
+  abort_on_different_sizes(grid, dest_grid);
+  convert_data->dest_pixel_arr = ge_grid_get_pixel_arr_mut(dest_grid);
+  const size_t num_pixels = grid->width * grid->height;
+  const bool is_parallel = (pool != NULL && num_pixels >= GE_TY_GRID_MIN_PARALLEL_NUM_PIXELS);
+  convert_data->num_tasks = (is_parallel ? 4 * (ge_pool_get_num_workers(pool) + 1) : 1);
+  ge_pool_run((is_parallel ? pool : NULL), ge_ty_grid_convert_task, convert_data,
+              convert_data->num_tasks);
+}
+
+static void ge_ty_grid_convert_task(size_t task_index, void* user_data)
+{
+  const ge_ty_grid_convert_data_t* const convert_data = user_data;
+  const ge_ty_grid_t* const grid = convert_data->grid;
+  const size_t width = grid->width;
+  const size_t num_channels = grid->num_channels;
+  const size_t begin_y = grid->height * task_index / convert_data->num_tasks;
+  const size_t end_y = grid->height * (task_index + 1) / convert_data->num_tasks;
+  const float min_value = convert_data->min_value;
+  const float scale = convert_data->scale;
+  const float bias = convert_data->bias;
+  const float max_level = convert_data->max_level;
+  for (size_t jj = begin_y; jj < end_y; ++jj) {
+    const size_t begin_index = num_channels * (width * jj) + convert_data->channel;
+    uint8_t* const dest_row = convert_data->dest_pixel_arr + width * jj;
+    // The conversion is branchless, so each loop can be vectorized, and NaN fails both compares
+    switch (grid->type) {
+    case GE_TY_GRID_TYPE_U8: {
+      const uint8_t* const row = grid->pixel_arr + begin_index;
+      for (size_t ii = 0; ii < width; ++ii) {
+        float value = (row[num_channels * ii] - min_value) * scale + bias;
+        value = (value > 0.0f ? value : 0.0f);
+        dest_row[ii] = (value < max_level ? value : max_level);
+      }
+      break;
+    }
+    case GE_TY_GRID_TYPE_U16: {
+      const uint16_t* const row = (const uint16_t*) grid->pixel_arr + begin_index;
+      for (size_t ii = 0; ii < width; ++ii) {
+        float value = (row[num_channels * ii] - min_value) * scale + bias;
+        value = (value > 0.0f ? value : 0.0f);
+        dest_row[ii] = (value < max_level ? value : max_level);
+      }
+      break;
+    }
+    default: {
+      const float* const row = (const float*) grid->pixel_arr + begin_index;
+      for (size_t ii = 0; ii < width; ++ii) {
+        float value = (row[num_channels * ii] - min_value) * scale + bias;
+        value = (value > 0.0f ? value : 0.0f);
+        dest_row[ii] = (value < max_level ? value : max_level);
+      }
+      break;
+    }
+    }
+  }
+}
+
+static size_t ge_ty_grid_get_value_size(ge_ty_grid_type_t type)
+{
+  switch (type) {
+  case GE_TY_GRID_TYPE_U8:
+    return sizeof(uint8_t);
+  case GE_TY_GRID_TYPE_U16:
+    return sizeof(uint16_t);
+  default:
+    return sizeof(float);
+  }
+}
+
+static double ge_ty_grid_saturate(double value, double max_value)
+{
+  // Round first, so values just below zero or just above the max still saturate
+  value += 0.5;
+  value = (value > 0.0 ? value : 0.0);
+  return (value < max_value ? value : max_value);
+}
+
+static void abort_on_invalid_num_channels(size_t num_channels)
+{
+  if (num_channels == 0 || num_channels > GE_TY_GRID_MAX_NUM_CHANNELS) {
+    GE_LOG_ERROR("Typed grid number of channels is invalid! %zu", num_channels);
+    abort();
+  }
+}
+
+static void abort_on_channel_out_of_bounds(const ge_ty_grid_t* grid, size_t channel)
+{
+  if (channel >= grid->num_channels) {
+    GE_LOG_ERROR("Typed grid channel is out of bounds! %zu", channel);
+    abort();
+  }
+}
+
+static void abort_on_coord_out_of_bounds(const ge_ty_grid_t* grid, ge_coord_t coord)
+{
+  if (!ge_ty_grid_has_coord(grid, coord)) {
+    GE_LOG_ERROR("Coord is out of bounds! (%li, %li)", coord.x, coord.y);
+    abort();
+  }
+}
+
+static void abort_on_rect_out_of_bounds(const ge_ty_grid_t* grid, ge_rect_t rect)
+{
+  const ge_rect_t grid_rect = ge_ty_grid_get_rect(grid);
+  if (!ge_rect_within_rect(grid_rect, rect)) {
+    GE_LOG_ERROR("Rect is out of bounds! [(%li, %li), (%li, %li)]", rect.min_coord.x,
+                 rect.min_coord.y, rect.max_coord.x, rect.max_coord.y);
+    abort();
+  }
+}
+
+static void abort_on_different_types(const ge_ty_grid_t* grid, const ge_ty_grid_t* other)
+{
+  if (grid->type != other->type || grid->num_channels != other->num_channels) {
+    GE_LOG_ERROR("Typed grids have different types or numbers of channels!");
+    abort();
+  }
+}
+
+static void abort_on_different_sizes(const ge_ty_grid_t* grid, const ge_grid_t* dest_grid)
+{
+  if (grid->width != ge_grid_get_width(dest_grid)
+      || grid->height != ge_grid_get_height(dest_grid)) {
+    GE_LOG_ERROR("Typed grid and grid are different sizes!");
+    abort();
+  }
+}
+
+static void abort_on_invalid_num_levels(size_t num_levels)
+{
+  if (num_levels == 0 || num_levels > 256) {
+    GE_LOG_ERROR("Typed grid number of levels is invalid! %zu", num_levels);
+    abort();
+  }
+}